@@ -0,0 +1,181 @@
+#include "gnss2map/batch_projection.hpp"
+#include "gnss2map/fix_covariance_model.hpp"
+#include "gnss2map/utm_projection.hpp"
+
+#include <benchmark/benchmark.h>
+#include <geodesy/utm.h>
+#include <geographic_msgs/msg/geo_point.hpp>
+#include <sensor_msgs/msg/nav_sat_fix.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// lat/lon -> map conversion as done in Gnss_to_map::pose_callback. The track is a
+// 10 Hz drive around Seoul, so consecutive fixes stay in one zone and grid square
+// like they do on the vehicle; a separate case crosses the zone boundary every fix.
+
+namespace
+{
+
+constexpr std::size_t kTrackLength = 4096;
+
+struct Track
+{
+    std::vector<double> latitude;
+    std::vector<double> longitude;
+    std::vector<double> altitude;
+};
+
+Track make_track(double latitude, double longitude, double step_deg)
+{
+    Track track;
+    for (std::size_t i = 0; i < kTrackLength; ++i) {
+        const double s = static_cast<double>(i);
+        track.latitude.push_back(latitude + step_deg * s * 0.6);
+        track.longitude.push_back(longitude + step_deg * s * 0.8);
+        track.altitude.push_back(40.0 + 0.01 * s);
+    }
+    return track;
+}
+
+// Per-fix geodesy conversion the node used before UtmProjection
+void BM_GeodesyFromMsg(benchmark::State & state)
+{
+    const Track track = make_track(37.5665, 126.9780, 1e-6);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        geographic_msgs::msg::GeoPoint point;
+        point.latitude = track.latitude[i];
+        point.longitude = track.longitude[i];
+        point.altitude = track.altitude[i];
+        geodesy::UTMPoint utm;
+        geodesy::fromMsg(point, utm);
+        benchmark::DoNotOptimize(std::fmod(utm.easting, 100000.0));
+        benchmark::DoNotOptimize(std::fmod(utm.northing, 100000.0));
+        i = (i + 1) % kTrackLength;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GeodesyFromMsg);
+
+void BM_UtmProjectionToMap(benchmark::State & state)
+{
+    const Track track = make_track(37.5665, 126.9780, 1e-6);
+    UtmProjection projection;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        double x;
+        double y;
+        projection.to_map(track.latitude[i], track.longitude[i], x, y);
+        benchmark::DoNotOptimize(x);
+        benchmark::DoNotOptimize(y);
+        i = (i + 1) % kTrackLength;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UtmProjectionToMap);
+
+// Worst case for the caches: alternating between zones 51 and 52 on every fix
+void BM_UtmProjectionZoneChange(benchmark::State & state)
+{
+    UtmProjection projection;
+    bool east = false;
+    for (auto _ : state) {
+        double x;
+        double y;
+        projection.to_map(37.5, east ? 126.01 : 125.99, x, y);
+        benchmark::DoNotOptimize(x);
+        benchmark::DoNotOptimize(y);
+        east = !east;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UtmProjectionZoneChange);
+
+// range(0): samples per call
+void BM_BatchProjectToMap(benchmark::State & state)
+{
+    const std::size_t count = static_cast<std::size_t>(state.range(0));
+    const Track track = make_track(37.5665, 126.9780, 1e-6);
+    std::vector<double> latitude(count);
+    std::vector<double> longitude(count);
+    std::vector<double> altitude(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        latitude[i] = track.latitude[i % kTrackLength];
+        longitude[i] = track.longitude[i % kTrackLength];
+        altitude[i] = track.altitude[i % kTrackLength];
+    }
+    std::vector<double> x(count);
+    std::vector<double> y(count);
+    std::vector<double> z(count);
+
+    for (auto _ : state) {
+        batch_project_to_map(latitude.data(), longitude.data(), altitude.data(), count, x.data(), y.data(), z.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    state.SetLabel(batch_projection_isa());
+}
+BENCHMARK(BM_BatchProjectToMap)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+// Checked before the benchmarks run: FixCovarianceModel has to rotate a covariance along
+// true north onto the grid direction of a finite-difference north step. Far from the
+// central meridian (lat 60, lon 16, zone 33: gamma about 0.87 deg) a wrong convergence
+// sign shows up in the off-diagonal term.
+bool north_step_matches_projection()
+{
+    const double latitude = 60.0;
+    const double longitude = 16.0;
+    const int zone = UtmProjection::zone_for(latitude, longitude);
+
+    UtmProjection projection;
+    double easting0;
+    double northing0;
+    double easting1;
+    double northing1;
+    projection.project(latitude, longitude, easting0, northing0);
+    projection.project(latitude + 1e-4, longitude, easting1, northing1);
+    const double length = std::hypot(easting1 - easting0, northing1 - northing0);
+    const double east = (easting1 - easting0) / length;
+    const double north = (northing1 - northing0) / length;
+
+    FixCovarianceModel model;
+    const FixCovarianceModel::StatusModel status{1.0, 1.0, 1.0};
+    model.configure({status, status, status, status}, 0.0, 1.0, 0.0);
+    sensor_msgs::msg::NavSatFix fix;
+    fix.status.status = sensor_msgs::msg::NavSatStatus::STATUS_FIX;
+    fix.latitude = latitude;
+    fix.longitude = longitude;
+    fix.position_covariance_type = sensor_msgs::msg::NavSatFix::COVARIANCE_TYPE_KNOWN;
+    fix.position_covariance = {0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0};
+    std::array<double, 36> covariance;
+    if (!model.covariance(fix, zone, covariance)) {
+        return false;
+    }
+
+    // Unit variance along the projected step: d d^T
+    const double tolerance = 1e-6;
+    return std::abs(covariance[0] - east * east) < tolerance &&
+           std::abs(covariance[1] - east * north) < tolerance &&
+           std::abs(covariance[7] - north * north) < tolerance;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+    if (!north_step_matches_projection()) {
+        std::fprintf(stderr, "FixCovarianceModel: ENU -> grid rotation does not match the projection\n");
+        return 1;
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef GNSS2MAP__BATCH_PROJECTION_HPP_
+#define GNSS2MAP__BATCH_PROJECTION_HPP_
+
+#include <cstddef>
+
+// Batch lat/lon/alt -> map-frame conversion for offline log processing.
+//
+// Inputs and outputs are structure-of-arrays spans of length count, in degrees and
+// meters. The result is the same map frame Gnss_to_map publishes: UTM easting and
+// northing modulo the MGRS 100 km grid (fmod(utm, UTM2MGRS)), altitude passed through.
+// Every sample is projected in its own UTM zone, exactly as the live node does.
+//
+// The transcendental functions are evaluated per sample with libm; the Krueger series
+// summation and the grid reduction run with AVX2 (x86-64, selected at run time) or
+// NEON (AArch64). Both paths use the same operation order without FMA contraction, so
+// results are bit-identical to UtmProjection::to_map and therefore to the node output.
+void batch_project_to_map(
+    const double * latitude, const double * longitude, const double * altitude, std::size_t count,
+    double * x, double * y, double * z);
+
+// SIMD path used on this machine: "avx2", "neon" or "scalar"
+const char * batch_projection_isa();
+
+// C entry point of batch_project_to_map for loading libgnss2map_projection.so from
+// Python (ctypes/numpy) without going through per-sample geodesy calls
+extern "C" void gnss2map_batch_project_to_map(
+    const double * latitude, const double * longitude, const double * altitude, std::size_t count,
+    double * x, double * y, double * z);
+
+#endif  // GNSS2MAP__BATCH_PROJECTION_HPP_
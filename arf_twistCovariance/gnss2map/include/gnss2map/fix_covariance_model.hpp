@@ -0,0 +1,150 @@
+#ifndef GNSS2MAP__FIX_COVARIANCE_MODEL_HPP_
+#define GNSS2MAP__FIX_COVARIANCE_MODEL_HPP_
+
+#include <sensor_msgs/msg/nav_sat_fix.hpp>
+#include <sensor_msgs/msg/nav_sat_status.hpp>
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include "gnss2map/utm_projection.hpp"
+
+// 6x6 map-frame pose covariance of a NavSatFix, row-major [x, y, z, roll, pitch, yaw].
+//
+// Per fix status (NavSatStatus: no fix, single, SBAS, GBAS) a lookup table built in
+// configure() holds the variances used when the receiver reports no covariance and the
+// scale applied to a reported one. NavSatStatus has no RTK states: receivers report RTK
+// fixed, RTK float and DGPS all as GBAS, so within GBAS the reported covariance is what
+// tells them apart.
+//
+// The reported ENU covariance is rotated into the UTM grid axes of the map frame by the
+// meridian convergence, which changes by well under a degree per kilometre, so the
+// rotation is cached and only recomputed once the fix moved about a kilometre or changed
+// zone. A fix carries no attitude, so the lever arm cannot be rotated into the map frame;
+// its horizontal length enters as an isotropic horizontal variance instead. Not
+// thread-safe.
+class FixCovarianceModel
+{
+public:
+    struct StatusModel
+    {
+        double horizontal_sigma;  // [m], used when the covariance is unknown
+        double vertical_sigma;    // [m], used when the covariance is unknown
+        double scale;             // multiplies a reported covariance
+    };
+
+    // Index of a NavSatStatus status in the table
+    static constexpr std::size_t kStatusCount = 4;
+    static std::size_t status_index(int8_t status)
+    {
+        return static_cast<std::size_t>(std::min<int>(std::max<int>(status + 1, 0), kStatusCount - 1));
+    }
+
+    // models: indexed by status_index. min_sigma [m] floors every position axis,
+    // orientation_sigma [rad] is the (unobserved) attitude uncertainty.
+    void configure(
+        const std::array<StatusModel, kStatusCount> & models, double min_sigma, double orientation_sigma,
+        double lever_arm_length)
+    {
+        for (std::size_t i = 0; i < kStatusCount; ++i) {
+            Entry & entry = table_[i];
+            entry.horizontal_variance = models[i].horizontal_sigma * models[i].horizontal_sigma;
+            entry.vertical_variance = models[i].vertical_sigma * models[i].vertical_sigma;
+            entry.scale = models[i].scale;
+        }
+        min_variance_ = min_sigma * min_sigma;
+        orientation_variance_ = orientation_sigma * orientation_sigma;
+        set_lever_arm_length(lever_arm_length);
+        rotation_cached_ = false;
+    }
+
+    // A lever arm of length L in an unknown horizontal direction adds L^2 / 2 per axis
+    void set_lever_arm_length(double length) { lever_arm_variance_ = 0.5 * length * length; }
+
+    // False for a fix without position (STATUS_NO_FIX)
+    bool covariance(const sensor_msgs::msg::NavSatFix & fix, int zone, std::array<double, 36> & out)
+    {
+        if (fix.status.status < sensor_msgs::msg::NavSatStatus::STATUS_FIX) {
+            return false;
+        }
+        const Entry & entry = table_[status_index(fix.status.status)];
+
+        Eigen::Matrix3d position;
+        if (fix.position_covariance_type == sensor_msgs::msg::NavSatFix::COVARIANCE_TYPE_UNKNOWN) {
+            // Isotropic horizontally, so no rotation needed
+            position = Eigen::Vector3d(entry.horizontal_variance, entry.horizontal_variance, entry.vertical_variance).asDiagonal();
+        } else {
+            const Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> enu(fix.position_covariance.data());
+            const Eigen::Matrix3d & rotation = enu_to_map(fix.latitude, fix.longitude, zone);
+            position = entry.scale * (rotation * enu * rotation.transpose());
+        }
+        position(0, 0) += lever_arm_variance_;
+        position(1, 1) += lever_arm_variance_;
+        for (int i = 0; i < 3; ++i) {
+            position(i, i) = std::max(position(i, i), min_variance_);
+        }
+
+        out.fill(0.0);
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                out[row * 6 + col] = position(row, col);
+            }
+            out[(row + 3) * 7] = orientation_variance_;
+        }
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        double horizontal_variance = 1.0;
+        double vertical_variance = 1.0;
+        double scale = 1.0;
+    };
+
+    // The cached rotation is reused within this distance [deg] of its fix
+    static constexpr double kRotationReuseDegrees = 0.01;
+
+    // ENU -> UTM grid (x: easting, y: northing): a rotation by the meridian convergence
+    // gamma = atan(tan(lon - lon0) sin(lat)). East of the central meridian (gamma > 0) grid
+    // north lies east of true north, so a true-north step gets a negative easting.
+    const Eigen::Matrix3d & enu_to_map(double latitude, double longitude, int zone)
+    {
+        if (rotation_cached_ && zone == rotation_zone_ &&
+            std::abs(latitude - rotation_latitude_) < kRotationReuseDegrees &&
+            std::abs(longitude - rotation_longitude_) < kRotationReuseDegrees)
+        {
+            return rotation_;
+        }
+
+        const double delta_lon = longitude * utm_kernel::kDegToRad - UtmProjection::central_meridian_rad(zone);
+        const double gamma = std::atan(std::tan(delta_lon) * std::sin(latitude * utm_kernel::kDegToRad));
+        const double c = std::cos(gamma);
+        const double s = std::sin(gamma);
+        rotation_ << c, -s, 0.0,
+            s, c, 0.0,
+            0.0, 0.0, 1.0;
+        rotation_cached_ = true;
+        rotation_zone_ = zone;
+        rotation_latitude_ = latitude;
+        rotation_longitude_ = longitude;
+        return rotation_;
+    }
+
+    std::array<Entry, kStatusCount> table_;
+    double min_variance_ = 0.0;
+    double orientation_variance_ = 1.0;
+    double lever_arm_variance_ = 0.0;
+
+    Eigen::Matrix3d rotation_{Eigen::Matrix3d::Identity()};
+    bool rotation_cached_{false};
+    int rotation_zone_{0};
+    double rotation_latitude_{0.0};
+    double rotation_longitude_{0.0};
+};
+
+#endif  // GNSS2MAP__FIX_COVARIANCE_MODEL_HPP_
@@ -2,6 +2,7 @@
 #define GNSS_TO_MAP_HPP_
 
 #include "rclcpp/rclcpp.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
 
 #include <memory>
 #include <geographic_msgs/msg/geo_point.hpp>
@@ -16,29 +17,128 @@
 #include "tf2_ros/buffer.h"
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 
+#include <Eigen/Geometry>
+
 #include "math.h"
 
+#include "gnss2map/fix_covariance_model.hpp"
+#include "gnss2map/gnss_pose_projector.hpp"
+
+#include <localization_common/allocation_guard.hpp>
+#include <localization_common/config_buffer.hpp>
+#include <localization_common/latency_monitor.hpp>
+#include <localization_common/lifecycle.hpp>
+#include <localization_common/message_publisher.hpp>
+#include <localization_common/qos_profiles.hpp>
+#include <localization_common/state_file.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #define UTM2MGRS 100000
 
-class Gnss_to_map : public rclcpp::Node
+// Lifecycle node: on_configure reads the parameters, restores the state file and creates the
+// publisher message, the subscription and the TF buffer and listener, whose lookup timer
+// already runs while inactive, so the lever arm can be cached before activation. Fixes are
+// only projected while active, without heap allocation (AllocationGuard). With autostart
+// (default) the constructor runs configure and activate itself.
+class Gnss_to_map : public rclcpp_lifecycle::LifecycleNode
 {
 public:
-    explicit Gnss_to_map();
+    explicit Gnss_to_map(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+    LifecycleCallbackReturn on_configure(const rclcpp_lifecycle::State & state) override;
+    LifecycleCallbackReturn on_activate(const rclcpp_lifecycle::State & state) override;
+    LifecycleCallbackReturn on_deactivate(const rclcpp_lifecycle::State & state) override;
+    LifecycleCallbackReturn on_cleanup(const rclcpp_lifecycle::State & state) override;
+    LifecycleCallbackReturn on_shutdown(const rclcpp_lifecycle::State & state) override;
 
 private:
+    // Writes a pending lever arm and drops everything on_configure created
+    void release();
+
     void pose_callback(const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr navsat_msg);
+    // input_type "navsat_fix": covariance from the fix status and the reported ENU covariance
+    void fix_callback(const sensor_msgs::msg::NavSatFix::ConstSharedPtr fix_msg);
+    // Logs a zone change and keeps the state file in step with the map frame
+    void update_map_frame(bool zone_changed);
+
+    // Looks up gnss_frame -> base_frame until the static transform is available, then
+    // caches it and stops polling (optionally releasing the TF listener as well)
+    void cache_antenna_transform();
 
+    // Runtime changes of target_frame, gnss_frame and base_frame: validated and published
+    // as one set by the parameter callback, taken up by apply_frames() at the start of the
+    // next callback
+    rcl_interfaces::msg::SetParametersResult on_set_parameters(const std::vector<rclcpp::Parameter> & parameters);
+    void apply_frames();
+
+    // Warm-start record of the state file: map frame (zone and grid square) and lever arm
+    struct PersistedState
+    {
+        int32_t zone;
+        int32_t northern;
+        double grid_origin_easting;
+        double grid_origin_northing;
+        int32_t antenna_to_base_valid;
+        int32_t reserved;
+        std::array<double, 7> antenna_to_base;  // x, y, z, qx, qy, qz, qw
+    };
+    static constexpr uint32_t kStateVersion = 1;
+
+    // Restores the lever arm, so fixes are moved to base_frame before TF is available
+    void restore_state();
+    void write_state();
+
+    // Set by on_activate, cleared by on_deactivate; the subscription drops fixes without it
+    std::atomic<bool> active_{false};
+
+    // One of the two is created, depending on input_type
     rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr fix_sub_;
-    rclcpp::Publisher<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr map_pose_pub_;
-    
-    geometry_msgs::msg::PoseWithCovarianceStamped gnss2map_msg;
-    geometry_msgs::msg::PoseWithCovarianceStamped gnss_msg;
+    rclcpp::Subscription<sensor_msgs::msg::NavSatFix>::SharedPtr navsat_sub_;
+    FixCovarianceModel covariance_model_;
+    MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped> map_pose_pub_;
 
     std::shared_ptr<tf2_ros::TransformListener> tf_listener_{nullptr};
     std::unique_ptr<tf2_ros::Buffer> tf_buffer_;
+    rclcpp::TimerBase::SharedPtr tf_lookup_timer_;
+
+    struct Frames
+    {
+        std::string target_frame;
+        std::string gnss_frame;
+        std::string base_frame;
+        // Bumped by the parameter callback when target_frame, or gnss_frame / base_frame changed
+        uint32_t target_revision{0};
+        uint32_t antenna_revision{0};
+    };
+    ConfigBuffer<Frames> frames_;
+    // Parameter callback's copy of the last published set
+    Frames requested_frames_;
+    uint32_t applied_target_revision_{0};
+    uint32_t applied_antenna_revision_{0};
+    rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr parameter_callback_;
+    bool drop_tf_listener;
+
+    // UTM projection and antenna lever arm (pose of base_frame expressed in gnss_frame)
+    GnssPoseProjector projector_;
+    // false while the lever arm is the restored one (TF is still polled)
+    bool antenna_from_tf_{false};
+
+    // Warm start (state_file); written only when the map frame or the lever arm changes
+    MappedStateFile<PersistedState> state_file_;
+    PersistedState saved_state_{};
+    bool saved_state_valid_{false};
+    bool state_dirty_{false};  // lever arm changed since the last write
+    bool first_fix_{true};
 
-    std::string target_frame;
-    std::string gnss_frame;
+    // Callback timing published on /diagnostics
+    std::unique_ptr<LatencyMonitor> latency_monitor_;
+    CallbackStatistics * fix_statistics_{nullptr};
+    EventCounter * no_fix_{nullptr};
 };
 
 
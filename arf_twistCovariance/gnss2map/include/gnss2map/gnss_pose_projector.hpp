@@ -0,0 +1,99 @@
+#ifndef GNSS2MAP__GNSS_POSE_PROJECTOR_HPP_
+#define GNSS2MAP__GNSS_POSE_PROJECTOR_HPP_
+
+#include <geometry_msgs/msg/pose_with_covariance.hpp>
+
+#include <Eigen/Geometry>
+
+#include "gnss2map/utm_projection.hpp"
+
+// GNSS antenna pose (position.x/y/z = latitude [deg], longitude [deg], altitude [m]) to the
+// base_frame pose in the map frame: UTM modulo the MGRS 100 km grid, then the antenna
+// lever arm. Independent of rclcpp, so Gnss_to_map and the offline replay in
+// localization_tools run the same code. Not thread-safe.
+class GnssPoseProjector
+{
+public:
+    // antenna_to_base: pose of base_frame expressed in gnss_frame
+    void set_antenna_to_base(const Eigen::Isometry3d & antenna_to_base)
+    {
+        antenna_to_base_ = antenna_to_base;
+        antenna_to_base_cached_ = true;
+    }
+
+    // Back to the antenna position until the lever arm is set again
+    void clear_antenna_to_base()
+    {
+        antenna_to_base_ = Eigen::Isometry3d::Identity();
+        antenna_to_base_cached_ = false;
+    }
+
+    bool antenna_to_base_cached() const { return antenna_to_base_cached_; }
+    const Eigen::Isometry3d & antenna_to_base() const { return antenna_to_base_; }
+    const UtmProjection & projection() const { return projection_; }
+
+    // Writes the projected pose into out (covariance copied from in); until the lever arm
+    // is set the antenna position is used. Returns true when the fix changed the UTM zone.
+    bool project(const geometry_msgs::msg::PoseWithCovariance & in, geometry_msgs::msg::PoseWithCovariance & out)
+    {
+        const double latitude = in.pose.position.x;
+        const double longitude = in.pose.position.y;
+        const double altitude = in.pose.position.z;
+
+        const int previous_zone = projection_.zone();
+        double map_x;
+        double map_y;
+        projection_.to_map(latitude, longitude, map_x, map_y);
+
+        out = in;
+        out.pose.position.x = map_x;
+        out.pose.position.y = map_y;
+        out.pose.position.z = altitude;
+
+        // Move the antenna pose to base_frame with the cached lever arm
+        if (antenna_to_base_cached_) {
+            auto & out_pose = out.pose;
+            const Eigen::Quaterniond antenna_orientation(
+                out_pose.orientation.w, out_pose.orientation.x, out_pose.orientation.y, out_pose.orientation.z);
+            Eigen::Isometry3d map_to_antenna = Eigen::Isometry3d::Identity();
+            map_to_antenna.translation() << map_x, map_y, altitude;
+            map_to_antenna.linear() = antenna_orientation.normalized().toRotationMatrix();
+
+            const Eigen::Isometry3d map_to_base = map_to_antenna * antenna_to_base_;
+            const Eigen::Quaterniond base_orientation(map_to_base.rotation());
+            out_pose.position.x = map_to_base.translation().x();
+            out_pose.position.y = map_to_base.translation().y();
+            out_pose.position.z = map_to_base.translation().z();
+            out_pose.orientation.x = base_orientation.x();
+            out_pose.orientation.y = base_orientation.y();
+            out_pose.orientation.z = base_orientation.z();
+            out_pose.orientation.w = base_orientation.w();
+        }
+
+        return projection_.zone() != previous_zone;
+    }
+
+    // Position-only fix (NavSatFix): the antenna position in the map frame with identity
+    // orientation, covariance untouched. Without attitude the lever arm cannot be applied
+    // (FixCovarianceModel accounts for it). Returns true when the fix changed the UTM zone.
+    bool project_position(double latitude, double longitude, double altitude, geometry_msgs::msg::PoseWithCovariance & out)
+    {
+        const int previous_zone = projection_.zone();
+        projection_.to_map(latitude, longitude, out.pose.position.x, out.pose.position.y);
+        out.pose.position.z = altitude;
+        out.pose.orientation.x = 0.0;
+        out.pose.orientation.y = 0.0;
+        out.pose.orientation.z = 0.0;
+        out.pose.orientation.w = 1.0;
+        return projection_.zone() != previous_zone;
+    }
+
+private:
+    Eigen::Isometry3d antenna_to_base_{Eigen::Isometry3d::Identity()};
+    bool antenna_to_base_cached_{false};
+
+    // Zone and 100 km grid square are cached across fixes
+    UtmProjection projection_;
+};
+
+#endif  // GNSS2MAP__GNSS_POSE_PROJECTOR_HPP_
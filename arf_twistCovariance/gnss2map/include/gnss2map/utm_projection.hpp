@@ -0,0 +1,145 @@
+#ifndef GNSS2MAP__UTM_PROJECTION_HPP_
+#define GNSS2MAP__UTM_PROJECTION_HPP_
+
+#include <cmath>
+
+// WGS84 transverse Mercator (UTM) projection using the 6th-order Krueger series
+// (Karney, "Transverse Mercator with an accuracy of a few nanometers", 2011).
+//
+// geodesy::fromMsg() selects the zone and evaluates the full series for every fix.
+// UtmProjection instead caches the zone constants and the MGRS 100 km grid square,
+// and only recomputes them when a fix leaves the cached zone or square. The series
+// is summed with a Clenshaw recurrence, so each fix costs one sincos, one exp and
+// the conformal-latitude terms.
+namespace utm_kernel
+{
+
+constexpr double kSemiMajorAxis = 6378137.0;
+constexpr double kFlattening = 1.0 / 298.257223563;
+constexpr double kScaleFactor = 0.9996;
+constexpr double kFalseEasting = 500000.0;
+constexpr double kFalseNorthingSouth = 10000000.0;
+constexpr double kDegToRad = M_PI / 180.0;
+
+constexpr double kN = kFlattening / (2.0 - kFlattening);
+constexpr double kN2 = kN * kN;
+constexpr double kN3 = kN2 * kN;
+constexpr double kN4 = kN3 * kN;
+constexpr double kN5 = kN4 * kN;
+constexpr double kN6 = kN5 * kN;
+
+// Rectifying radius scaled by k0
+constexpr double kScaledRectifyingRadius =
+    kScaleFactor * kSemiMajorAxis / (1.0 + kN) * (1.0 + kN2 / 4.0 + kN4 / 64.0 + kN6 / 256.0);
+
+// Krueger alpha coefficients
+constexpr double kAlpha1 = kN / 2.0 - 2.0 * kN2 / 3.0 + 5.0 * kN3 / 16.0 + 41.0 * kN4 / 180.0 - 127.0 * kN5 / 288.0 + 7891.0 * kN6 / 37800.0;
+constexpr double kAlpha2 = 13.0 * kN2 / 48.0 - 3.0 * kN3 / 5.0 + 557.0 * kN4 / 1440.0 + 281.0 * kN5 / 630.0 - 1983433.0 * kN6 / 1935360.0;
+constexpr double kAlpha3 = 61.0 * kN3 / 240.0 - 103.0 * kN4 / 140.0 + 15061.0 * kN5 / 26880.0 + 167603.0 * kN6 / 181440.0;
+constexpr double kAlpha4 = 49561.0 * kN4 / 161280.0 - 179.0 * kN5 / 168.0 + 6601661.0 * kN6 / 7257600.0;
+constexpr double kAlpha5 = 34729.0 * kN5 / 80640.0 - 3418889.0 * kN6 / 1995840.0;
+constexpr double kAlpha6 = 212378941.0 * kN6 / 319334400.0;
+
+// First eccentricity
+inline double eccentricity() { return std::sqrt(kFlattening * (2.0 - kFlattening)); }
+
+// Transcendental stage: Gauss-Schreiber coordinates xi', eta' and the double-angle
+// terms the series needs. delta_lon is the longitude relative to the central meridian.
+struct SeriesTerms
+{
+    double xi;
+    double eta;
+    double sin_2xi;
+    double cos_2xi;
+    double sinh_2eta;
+    double cosh_2eta;
+};
+
+inline SeriesTerms series_terms(double latitude_rad, double delta_lon_rad, double e)
+{
+    const double sin_lat = std::sin(latitude_rad);
+    const double t = std::sinh(std::atanh(sin_lat) - e * std::atanh(e * sin_lat));
+    const double sin_dl = std::sin(delta_lon_rad);
+    const double cos_dl = std::cos(delta_lon_rad);
+
+    SeriesTerms terms;
+    terms.xi = std::atan2(t, cos_dl);
+    terms.eta = std::atanh(sin_dl / std::sqrt(1.0 + t * t));
+    terms.sin_2xi = std::sin(2.0 * terms.xi);
+    terms.cos_2xi = std::cos(2.0 * terms.xi);
+    const double exp_2eta = std::exp(2.0 * terms.eta);
+    terms.sinh_2eta = 0.5 * (exp_2eta - 1.0 / exp_2eta);
+    terms.cosh_2eta = 0.5 * (exp_2eta + 1.0 / exp_2eta);
+    return terms;
+}
+
+// Arithmetic stage: complex Clenshaw summation of sum_j alpha_j sin(2j zeta'),
+// zeta' = xi' + i eta', giving easting/northing. Only multiplies and adds, in a fixed
+// order, so a SIMD implementation of the same sequence produces identical results.
+inline void series_sum(const SeriesTerms &t, double false_northing, double &easting, double &northing)
+{
+    // a = 2 cos(2 zeta')
+    const double ar = 2.0 * t.cos_2xi * t.cosh_2eta;
+    const double ai = -2.0 * t.sin_2xi * t.sinh_2eta;
+
+    // y_k = a y_{k+1} - y_{k+2} + alpha_k, k = 6..1
+    double y1r = kAlpha6, y1i = 0.0;
+    double y2r = 0.0, y2i = 0.0;
+    double yr, yi;
+
+    yr = ar * y1r - ai * y1i - y2r + kAlpha5; yi = ar * y1i + ai * y1r - y2i; y2r = y1r; y2i = y1i; y1r = yr; y1i = yi;
+    yr = ar * y1r - ai * y1i - y2r + kAlpha4; yi = ar * y1i + ai * y1r - y2i; y2r = y1r; y2i = y1i; y1r = yr; y1i = yi;
+    yr = ar * y1r - ai * y1i - y2r + kAlpha3; yi = ar * y1i + ai * y1r - y2i; y2r = y1r; y2i = y1i; y1r = yr; y1i = yi;
+    yr = ar * y1r - ai * y1i - y2r + kAlpha2; yi = ar * y1i + ai * y1r - y2i; y2r = y1r; y2i = y1i; y1r = yr; y1i = yi;
+    yr = ar * y1r - ai * y1i - y2r + kAlpha1; yi = ar * y1i + ai * y1r - y2i;
+
+    // sum = y_1 sin(2 zeta'), sin(2 zeta') = sin(2xi) cosh(2eta) + i cos(2xi) sinh(2eta)
+    const double sr = t.sin_2xi * t.cosh_2eta;
+    const double si = t.cos_2xi * t.sinh_2eta;
+    const double xi = t.xi + (yr * sr - yi * si);
+    const double eta = t.eta + (yr * si + yi * sr);
+
+    easting = kFalseEasting + kScaledRectifyingRadius * eta;
+    northing = false_northing + kScaledRectifyingRadius * xi;
+}
+
+}  // namespace utm_kernel
+
+class UtmProjection
+{
+public:
+    UtmProjection();
+
+    // UTM zone number including the Norway and Svalbard exceptions
+    static int zone_for(double latitude, double longitude);
+    static double central_meridian_rad(int zone);
+
+    // Full UTM easting/northing. Recomputes the cached zone constants when the fix
+    // lies in another zone or hemisphere than the previous one.
+    void project(double latitude, double longitude, double & easting, double & northing);
+
+    // Map-frame coordinates, identical to fmod(utm, UTM2MGRS): offsets from the
+    // cached 100 km grid square origin, which is moved when the fix leaves it.
+    void to_map(double latitude, double longitude, double & x, double & y);
+
+    int zone() const { return zone_; }
+    bool northern() const { return northern_; }
+    // UTM coordinates of the current 100 km grid square origin (the map frame origin)
+    double grid_origin_easting() const { return grid_origin_easting_; }
+    double grid_origin_northing() const { return grid_origin_northing_; }
+
+private:
+    void select_zone(int zone, bool northern);
+
+    const double eccentricity_;
+
+    int zone_;
+    bool northern_;
+    double central_meridian_rad_;
+    double false_northing_;
+
+    double grid_origin_easting_;
+    double grid_origin_northing_;
+};
+
+#endif  // GNSS2MAP__UTM_PROJECTION_HPP_
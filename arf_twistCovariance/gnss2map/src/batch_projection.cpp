@@ -0,0 +1,254 @@
+#include "gnss2map/batch_projection.hpp"
+#include "gnss2map/utm_projection.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define GNSS2MAP_HAVE_AVX2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define GNSS2MAP_HAVE_NEON 1
+#endif
+
+namespace
+{
+constexpr double kGridSquareSize = 100000.0;
+
+// Samples per block: the transcendental stage writes SoA scratch arrays of this length
+// which the series stage then consumes lane-wise
+constexpr std::size_t kBlockSize = 256;
+
+struct Scratch
+{
+    alignas(32) double xi[kBlockSize];
+    alignas(32) double eta[kBlockSize];
+    alignas(32) double sin_2xi[kBlockSize];
+    alignas(32) double cos_2xi[kBlockSize];
+    alignas(32) double sinh_2eta[kBlockSize];
+    alignas(32) double cosh_2eta[kBlockSize];
+    alignas(32) double false_northing[kBlockSize];
+};
+
+void transcendental_stage(const double * latitude, const double * longitude, std::size_t count, double e, Scratch & s)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        const int zone = UtmProjection::zone_for(latitude[i], longitude[i]);
+        const utm_kernel::SeriesTerms t = utm_kernel::series_terms(
+            latitude[i] * utm_kernel::kDegToRad,
+            longitude[i] * utm_kernel::kDegToRad - UtmProjection::central_meridian_rad(zone), e);
+        s.xi[i] = t.xi;
+        s.eta[i] = t.eta;
+        s.sin_2xi[i] = t.sin_2xi;
+        s.cos_2xi[i] = t.cos_2xi;
+        s.sinh_2eta[i] = t.sinh_2eta;
+        s.cosh_2eta[i] = t.cosh_2eta;
+        s.false_northing[i] = latitude[i] >= 0.0 ? 0.0 : utm_kernel::kFalseNorthingSouth;
+    }
+}
+
+void series_stage_scalar(const Scratch & s, std::size_t begin, std::size_t end, double * x, double * y)
+{
+    for (std::size_t i = begin; i < end; ++i) {
+        utm_kernel::SeriesTerms t;
+        t.xi = s.xi[i];
+        t.eta = s.eta[i];
+        t.sin_2xi = s.sin_2xi[i];
+        t.cos_2xi = s.cos_2xi[i];
+        t.sinh_2eta = s.sinh_2eta[i];
+        t.cosh_2eta = s.cosh_2eta[i];
+
+        double easting;
+        double northing;
+        utm_kernel::series_sum(t, s.false_northing[i], easting, northing);
+        x[i] = std::fmod(easting, kGridSquareSize);
+        y[i] = std::fmod(northing, kGridSquareSize);
+    }
+}
+
+#if defined(GNSS2MAP_HAVE_AVX2)
+
+// fmod(v, kGridSquareSize) for 4 lanes: |v| - floor(|v| / G) * G with a one-step
+// correction is the exact remainder, so it equals fmod; the sign of v is restored last.
+__attribute__((target("avx2"))) inline __m256d grid_remainder(__m256d v)
+{
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d g = _mm256_set1_pd(kGridSquareSize);
+    const __m256d zero = _mm256_setzero_pd();
+
+    const __m256d sign = _mm256_and_pd(v, sign_mask);
+    const __m256d a = _mm256_andnot_pd(sign_mask, v);
+    __m256d r = _mm256_sub_pd(a, _mm256_mul_pd(_mm256_floor_pd(_mm256_div_pd(a, g)), g));
+    r = _mm256_blendv_pd(r, _mm256_add_pd(r, g), _mm256_cmp_pd(r, zero, _CMP_LT_OQ));
+    r = _mm256_blendv_pd(r, _mm256_sub_pd(r, g), _mm256_cmp_pd(r, g, _CMP_GE_OQ));
+    return _mm256_or_pd(r, sign);
+}
+
+// Lane-wise copy of utm_kernel::series_sum, same operation order
+__attribute__((target("avx2"))) std::size_t series_stage_avx2(const Scratch & s, std::size_t count, double * x, double * y)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d minus_two = _mm256_set1_pd(-2.0);
+    const __m256d radius = _mm256_set1_pd(utm_kernel::kScaledRectifyingRadius);
+    const __m256d false_easting = _mm256_set1_pd(utm_kernel::kFalseEasting);
+    const __m256d alpha[5] = {
+        _mm256_set1_pd(utm_kernel::kAlpha5), _mm256_set1_pd(utm_kernel::kAlpha4), _mm256_set1_pd(utm_kernel::kAlpha3),
+        _mm256_set1_pd(utm_kernel::kAlpha2), _mm256_set1_pd(utm_kernel::kAlpha1)};
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d s2x = _mm256_load_pd(s.sin_2xi + i);
+        const __m256d c2x = _mm256_load_pd(s.cos_2xi + i);
+        const __m256d sh = _mm256_load_pd(s.sinh_2eta + i);
+        const __m256d ch = _mm256_load_pd(s.cosh_2eta + i);
+
+        const __m256d ar = _mm256_mul_pd(_mm256_mul_pd(two, c2x), ch);
+        const __m256d ai = _mm256_mul_pd(_mm256_mul_pd(minus_two, s2x), sh);
+
+        __m256d y1r = _mm256_set1_pd(utm_kernel::kAlpha6);
+        __m256d y1i = _mm256_setzero_pd();
+        __m256d y2r = _mm256_setzero_pd();
+        __m256d y2i = _mm256_setzero_pd();
+        for (int k = 0; k < 5; ++k) {
+            const __m256d yr = _mm256_add_pd(
+                _mm256_sub_pd(_mm256_sub_pd(_mm256_mul_pd(ar, y1r), _mm256_mul_pd(ai, y1i)), y2r), alpha[k]);
+            const __m256d yi = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(ar, y1i), _mm256_mul_pd(ai, y1r)), y2i);
+            y2r = y1r;
+            y2i = y1i;
+            y1r = yr;
+            y1i = yi;
+        }
+
+        const __m256d sr = _mm256_mul_pd(s2x, ch);
+        const __m256d si = _mm256_mul_pd(c2x, sh);
+        const __m256d xi = _mm256_add_pd(
+            _mm256_load_pd(s.xi + i), _mm256_sub_pd(_mm256_mul_pd(y1r, sr), _mm256_mul_pd(y1i, si)));
+        const __m256d eta = _mm256_add_pd(
+            _mm256_load_pd(s.eta + i), _mm256_add_pd(_mm256_mul_pd(y1r, si), _mm256_mul_pd(y1i, sr)));
+
+        const __m256d easting = _mm256_add_pd(false_easting, _mm256_mul_pd(radius, eta));
+        const __m256d northing = _mm256_add_pd(_mm256_load_pd(s.false_northing + i), _mm256_mul_pd(radius, xi));
+
+        _mm256_storeu_pd(x + i, grid_remainder(easting));
+        _mm256_storeu_pd(y + i, grid_remainder(northing));
+    }
+    return i;
+}
+
+bool cpu_has_avx2()
+{
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+#elif defined(GNSS2MAP_HAVE_NEON)
+
+inline float64x2_t grid_remainder(float64x2_t v)
+{
+    const float64x2_t g = vdupq_n_f64(kGridSquareSize);
+    const float64x2_t zero = vdupq_n_f64(0.0);
+
+    const float64x2_t a = vabsq_f64(v);
+    float64x2_t r = vsubq_f64(a, vmulq_f64(vrndmq_f64(vdivq_f64(a, g)), g));
+    r = vbslq_f64(vcltq_f64(r, zero), vaddq_f64(r, g), r);
+    r = vbslq_f64(vcgeq_f64(r, g), vsubq_f64(r, g), r);
+    // Restore the sign of v
+    const uint64x2_t sign_mask = vdupq_n_u64(0x8000000000000000ULL);
+    return vreinterpretq_f64_u64(vorrq_u64(vreinterpretq_u64_f64(r), vandq_u64(vreinterpretq_u64_f64(v), sign_mask)));
+}
+
+// Lane-wise copy of utm_kernel::series_sum, same operation order. The file is built
+// with -ffp-contract=off so the multiplies and adds are not fused into FMLA.
+std::size_t series_stage_neon(const Scratch & s, std::size_t count, double * x, double * y)
+{
+    const float64x2_t two = vdupq_n_f64(2.0);
+    const float64x2_t minus_two = vdupq_n_f64(-2.0);
+    const float64x2_t radius = vdupq_n_f64(utm_kernel::kScaledRectifyingRadius);
+    const float64x2_t false_easting = vdupq_n_f64(utm_kernel::kFalseEasting);
+    const float64x2_t alpha[5] = {
+        vdupq_n_f64(utm_kernel::kAlpha5), vdupq_n_f64(utm_kernel::kAlpha4), vdupq_n_f64(utm_kernel::kAlpha3),
+        vdupq_n_f64(utm_kernel::kAlpha2), vdupq_n_f64(utm_kernel::kAlpha1)};
+
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const float64x2_t s2x = vld1q_f64(s.sin_2xi + i);
+        const float64x2_t c2x = vld1q_f64(s.cos_2xi + i);
+        const float64x2_t sh = vld1q_f64(s.sinh_2eta + i);
+        const float64x2_t ch = vld1q_f64(s.cosh_2eta + i);
+
+        const float64x2_t ar = vmulq_f64(vmulq_f64(two, c2x), ch);
+        const float64x2_t ai = vmulq_f64(vmulq_f64(minus_two, s2x), sh);
+
+        float64x2_t y1r = vdupq_n_f64(utm_kernel::kAlpha6);
+        float64x2_t y1i = vdupq_n_f64(0.0);
+        float64x2_t y2r = vdupq_n_f64(0.0);
+        float64x2_t y2i = vdupq_n_f64(0.0);
+        for (int k = 0; k < 5; ++k) {
+            const float64x2_t yr = vaddq_f64(vsubq_f64(vsubq_f64(vmulq_f64(ar, y1r), vmulq_f64(ai, y1i)), y2r), alpha[k]);
+            const float64x2_t yi = vsubq_f64(vaddq_f64(vmulq_f64(ar, y1i), vmulq_f64(ai, y1r)), y2i);
+            y2r = y1r;
+            y2i = y1i;
+            y1r = yr;
+            y1i = yi;
+        }
+
+        const float64x2_t sr = vmulq_f64(s2x, ch);
+        const float64x2_t si = vmulq_f64(c2x, sh);
+        const float64x2_t xi = vaddq_f64(vld1q_f64(s.xi + i), vsubq_f64(vmulq_f64(y1r, sr), vmulq_f64(y1i, si)));
+        const float64x2_t eta = vaddq_f64(vld1q_f64(s.eta + i), vaddq_f64(vmulq_f64(y1r, si), vmulq_f64(y1i, sr)));
+
+        const float64x2_t easting = vaddq_f64(false_easting, vmulq_f64(radius, eta));
+        const float64x2_t northing = vaddq_f64(vld1q_f64(s.false_northing + i), vmulq_f64(radius, xi));
+
+        vst1q_f64(x + i, grid_remainder(easting));
+        vst1q_f64(y + i, grid_remainder(northing));
+    }
+    return i;
+}
+
+#endif
+}  // namespace
+
+void batch_project_to_map(
+    const double * latitude, const double * longitude, const double * altitude, std::size_t count,
+    double * x, double * y, double * z)
+{
+    const double e = utm_kernel::eccentricity();
+    Scratch scratch;
+
+    for (std::size_t begin = 0; begin < count; begin += kBlockSize) {
+        const std::size_t n = std::min(kBlockSize, count - begin);
+        transcendental_stage(latitude + begin, longitude + begin, n, e, scratch);
+
+        std::size_t done = 0;
+#if defined(GNSS2MAP_HAVE_AVX2)
+        if (cpu_has_avx2()) {
+            done = series_stage_avx2(scratch, n, x + begin, y + begin);
+        }
+#elif defined(GNSS2MAP_HAVE_NEON)
+        done = series_stage_neon(scratch, n, x + begin, y + begin);
+#endif
+        series_stage_scalar(scratch, done, n, x + begin, y + begin);
+    }
+
+    std::copy(altitude, altitude + count, z);
+}
+
+const char * batch_projection_isa()
+{
+#if defined(GNSS2MAP_HAVE_AVX2)
+    return cpu_has_avx2() ? "avx2" : "scalar";
+#elif defined(GNSS2MAP_HAVE_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+extern "C" void gnss2map_batch_project_to_map(
+    const double * latitude, const double * longitude, const double * altitude, std::size_t count,
+    double * x, double * y, double * z)
+{
+    batch_project_to_map(latitude, longitude, altitude, count, x, y, z);
+}
@@ -1,56 +1,379 @@
 #include "gnss2map/gnss2map.hpp"
 
-Gnss_to_map::Gnss_to_map()
-: Node("gnss_to_map")
-{
-    map_pose_pub_ = this->create_publisher<geometry_msgs::msg::PoseWithCovarianceStamped>("/gnss2map", 1);
-    
-    // Subscribe to the gnss_pose topic with PoseWithCovarianceStamped message type
-    fix_sub_ = create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>(
-        "/gnss_pose", rclcpp::QoS{1}, std::bind(&Gnss_to_map::pose_callback, this, std::placeholders::_1));
-
-    target_frame = this->declare_parameter<std::string>("target_frame", "map");
-    gnss_frame = this->declare_parameter<std::string>("gnss_frame", "gnss");
-    
+#include <rclcpp_components/register_node_macro.hpp>
+#include <tf2_eigen/tf2_eigen.hpp>
+
+#include <chrono>
+
+Gnss_to_map::Gnss_to_map(const rclcpp::NodeOptions & options)
+: LifecycleNode("gnss_to_map", options)
+{
+    // false: wait for a lifecycle manager or `ros2 lifecycle set` (staged bring-up)
+    const bool start_active = this->declare_parameter<bool>("autostart", true);
+    if (start_active) {
+        autostart(*this);
+    }
+}
+
+LifecycleCallbackReturn Gnss_to_map::on_configure(const rclcpp_lifecycle::State &)
+{
+    requested_frames_ = Frames();
+    applied_target_revision_ = 0;
+    applied_antenna_revision_ = 0;
+    requested_frames_.target_frame = configuredParameter<std::string>(*this, "target_frame", "map");
+    requested_frames_.gnss_frame = configuredParameter<std::string>(*this, "gnss_frame", "gnss");
+    requested_frames_.base_frame = configuredParameter<std::string>(*this, "base_frame", "base_link");
+    frames_.reset(requested_frames_);
+    // Release the TF listener once the antenna transform is cached
+    drop_tf_listener = configuredParameter<bool>(*this, "drop_tf_listener", true);
+
+    // Warm start: map frame and lever arm of the previous run ("": off)
+    const std::string state_file = configuredParameter<std::string>(*this, "state_file", "");
+    if (!state_file.empty()) {
+        std::string error;
+        if (state_file_.open(state_file, kStateVersion, error)) {
+            restore_state();
+        } else {
+            RCLCPP_WARN(this->get_logger(), "State file disabled: %s", error.c_str());
+        }
+    }
+
+    // target_frame is set in the prototype (again only when it is reconfigured), the
+    // callback only writes stamp and pose
+    geometry_msgs::msg::PoseWithCovarianceStamped map_pose_prototype;
+    map_pose_prototype.header.frame_id = requested_frames_.target_frame;
+    map_pose_pub_ = MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped>(
+        *this, "/gnss2map", declareQos(*this, "map_pose", rclcpp::QoS{1}), map_pose_prototype);
+
+    // "pose_with_covariance": /gnss_pose (latitude, longitude, altitude in the position) with
+    // its covariance passed through; "navsat_fix": /fix with the covariance modelled from the
+    // fix status and the reported ENU covariance
+    const std::string input_type = configuredParameter<std::string>(*this, "input_type", "pose_with_covariance");
+    latency_monitor_ = std::make_unique<LatencyMonitor>(*this);
+    if (input_type == "navsat_fix") {
+        // Sigmas [m] used when the receiver reports no covariance, and the scale of a
+        // reported one, per fix status
+        const auto status_model = [this](const std::string & status, double horizontal, double vertical) {
+            const std::string prefix = "fix_covariance." + status + ".";
+            return FixCovarianceModel::StatusModel{
+                configuredParameter<double>(*this, prefix + "horizontal_sigma", horizontal),
+                configuredParameter<double>(*this, prefix + "vertical_sigma", vertical),
+                configuredParameter<double>(*this, prefix + "scale", 1.0)};
+        };
+        std::array<FixCovarianceModel::StatusModel, FixCovarianceModel::kStatusCount> models;
+        models[FixCovarianceModel::status_index(sensor_msgs::msg::NavSatStatus::STATUS_NO_FIX)] = {1e3, 1e3, 1.0};
+        models[FixCovarianceModel::status_index(sensor_msgs::msg::NavSatStatus::STATUS_FIX)] = status_model("single", 3.0, 6.0);
+        models[FixCovarianceModel::status_index(sensor_msgs::msg::NavSatStatus::STATUS_SBAS_FIX)] = status_model("sbas", 1.0, 2.0);
+        models[FixCovarianceModel::status_index(sensor_msgs::msg::NavSatStatus::STATUS_GBAS_FIX)] = status_model("gbas", 0.5, 1.0);
+        covariance_model_.configure(models,
+            configuredParameter<double>(*this, "fix_covariance.min_sigma", 0.01),
+            configuredParameter<double>(*this, "fix_covariance.orientation_sigma", 1000.0),
+            projector_.antenna_to_base_cached() ? projector_.antenna_to_base().translation().head<2>().norm() : 0.0);
+
+        navsat_sub_ = create_subscription<sensor_msgs::msg::NavSatFix>(
+            "/fix", declareQos(*this, "fix", rclcpp::QoS{1}), std::bind(&Gnss_to_map::fix_callback, this, std::placeholders::_1));
+        fix_statistics_ = &latency_monitor_->addCallback("fix");
+        no_fix_ = &fix_statistics_->addCounter("no_fix");
+    } else {
+        if (input_type != "pose_with_covariance") {
+            RCLCPP_WARN(this->get_logger(), "Unknown input_type '%s', using 'pose_with_covariance'", input_type.c_str());
+        }
+        fix_sub_ = create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>(
+            "/gnss_pose", declareQos(*this, "gnss_pose", rclcpp::QoS{1}), std::bind(&Gnss_to_map::pose_callback, this, std::placeholders::_1));
+        fix_statistics_ = &latency_monitor_->addCallback("gnss_pose");
+    }
+
     tf_buffer_ = std::make_unique<tf2_ros::Buffer>(this->get_clock());
     tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
+
+    // The antenna is mounted rigidly, so the transform is looked up once instead of per fix
+    tf_lookup_timer_ = this->create_wall_timer(
+        std::chrono::seconds(1), std::bind(&Gnss_to_map::cache_antenna_transform, this));
+
+    // Registered last, so the declarations above are not passed through it
+    parameter_callback_ = this->add_on_set_parameters_callback(
+        std::bind(&Gnss_to_map::on_set_parameters, this, std::placeholders::_1));
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+LifecycleCallbackReturn Gnss_to_map::on_activate(const rclcpp_lifecycle::State &)
+{
+    active_.store(true, std::memory_order_relaxed);
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+LifecycleCallbackReturn Gnss_to_map::on_deactivate(const rclcpp_lifecycle::State &)
+{
+    active_.store(false, std::memory_order_relaxed);
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+LifecycleCallbackReturn Gnss_to_map::on_cleanup(const rclcpp_lifecycle::State &)
+{
+    release();
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+LifecycleCallbackReturn Gnss_to_map::on_shutdown(const rclcpp_lifecycle::State &)
+{
+    active_.store(false, std::memory_order_relaxed);
+    release();
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+void Gnss_to_map::release()
+{
+    if (parameter_callback_) {
+        this->remove_on_set_parameters_callback(parameter_callback_.get());
+        parameter_callback_.reset();
+    }
+    tf_lookup_timer_.reset();
+    tf_listener_.reset();
+    tf_buffer_.reset();
+    fix_sub_.reset();
+    navsat_sub_.reset();
+    map_pose_pub_ = MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped>();
+    latency_monitor_.reset();
+    fix_statistics_ = nullptr;
+    no_fix_ = nullptr;
+
+    // A lever arm cached before the first fix is not saved yet
+    if (state_file_.isOpen() && state_dirty_ && projector_.projection().zone() != 0) {
+        write_state();
+    }
+    state_file_.close();
+    saved_state_valid_ = false;
+    state_dirty_ = false;
+    first_fix_ = true;
+    // The next configure restores or looks up the lever arm again
+    projector_.clear_antenna_to_base();
+    antenna_from_tf_ = false;
+}
+
+rcl_interfaces::msg::SetParametersResult Gnss_to_map::on_set_parameters(const std::vector<rclcpp::Parameter> & parameters)
+{
+    rcl_interfaces::msg::SetParametersResult result;
+    result.successful = true;
+    Frames frames = requested_frames_;
+    bool changed = false;
+    for (const rclcpp::Parameter & parameter : parameters) {
+        const std::string & name = parameter.get_name();
+        std::string * frame = name == "target_frame" ? &frames.target_frame :
+            name == "gnss_frame" ? &frames.gnss_frame :
+            name == "base_frame" ? &frames.base_frame : nullptr;
+        if (!frame) {
+            continue;
+        }
+        if (parameter.get_type() != rclcpp::ParameterType::PARAMETER_STRING || parameter.as_string().empty()) {
+            result.successful = false;
+            result.reason = name + " must be a non-empty frame id";
+            return result;
+        }
+        if (*frame == parameter.as_string()) {
+            continue;
+        }
+        *frame = parameter.as_string();
+        ++(frame == &frames.target_frame ? frames.target_revision : frames.antenna_revision);
+        changed = true;
+    }
+
+    // All frames of one request are taken up together
+    if (changed) {
+        requested_frames_ = frames;
+        frames_.publish(requested_frames_);
+    }
+    return result;
+}
+
+void Gnss_to_map::apply_frames()
+{
+    if (!frames_.update()) {
+        return;
+    }
+    const Frames & frames = frames_.current();
+
+    if (frames.target_revision != applied_target_revision_) {
+        geometry_msgs::msg::PoseWithCovarianceStamped map_pose_prototype;
+        map_pose_prototype.header.frame_id = frames.target_frame;
+        map_pose_pub_.setPrototype(map_pose_prototype);
+        applied_target_revision_ = frames.target_revision;
+        RCLCPP_INFO(this->get_logger(), "Publishing in frame %s", frames.target_frame.c_str());
+    }
+
+    // The lever arm in use stays until the new transform is found
+    if (frames.antenna_revision != applied_antenna_revision_) {
+        applied_antenna_revision_ = frames.antenna_revision;
+        antenna_from_tf_ = false;
+        if (!tf_buffer_) {
+            tf_buffer_ = std::make_unique<tf2_ros::Buffer>(this->get_clock());
+            tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
+        }
+        tf_lookup_timer_->reset();
+        RCLCPP_INFO(this->get_logger(), "Looking up the %s -> %s lever arm",
+            frames.gnss_frame.c_str(), frames.base_frame.c_str());
+    }
+}
+
+void Gnss_to_map::restore_state()
+{
+    if (!state_file_.load(saved_state_)) {
+        RCLCPP_INFO(this->get_logger(), "No saved state, waiting for TF and the first fix");
+        return;
+    }
+    saved_state_valid_ = true;
+
+    if (saved_state_.antenna_to_base_valid) {
+        const std::array<double, 7> & saved = saved_state_.antenna_to_base;
+        Eigen::Isometry3d antenna_to_base = Eigen::Isometry3d::Identity();
+        antenna_to_base.translation() << saved[0], saved[1], saved[2];
+        antenna_to_base.linear() = Eigen::Quaterniond(saved[6], saved[3], saved[4], saved[5]).normalized().toRotationMatrix();
+        projector_.set_antenna_to_base(antenna_to_base);
+        covariance_model_.set_lever_arm_length(antenna_to_base.translation().head<2>().norm());
+    }
+    RCLCPP_INFO(this->get_logger(), "Saved map frame: zone %d%s, grid square (%.0f, %.0f)%s", saved_state_.zone,
+        saved_state_.northern ? "N" : "S", saved_state_.grid_origin_easting, saved_state_.grid_origin_northing,
+        saved_state_.antenna_to_base_valid ? "; restored the lever arm" : "");
+}
+
+void Gnss_to_map::write_state()
+{
+    const UtmProjection & projection = projector_.projection();
+    PersistedState state{};
+    state.zone = projection.zone();
+    state.northern = projection.northern() ? 1 : 0;
+    state.grid_origin_easting = projection.grid_origin_easting();
+    state.grid_origin_northing = projection.grid_origin_northing();
+    if (projector_.antenna_to_base_cached()) {
+        const Eigen::Isometry3d & antenna_to_base = projector_.antenna_to_base();
+        const Eigen::Quaterniond rotation(antenna_to_base.rotation());
+        state.antenna_to_base_valid = 1;
+        state.antenna_to_base = {antenna_to_base.translation().x(), antenna_to_base.translation().y(),
+            antenna_to_base.translation().z(), rotation.x(), rotation.y(), rotation.z(), rotation.w()};
+    }
+    state_file_.store(state);
+    saved_state_ = state;
+    saved_state_valid_ = true;
+    state_dirty_ = false;
+}
+
+void Gnss_to_map::cache_antenna_transform()
+{
+    apply_frames();
+    if (antenna_from_tf_) {
+        return;
+    }
+
+    const Frames & frames = frames_.current();
+    geometry_msgs::msg::TransformStamped base_to_antenna;
+    try {
+        base_to_antenna = tf_buffer_->lookupTransform(frames.base_frame, frames.gnss_frame, tf2::TimePointZero);
+    } catch (const tf2::TransformException & ex) {
+        RCLCPP_INFO_THROTTLE(this->get_logger(), *this->get_clock(), 10000,
+            "Waiting for %s -> %s: %s", frames.base_frame.c_str(), frames.gnss_frame.c_str(), ex.what());
+        return;
+    }
+
+    projector_.set_antenna_to_base(tf2::transformToEigen(base_to_antenna).inverse());
+    covariance_model_.set_lever_arm_length(projector_.antenna_to_base().translation().head<2>().norm());
+    antenna_from_tf_ = true;
+    tf_lookup_timer_->cancel();
+    // Saved with the map frame, so before the first fix it waits for the next one
+    state_dirty_ = true;
+    if (state_file_.isOpen() && projector_.projection().zone() != 0) {
+        write_state();
+    }
+
+    const Eigen::Vector3d lever_arm = -projector_.antenna_to_base().translation();
+    RCLCPP_INFO(this->get_logger(), "Cached %s -> %s lever arm (%.3f, %.3f, %.3f)",
+        frames.gnss_frame.c_str(), frames.base_frame.c_str(), lever_arm.x(), lever_arm.y(), lever_arm.z());
+
+    if (drop_tf_listener) {
+        tf_listener_.reset();
+        tf_buffer_.reset();
+    }
 }
 
 void Gnss_to_map::pose_callback(const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr pose_msg) {
-    // Extract position from the PoseWithCovarianceStamped message
-    const auto& pose = pose_msg->pose.pose;
-    const double latitude = pose.position.x; // Assuming position.x is latitude
-    const double longitude = pose.position.y; // Assuming position.y is longitude
-    const double altitude = pose.position.z; // Assuming position.z is altitude
+    if (!active_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    ScopedCallbackTimer timer(*fix_statistics_);
+    apply_frames();
+
+    if (!projector_.antenna_to_base_cached()) {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 10000,
+            "Antenna transform not cached yet, publishing the %s position", frames_.current().gnss_frame.c_str());
+    }
 
-    // Convert GPS coordinates to UTM
-    geographic_msgs::msg::GeoPoint gps_msg;
-    gps_msg.latitude = latitude;
-    gps_msg.longitude = longitude;
-    gps_msg.altitude = altitude;
+    // Populate the PoseStamped message in place (see MessagePublisher for the publish path).
+    // Map coordinates are UTM modulo the MGRS 100 km grid, moved to base_frame.
+    map_pose_pub_.publish([&](geometry_msgs::msg::PoseWithCovarianceStamped & gnss2map_msg) {
+        gnss2map_msg.header.stamp = pose_msg->header.stamp;
 
-    geodesy::UTMPoint utm;
-    geodesy::fromMsg(gps_msg, utm);
+        bool zone_changed;
+        {
+            AllocationGuard no_allocation;
+            zone_changed = projector_.project(pose_msg->pose, gnss2map_msg.pose);
+        }
+        update_map_frame(zone_changed);
+
+        // Publish the PoseStamped message
+        latency_monitor_->recordAge(*fix_statistics_, pose_msg->header.stamp);
+        return true;
+    });
+}
 
-    // Create and populate the PoseStamped message
-    geometry_msgs::msg::PoseWithCovarianceStamped gnss2map_msg;
-    gnss2map_msg.header = pose_msg->header;
-    gnss2map_msg.header.frame_id = target_frame;
+void Gnss_to_map::fix_callback(const sensor_msgs::msg::NavSatFix::ConstSharedPtr fix_msg) {
+    if (!active_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    ScopedCallbackTimer timer(*fix_statistics_);
+    apply_frames();
 
-    gnss2map_msg.pose= pose_msg->pose;
+    if (fix_msg->status.status < sensor_msgs::msg::NavSatStatus::STATUS_FIX) {
+        no_fix_->add();
+        return;
+    }
 
-    gnss2map_msg.pose.pose.position.x = fmod(utm.easting, UTM2MGRS);
-    gnss2map_msg.pose.pose.position.y = fmod(utm.northing, UTM2MGRS);
-    gnss2map_msg.pose.pose.position.z = utm.altitude;
+    // Antenna position in the map frame; the covariance covers the unrotated lever arm
+    map_pose_pub_.publish([&](geometry_msgs::msg::PoseWithCovarianceStamped & gnss2map_msg) {
+        gnss2map_msg.header.stamp = fix_msg->header.stamp;
 
-    // Publish the PoseStamped message
-    map_pose_pub_->publish(gnss2map_msg);
+        bool zone_changed;
+        {
+            AllocationGuard no_allocation;
+            zone_changed = projector_.project_position(fix_msg->latitude, fix_msg->longitude, fix_msg->altitude, gnss2map_msg.pose);
+            covariance_model_.covariance(*fix_msg, projector_.projection().zone(), gnss2map_msg.pose.covariance);
+        }
+        update_map_frame(zone_changed);
+
+        latency_monitor_->recordAge(*fix_statistics_, fix_msg->header.stamp);
+        return true;
+    });
 }
 
-int main(int argc, char * argv[])
+void Gnss_to_map::update_map_frame(bool zone_changed)
 {
-    rclcpp::init(argc, argv);
-    rclcpp::spin(std::make_shared<Gnss_to_map>());
-    rclcpp::shutdown();
-    return 0;
+    const UtmProjection & projection = projector_.projection();
+    if (zone_changed) {
+        RCLCPP_INFO(this->get_logger(), "Using UTM zone %d%s", projection.zone(), projection.northern() ? "N" : "S");
+    }
+
+    // Written when the map frame (zone or grid square) or the lever arm changed
+    if (state_file_.isOpen()) {
+        const bool moved = !saved_state_valid_ || projection.zone() != saved_state_.zone ||
+            projection.grid_origin_easting() != saved_state_.grid_origin_easting ||
+            projection.grid_origin_northing() != saved_state_.grid_origin_northing;
+        if (moved && first_fix_ && saved_state_valid_) {
+            RCLCPP_WARN(this->get_logger(), "Map frame moved since the last run: grid square (%.0f, %.0f) instead of (%.0f, %.0f)",
+                projection.grid_origin_easting(), projection.grid_origin_northing(),
+                saved_state_.grid_origin_easting, saved_state_.grid_origin_northing);
+        }
+        if (moved || state_dirty_) {
+            write_state();
+        }
+    }
+    first_fix_ = false;
 }
+
+RCLCPP_COMPONENTS_REGISTER_NODE(Gnss_to_map)
@@ -0,0 +1,98 @@
+#include "gnss2map/utm_projection.hpp"
+
+namespace
+{
+// Size of an MGRS 100 km grid square
+constexpr double kGridSquareSize = 100000.0;
+
+// Origin of the grid square containing value. The remainder value - origin is exact
+// (both are within a factor of two of each other, or origin is 0), so it matches
+// fmod(value, kGridSquareSize) bit for bit.
+double grid_origin(double value)
+{
+    double origin = std::floor(value / kGridSquareSize) * kGridSquareSize;
+    if (value - origin < 0.0) {
+        origin -= kGridSquareSize;
+    } else if (value - origin >= kGridSquareSize) {
+        origin += kGridSquareSize;
+    }
+    return origin;
+}
+}  // namespace
+
+UtmProjection::UtmProjection()
+: eccentricity_(utm_kernel::eccentricity()),
+  zone_(0),
+  northern_(true),
+  central_meridian_rad_(0.0),
+  false_northing_(0.0),
+  grid_origin_easting_(0.0),
+  grid_origin_northing_(0.0)
+{
+}
+
+int UtmProjection::zone_for(double latitude, double longitude)
+{
+    // Same zone selection as geodesy, including the Norway and Svalbard exceptions
+    if (latitude >= 56.0 && latitude < 64.0 && longitude >= 3.0 && longitude < 12.0) {
+        return 32;
+    }
+    if (latitude >= 72.0 && latitude < 84.0) {
+        if (longitude >= 0.0 && longitude < 9.0) {
+            return 31;
+        } else if (longitude >= 9.0 && longitude < 21.0) {
+            return 33;
+        } else if (longitude >= 21.0 && longitude < 33.0) {
+            return 35;
+        } else if (longitude >= 33.0 && longitude < 42.0) {
+            return 37;
+        }
+    }
+    const int zone = static_cast<int>(std::floor((longitude + 180.0) / 6.0)) + 1;
+    return zone > 60 ? 60 : zone;
+}
+
+double UtmProjection::central_meridian_rad(int zone)
+{
+    return ((zone - 1) * 6.0 - 180.0 + 3.0) * utm_kernel::kDegToRad;
+}
+
+void UtmProjection::select_zone(int zone, bool northern)
+{
+    zone_ = zone;
+    northern_ = northern;
+    central_meridian_rad_ = central_meridian_rad(zone);
+    false_northing_ = northern ? 0.0 : utm_kernel::kFalseNorthingSouth;
+}
+
+void UtmProjection::project(double latitude, double longitude, double & easting, double & northing)
+{
+    const int zone = zone_for(latitude, longitude);
+    const bool northern = latitude >= 0.0;
+    if (zone != zone_ || northern != northern_) {
+        select_zone(zone, northern);
+    }
+
+    const utm_kernel::SeriesTerms terms = utm_kernel::series_terms(
+        latitude * utm_kernel::kDegToRad, longitude * utm_kernel::kDegToRad - central_meridian_rad_, eccentricity_);
+    utm_kernel::series_sum(terms, false_northing_, easting, northing);
+}
+
+void UtmProjection::to_map(double latitude, double longitude, double & x, double & y)
+{
+    double easting;
+    double northing;
+    project(latitude, longitude, easting, northing);
+
+    x = easting - grid_origin_easting_;
+    if (x < 0.0 || x >= kGridSquareSize) {
+        grid_origin_easting_ = grid_origin(easting);
+        x = easting - grid_origin_easting_;
+    }
+
+    y = northing - grid_origin_northing_;
+    if (y < 0.0 || y >= kGridSquareSize) {
+        grid_origin_northing_ = grid_origin(northing);
+        y = northing - grid_origin_northing_;
+    }
+}
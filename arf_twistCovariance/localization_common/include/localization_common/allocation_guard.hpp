@@ -0,0 +1,51 @@
+#ifndef LOCALIZATION_COMMON__ALLOCATION_GUARD_HPP_
+#define LOCALIZATION_COMMON__ALLOCATION_GUARD_HPP_
+
+// Marks a scope of the active state that must not touch the heap. The check itself lives in
+// liblocalization_allocation_hook.so, which replaces malloc and friends when it is preloaded:
+//
+//   LD_PRELOAD=$(ros2 pkg prefix localization_common)/lib/liblocalization_allocation_hook.so ros2 launch ...
+//
+// and aborts the process on the first allocation inside a guarded scope, so the core dump
+// (or gdb) shows the offending call. Without the hook the symbol below is unresolved and a
+// guard costs one branch; in release builds (NDEBUG) it compiles to nothing. Guards nest and
+// are per thread.
+
+#ifndef NDEBUG
+extern "C" int *localization_allocation_guard_depth() __attribute__((weak));
+#endif
+
+class AllocationGuard
+{
+public:
+#ifndef NDEBUG
+    AllocationGuard() : depth_(localization_allocation_guard_depth ? localization_allocation_guard_depth() : nullptr)
+    {
+        if (depth_)
+        {
+            ++*depth_;
+        }
+    }
+
+    ~AllocationGuard()
+    {
+        if (depth_)
+        {
+            --*depth_;
+        }
+    }
+#else
+    // User-provided, so an unused guard object does not warn
+    AllocationGuard() {}
+#endif
+
+    AllocationGuard(const AllocationGuard &) = delete;
+    AllocationGuard &operator=(const AllocationGuard &) = delete;
+
+#ifndef NDEBUG
+private:
+    int *depth_;
+#endif
+};
+
+#endif  // LOCALIZATION_COMMON__ALLOCATION_GUARD_HPP_
@@ -0,0 +1,69 @@
+#ifndef LOCALIZATION_COMMON__CONFIG_BUFFER_HPP_
+#define LOCALIZATION_COMMON__CONFIG_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands complete configuration sets from a parameter callback (writer) to one callback
+// group (reader) without locks. The writer fills its back slot and swaps it with the
+// spare slot; the reader swaps the spare slot with its front slot when a newer set is
+// waiting. A plain two-slot swap would let the writer overwrite the set the reader is
+// using, so the third slot keeps writer and reader apart and neither ever waits.
+//
+// The reader polls with update() before it uses current(): one relaxed load while nothing
+// changed, and current() never changes between two update() calls, so a set is always
+// applied as a whole. Copying into the back slot happens on the writer's thread; when T
+// holds containers of the same size as in reset(), publish() does not allocate either.
+template <typename T>
+class ConfigBuffer
+{
+public:
+    explicit ConfigBuffer(const T &initial = T()) : slots_{{initial, initial, initial}} {}
+
+    ConfigBuffer(const ConfigBuffer &) = delete;
+    ConfigBuffer &operator=(const ConfigBuffer &) = delete;
+
+    // Sets every slot; only while neither side is running (node construction)
+    void reset(const T &value)
+    {
+        slots_.fill(value);
+        back_ = 0;
+        exchange_.store(1, std::memory_order_relaxed);
+        front_ = 2;
+    }
+
+    // Writer, one at a time: makes value the latest set
+    void publish(const T &value)
+    {
+        slots_[back_] = value;
+        back_ = exchange_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Reader: takes the latest set if one was published since the last call; true when
+    // current() changed
+    bool update()
+    {
+        if ((exchange_.load(std::memory_order_relaxed) & kFresh) == 0)
+        {
+            return false;
+        }
+        front_ = exchange_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    // Reader: the set taken by the last update()
+    const T &current() const { return slots_[front_]; }
+
+private:
+    static constexpr uint32_t kIndexMask = 3u;
+    static constexpr uint32_t kFresh = 4u;
+
+    std::array<T, 3> slots_;
+    // Slot indices: back (writer only), spare (shared, with kFresh while unread), front (reader only)
+    uint32_t back_ = 0;
+    std::atomic<uint32_t> exchange_{1};
+    uint32_t front_ = 2;
+};
+
+#endif  // LOCALIZATION_COMMON__CONFIG_BUFFER_HPP_
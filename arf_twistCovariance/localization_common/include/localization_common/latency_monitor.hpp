@@ -0,0 +1,358 @@
+#ifndef LOCALIZATION_COMMON__LATENCY_MONITOR_HPP_
+#define LOCALIZATION_COMMON__LATENCY_MONITOR_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+#include <builtin_interfaces/msg/time.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Latency and rate instrumentation shared by the localization nodes.
+//
+// Callbacks record into per-callback lock-free histograms (relaxed atomic adds, no
+// locks, no allocation, no logging); a wall timer in its own callback group drains
+// them once per period and publishes one DiagnosticStatus per callback on /diagnostics.
+
+// Log2 histogram of durations in microseconds. Bucket 0 holds values below 1 us and
+// bucket i values in [2^(i-1), 2^i) us, so percentiles are reported as the upper edge
+// of their bucket (clamped to the observed maximum), i.e. within a factor of two.
+class LatencyHistogram
+{
+public:
+    static constexpr std::size_t kBucketCount = 32;
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        double mean_us = 0.0;
+        double p50_us = 0.0;
+        double p90_us = 0.0;
+        double p99_us = 0.0;
+        double max_us = 0.0;
+    };
+
+    void record(int64_t duration_ns)
+    {
+        const uint64_t ns = duration_ns > 0 ? static_cast<uint64_t>(duration_ns) : 0;
+        buckets_[bucketIndex(ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t max = max_ns_.load(std::memory_order_relaxed);
+        while (ns > max && !max_ns_.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Returns the samples recorded since the previous call and empties the histogram.
+    // Buckets are drained one by one, so a sample recorded concurrently may be counted
+    // in the next period; that is acceptable for statistics.
+    Summary drain()
+    {
+        std::array<uint64_t, kBucketCount> counts;
+        Summary summary;
+        for (std::size_t i = 0; i < kBucketCount; ++i)
+        {
+            counts[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+            summary.count += counts[i];
+        }
+        const uint64_t sum_ns = sum_ns_.exchange(0, std::memory_order_relaxed);
+        const uint64_t max_ns = max_ns_.exchange(0, std::memory_order_relaxed);
+        if (summary.count == 0)
+        {
+            return summary;
+        }
+
+        summary.mean_us = static_cast<double>(sum_ns) / 1e3 / static_cast<double>(summary.count);
+        summary.max_us = static_cast<double>(max_ns) / 1e3;
+        summary.p50_us = percentile(counts, summary.count, 0.50, summary.max_us);
+        summary.p90_us = percentile(counts, summary.count, 0.90, summary.max_us);
+        summary.p99_us = percentile(counts, summary.count, 0.99, summary.max_us);
+        return summary;
+    }
+
+private:
+    static std::size_t bucketIndex(uint64_t us)
+    {
+        if (us == 0)
+        {
+            return 0;
+        }
+        const std::size_t index = 64 - static_cast<std::size_t>(__builtin_clzll(us));
+        return std::min(index, kBucketCount - 1);
+    }
+
+    static double percentile(const std::array<uint64_t, kBucketCount> &counts, uint64_t count, double quantile, double max_us)
+    {
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count))));
+        uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i)
+        {
+            cumulative += counts[i];
+            if (cumulative >= rank)
+            {
+                return std::min(static_cast<double>(uint64_t{1} << i), max_us);
+            }
+        }
+        return max_us;
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> sum_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+};
+
+// Number of events (missed deadlines, dropped outputs, ...) reported as the count of the
+// last period and as the running total
+class EventCounter
+{
+public:
+    explicit EventCounter(const std::string &key) : key_(key) {}
+
+    EventCounter(const EventCounter &) = delete;
+    EventCounter &operator=(const EventCounter &) = delete;
+
+    void add(uint64_t count = 1) { count_.fetch_add(count, std::memory_order_relaxed); }
+
+    const std::string &key() const { return key_; }
+
+    // Reporter side: returns the count since the previous call and adds it to the total
+    uint64_t drain()
+    {
+        const uint64_t count = count_.exchange(0, std::memory_order_relaxed);
+        total_ += count;
+        return count;
+    }
+    uint64_t total() const { return total_; }
+
+private:
+    const std::string key_;
+    std::atomic<uint64_t> count_{0};
+    uint64_t total_ = 0;
+};
+
+// Statistics of one callback: execution (wall) time, age of the input stamp when the
+// output is published, and inter-arrival jitter |dt_k - dt_(k-1)| of the invocations.
+class CallbackStatistics
+{
+public:
+    explicit CallbackStatistics(const std::string &name) : name_(name) {}
+
+    CallbackStatistics(const CallbackStatistics &) = delete;
+    CallbackStatistics &operator=(const CallbackStatistics &) = delete;
+
+    // steady_ns: steady clock at callback entry
+    void recordArrival(int64_t steady_ns)
+    {
+        invocations_.fetch_add(1, std::memory_order_relaxed);
+        const int64_t previous_ns = last_arrival_ns_.exchange(steady_ns, std::memory_order_relaxed);
+        if (previous_ns == 0)
+        {
+            return;
+        }
+        const int64_t interval_ns = steady_ns - previous_ns;
+        const int64_t previous_interval_ns = last_interval_ns_.exchange(interval_ns, std::memory_order_relaxed);
+        if (previous_interval_ns > 0)
+        {
+            jitter_.record(std::abs(interval_ns - previous_interval_ns));
+        }
+    }
+
+    void recordExecution(int64_t duration_ns) { execution_.record(duration_ns); }
+    void recordAge(int64_t age_ns) { age_.record(age_ns); }
+
+    const std::string &name() const { return name_; }
+    uint64_t drainInvocations() { return invocations_.exchange(0, std::memory_order_relaxed); }
+    LatencyHistogram &execution() { return execution_; }
+    LatencyHistogram &age() { return age_; }
+    LatencyHistogram &jitter() { return jitter_; }
+
+    // Like LatencyMonitor::addCallback, add counters before the node is spun
+    EventCounter &addCounter(const std::string &key)
+    {
+        counters_.emplace_back(key);
+        return counters_.back();
+    }
+    std::deque<EventCounter> &counters() { return counters_; }
+
+private:
+    const std::string name_;
+    std::atomic<uint64_t> invocations_{0};
+    std::atomic<int64_t> last_arrival_ns_{0};
+    std::atomic<int64_t> last_interval_ns_{0};
+    LatencyHistogram execution_;
+    LatencyHistogram age_;
+    LatencyHistogram jitter_;
+    std::deque<EventCounter> counters_;
+};
+
+inline int64_t steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Place at the top of a callback: records the arrival on construction and the
+// execution time on destruction
+class ScopedCallbackTimer
+{
+public:
+    explicit ScopedCallbackTimer(CallbackStatistics &statistics)
+        : statistics_(statistics), start_ns_(steadyNanoseconds())
+    {
+        statistics_.recordArrival(start_ns_);
+    }
+
+    ~ScopedCallbackTimer()
+    {
+        statistics_.recordExecution(steadyNanoseconds() - start_ns_);
+    }
+
+    ScopedCallbackTimer(const ScopedCallbackTimer &) = delete;
+    ScopedCallbackTimer &operator=(const ScopedCallbackTimer &) = delete;
+
+private:
+    CallbackStatistics &statistics_;
+    const int64_t start_ns_;
+};
+
+class LatencyMonitor
+{
+public:
+    // NodeT is any node type providing the node interfaces, create_wall_timer and
+    // create_callback_group (rclcpp::Node, rclcpp_lifecycle::LifecycleNode). The publisher
+    // is a plain one, so a lifecycle node keeps reporting while it is inactive.
+    template <typename NodeT>
+    explicit LatencyMonitor(NodeT &node, double period = 1.0)
+        : node_name_(node.get_name()), clock_(node.get_clock()), period_(period)
+    {
+        publisher_ = rclcpp::create_publisher<diagnostic_msgs::msg::DiagnosticArray>(node, "/diagnostics", 10);
+        // Own group, so reporting neither waits for nor delays the instrumented callbacks
+        callback_group_ = node.create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+        timer_ = node.create_wall_timer(std::chrono::duration<double>(period), [this]() { publish(); }, callback_group_);
+    }
+
+    LatencyMonitor(const LatencyMonitor &) = delete;
+    LatencyMonitor &operator=(const LatencyMonitor &) = delete;
+
+    // Registration is not synchronized with the reporter: add every callback while
+    // constructing the node, before it is spun. The returned reference stays valid.
+    CallbackStatistics &addCallback(const std::string &name)
+    {
+        callbacks_.emplace_back(name);
+        return callbacks_.back();
+    }
+
+    // Additional status published with the callbacks, e.g. the health of the inputs. Same
+    // registration rule as addCallback. fill runs on the reporter thread with level OK
+    // preset, so it may only read state that is safe to read concurrently.
+    void addStatus(const std::string &name, std::function<void(diagnostic_msgs::msg::DiagnosticStatus &)> fill)
+    {
+        statuses_.push_back({name, std::move(fill)});
+    }
+
+    // Age of an input stamp at the time of publishing, against the node clock
+    void recordAge(CallbackStatistics &statistics, const builtin_interfaces::msg::Time &stamp) const
+    {
+        statistics.recordAge(clock_->now().nanoseconds() - rclcpp::Time(stamp).nanoseconds());
+    }
+
+private:
+    void publish()
+    {
+        auto msg = std::make_unique<diagnostic_msgs::msg::DiagnosticArray>();
+        msg->header.stamp = clock_->now();
+        msg->status.reserve(callbacks_.size() + statuses_.size());
+
+        for (CallbackStatistics &callback : callbacks_)
+        {
+            const uint64_t invocations = callback.drainInvocations();
+            const LatencyHistogram::Summary execution = callback.execution().drain();
+            const LatencyHistogram::Summary age = callback.age().drain();
+            const LatencyHistogram::Summary jitter = callback.jitter().drain();
+
+            diagnostic_msgs::msg::DiagnosticStatus status;
+            status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+            status.name = node_name_ + ": " + callback.name();
+            status.hardware_id = node_name_;
+            addValue(status, "rate_hz", static_cast<double>(invocations) / period_);
+            addValue(status, "exec_mean_us", execution.mean_us);
+            addValue(status, "exec_p50_us", execution.p50_us);
+            addValue(status, "exec_p99_us", execution.p99_us);
+            addValue(status, "exec_max_us", execution.max_us);
+            if (age.count > 0)
+            {
+                addValue(status, "age_p50_ms", age.p50_us / 1e3);
+                addValue(status, "age_p99_ms", age.p99_us / 1e3);
+                addValue(status, "age_max_ms", age.max_us / 1e3);
+            }
+            addValue(status, "jitter_p90_us", jitter.p90_us);
+            addValue(status, "jitter_p99_us", jitter.p99_us);
+            for (EventCounter &counter : callback.counters())
+            {
+                addCount(status, counter.key(), counter.drain());
+                addCount(status, counter.key() + "_total", counter.total());
+            }
+            msg->status.push_back(std::move(status));
+        }
+
+        for (const ExtraStatus &extra : statuses_)
+        {
+            diagnostic_msgs::msg::DiagnosticStatus status;
+            status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+            status.name = node_name_ + ": " + extra.name;
+            status.hardware_id = node_name_;
+            extra.fill(status);
+            msg->status.push_back(std::move(status));
+        }
+
+        publisher_->publish(std::move(msg));
+    }
+
+    static void addValue(diagnostic_msgs::msg::DiagnosticStatus &status, const char *key, double value)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.1f", value);
+        diagnostic_msgs::msg::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = buffer;
+        status.values.push_back(std::move(key_value));
+    }
+
+    static void addCount(diagnostic_msgs::msg::DiagnosticStatus &status, const std::string &key, uint64_t count)
+    {
+        diagnostic_msgs::msg::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = std::to_string(count);
+        status.values.push_back(std::move(key_value));
+    }
+
+    const std::string node_name_;
+    rclcpp::Clock::SharedPtr clock_;
+    const double period_;
+
+    // deque: references handed out by addCallback stay valid as it grows
+    std::deque<CallbackStatistics> callbacks_;
+
+    struct ExtraStatus
+    {
+        std::string name;
+        std::function<void(diagnostic_msgs::msg::DiagnosticStatus &)> fill;
+    };
+    std::vector<ExtraStatus> statuses_;
+
+    rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr publisher_;
+    rclcpp::CallbackGroup::SharedPtr callback_group_;
+    rclcpp::TimerBase::SharedPtr timer_;
+};
+
+#endif  // LOCALIZATION_COMMON__LATENCY_MONITOR_HPP_
@@ -0,0 +1,47 @@
+#ifndef LOCALIZATION_COMMON__LIFECYCLE_HPP_
+#define LOCALIZATION_COMMON__LIFECYCLE_HPP_
+
+#include <lifecycle_msgs/msg/state.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_lifecycle/lifecycle_node.hpp>
+
+#include <string>
+
+// Shared lifecycle handling of the localization nodes. Their constructors only declare the
+// parameters needed before the first configuration (autostart, executor_threads); on_configure
+// reads everything else and allocates every buffer, message and TF cache the active state uses,
+// and on_cleanup releases them again.
+
+using LifecycleCallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
+
+// Configure-time parameter: declared by the first configure and kept declared across cleanup,
+// so a later configure reads its current value (runtime changes included). Statically typed
+// parameters cannot be undeclared again.
+template <typename T, typename NodeT>
+T configuredParameter(NodeT &node, const std::string &name, const T &default_value)
+{
+    if (node.has_parameter(name))
+    {
+        return node.get_parameter(name).template get_value<T>();
+    }
+    return node.template declare_parameter<T>(name, default_value);
+}
+
+// Runs configure and activate when the autostart parameter is set, for containers and launch
+// files that do not drive the lifecycle; true when the node ended up active
+inline bool autostart(rclcpp_lifecycle::LifecycleNode &node)
+{
+    if (node.configure().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
+    {
+        RCLCPP_ERROR(node.get_logger(), "Autostart: configure failed");
+        return false;
+    }
+    if (node.activate().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_ACTIVE)
+    {
+        RCLCPP_ERROR(node.get_logger(), "Autostart: activate failed");
+        return false;
+    }
+    return true;
+}
+
+#endif  // LOCALIZATION_COMMON__LIFECYCLE_HPP_
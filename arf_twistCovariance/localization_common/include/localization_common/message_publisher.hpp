@@ -0,0 +1,94 @@
+#ifndef LOCALIZATION_COMMON__MESSAGE_PUBLISHER_HPP_
+#define LOCALIZATION_COMMON__MESSAGE_PUBLISHER_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+// Publisher that fills its message in place and picks the cheapest path the transport offers:
+//  - loaned:        middleware-owned memory, when the rmw can loan MessageT. Only fixed-size
+//                   types can be loaned, so messages with a std::string frame_id never take
+//                   this path; it is used as soon as the type and the rmw allow it.
+//  - intra-process: a new unique_ptr whose ownership moves to the subscribers. The one
+//                   allocation replaces the copy publish(const MessageT &) would make.
+//  - otherwise:     one message allocated at construction and reused for every publish. The
+//                   rmw serializes it inside publish(), so it is free again on return.
+// Constant fields (the header frame_id) are set once in the prototype and are not written on
+// the publish path; fill has to set every other field. The fill callable returns false to
+// drop the message. Not thread-safe: publish from one callback group per instance.
+// The publisher is a plain rclcpp::Publisher for lifecycle nodes too: they gate their
+// callbacks on the active state themselves instead of through a LifecyclePublisher.
+template <typename MessageT>
+class MessagePublisher
+{
+public:
+    using PublisherT = rclcpp::Publisher<MessageT>;
+
+    MessagePublisher() = default;
+
+    template <typename NodeT>
+    MessagePublisher(NodeT &node, const std::string &topic, const rclcpp::QoS &qos, const MessageT &prototype = MessageT())
+        : publisher_(rclcpp::create_publisher<MessageT>(node, topic, qos)),
+          prototype_(prototype),
+          message_(prototype),
+          intra_process_(node.get_node_options().use_intra_process_comms()),
+          loan_(publisher_->can_loan_messages())
+    {
+    }
+
+    template <typename FillT>
+    bool publish(FillT &&fill)
+    {
+        if (loan_)
+        {
+            auto loaned = publisher_->borrow_loaned_message();
+            loaned.get() = prototype_;
+            if (!fill(loaned.get()))
+            {
+                return false;
+            }
+            publisher_->publish(std::move(loaned));
+            return true;
+        }
+
+        if (intra_process_)
+        {
+            auto message = std::make_unique<MessageT>(prototype_);
+            if (!fill(*message))
+            {
+                return false;
+            }
+            publisher_->publish(std::move(message));
+            return true;
+        }
+
+        if (!fill(message_))
+        {
+            return false;
+        }
+        publisher_->publish(message_);
+        return true;
+    }
+
+    // Replaces the constant fields (runtime reconfiguration); from the publishing callback
+    // group, between two publishes
+    void setPrototype(const MessageT &prototype)
+    {
+        prototype_ = prototype;
+        message_ = prototype;
+    }
+
+    const typename PublisherT::SharedPtr &publisher() const { return publisher_; }
+
+private:
+    typename PublisherT::SharedPtr publisher_;
+    MessageT prototype_;
+    // Reused message of the inter-process path
+    MessageT message_;
+    bool intra_process_ = false;
+    bool loan_ = false;
+};
+
+#endif  // LOCALIZATION_COMMON__MESSAGE_PUBLISHER_HPP_
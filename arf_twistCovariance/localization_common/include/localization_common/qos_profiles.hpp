@@ -0,0 +1,105 @@
+#ifndef LOCALIZATION_COMMON__QOS_PROFILES_HPP_
+#define LOCALIZATION_COMMON__QOS_PROFILES_HPP_
+
+#include <localization_common/lifecycle.hpp>
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <cstdint>
+#include <string>
+
+// Per-topic QoS from parameters. For a topic key <name> the node declares
+//   qos.<name>.profile      "default" (the compiled-in QoS of the topic) or "sensor_data"
+//   qos.<name>.reliability  "reliable" | "best_effort"
+//   qos.<name>.history      "keep_last" | "keep_all"
+//   qos.<name>.depth        queue depth for keep_last
+//   qos.<name>.durability   "volatile" | "transient_local"
+//   qos.<name>.deadline     [s], 0: none
+//   qos.<name>.lifespan     [s], 0: none (publishers only)
+// The profile provides the defaults of the other fields, so e.g. profile "sensor_data"
+// with depth 5 is best-effort keep-last-5.
+
+// Only the newest sample is of interest: best effort, keep last 1, volatile
+inline rclcpp::QoS sensorDataQos()
+{
+    return rclcpp::QoS(rclcpp::KeepLast(1)).best_effort().durability_volatile();
+}
+
+inline double qosSeconds(const rmw_time_t &time)
+{
+    return static_cast<double>(time.sec) + static_cast<double>(time.nsec) * 1e-9;
+}
+
+template <typename NodeT>
+rclcpp::QoS declareQos(NodeT &node, const std::string &name, const rclcpp::QoS &default_qos)
+{
+    const std::string prefix = "qos." + name + ".";
+    const rclcpp::Logger logger = node.get_logger();
+
+    const std::string profile = configuredParameter<std::string>(node, prefix + "profile", "default");
+    rclcpp::QoS base = default_qos;
+    if (profile == "sensor_data")
+    {
+        base = sensorDataQos();
+    }
+    else if (profile != "default")
+    {
+        RCLCPP_WARN(logger, "Unknown %sprofile '%s', using 'default'", prefix.c_str(), profile.c_str());
+    }
+    const rmw_qos_profile_t &defaults = base.get_rmw_qos_profile();
+
+    const std::string reliability = configuredParameter<std::string>(node, 
+        prefix + "reliability", defaults.reliability == RMW_QOS_POLICY_RELIABILITY_BEST_EFFORT ? "best_effort" : "reliable");
+    const std::string history = configuredParameter<std::string>(node, 
+        prefix + "history", defaults.history == RMW_QOS_POLICY_HISTORY_KEEP_ALL ? "keep_all" : "keep_last");
+    const int64_t depth = configuredParameter<int64_t>(node, prefix + "depth", static_cast<int64_t>(defaults.depth));
+    const std::string durability = configuredParameter<std::string>(node, 
+        prefix + "durability", defaults.durability == RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL ? "transient_local" : "volatile");
+    const double deadline = configuredParameter<double>(node, prefix + "deadline", qosSeconds(defaults.deadline));
+    const double lifespan = configuredParameter<double>(node, prefix + "lifespan", qosSeconds(defaults.lifespan));
+
+    bool keep_all = history == "keep_all";
+    bool transient_local = durability == "transient_local";
+    std::size_t queue_depth = depth > 0 ? static_cast<std::size_t>(depth) : 1;
+
+    // Intra-process delivery only supports keep-last, non-zero depth and volatile durability
+    if (node.get_node_options().use_intra_process_comms())
+    {
+        if (keep_all || depth <= 0 || transient_local)
+        {
+            RCLCPP_WARN(logger, "qos.%s: intra-process communication requires keep_last, depth > 0 and volatile; "
+                                "using keep_last %zu, volatile", name.c_str(), queue_depth);
+        }
+        keep_all = false;
+        transient_local = false;
+    }
+
+    rclcpp::QoS qos = keep_all ? rclcpp::QoS(rclcpp::KeepAll()) : rclcpp::QoS(rclcpp::KeepLast(queue_depth));
+    if (reliability == "best_effort")
+    {
+        qos.best_effort();
+    }
+    else
+    {
+        qos.reliable();
+    }
+    if (transient_local)
+    {
+        qos.transient_local();
+    }
+    else
+    {
+        qos.durability_volatile();
+    }
+    if (deadline > 0.0)
+    {
+        qos.deadline(rclcpp::Duration::from_seconds(deadline));
+    }
+    if (lifespan > 0.0)
+    {
+        qos.lifespan(rclcpp::Duration::from_seconds(lifespan));
+    }
+    return qos;
+}
+
+#endif  // LOCALIZATION_COMMON__QOS_PROFILES_HPP_
@@ -0,0 +1,178 @@
+#ifndef LOCALIZATION_COMMON__STATE_FILE_HPP_
+#define LOCALIZATION_COMMON__STATE_FILE_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Small fixed-size state record kept in a memory-mapped file, so a node can warm-start
+// from where the previous run stopped.
+//
+// The file holds two copies of the record, each with a sequence number and a checksum.
+// store() overwrites the older copy, so a write torn by a crash or power loss leaves the
+// other one intact, and load() returns the newest valid copy. A store is a memcpy into
+// the mapping plus an asynchronous msync, cheap enough for a low-rate timer but not meant
+// for the message path. Not thread-safe.
+template <typename T>
+class MappedStateFile
+{
+    static_assert(std::is_trivially_copyable<T>::value, "MappedStateFile requires a trivially copyable record");
+
+public:
+    MappedStateFile() = default;
+    ~MappedStateFile() { close(); }
+
+    MappedStateFile(const MappedStateFile &) = delete;
+    MappedStateFile &operator=(const MappedStateFile &) = delete;
+
+    // Maps path, creating it if needed. version identifies the meaning of T: a file
+    // written with another version or record size loads nothing and is overwritten by the
+    // next store. False with a message in error when the file cannot be mapped.
+    bool open(const std::string &path, uint32_t version, std::string &error)
+    {
+        close();
+        version_ = version;
+
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            error = "cannot open " + path + ": " + std::strerror(errno);
+            return false;
+        }
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || (static_cast<std::size_t>(info.st_size) != sizeof(File) && ::ftruncate(fd, sizeof(File)) != 0))
+        {
+            error = "cannot size " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+
+        void *mapping = ::mmap(nullptr, sizeof(File), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            error = "cannot map " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        file_ = static_cast<File *>(mapping);
+        return true;
+    }
+
+    void close()
+    {
+        if (file_)
+        {
+            ::msync(file_, sizeof(File), MS_SYNC);
+            ::munmap(file_, sizeof(File));
+            file_ = nullptr;
+        }
+    }
+
+    bool isOpen() const { return file_ != nullptr; }
+
+    // Newest valid record; false when the file holds none (new, other version, corrupt)
+    bool load(T &value) const
+    {
+        const Slot *newest = nullptr;
+        if (file_)
+        {
+            for (const Slot &slot : file_->slots)
+            {
+                if (valid(slot) && (!newest || slot.sequence > newest->sequence))
+                {
+                    newest = &slot;
+                }
+            }
+        }
+        if (!newest)
+        {
+            return false;
+        }
+        std::memcpy(&value, &newest->value, sizeof(T));
+        return true;
+    }
+
+    void store(const T &value)
+    {
+        if (!file_)
+        {
+            return;
+        }
+
+        // Overwrite the older (or invalid) copy
+        uint64_t sequence = 0;
+        std::size_t target = 0;
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            const Slot &slot = file_->slots[i];
+            if (valid(slot) && slot.sequence >= sequence)
+            {
+                sequence = slot.sequence;
+                target = 1 - i;
+            }
+        }
+
+        Slot &slot = file_->slots[target];
+        slot.magic = kMagic;
+        slot.version = version_;
+        slot.size = static_cast<uint32_t>(sizeof(T));
+        slot.sequence = sequence + 1;
+        std::memcpy(&slot.value, &value, sizeof(T));
+        slot.checksum = checksum(slot);
+        ::msync(file_, sizeof(File), MS_ASYNC);
+    }
+
+private:
+    static constexpr uint64_t kMagic = 0x4c4f43535441544bULL;  // "LOCSTATK"
+
+    struct Slot
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t size;
+        uint64_t sequence;
+        uint64_t checksum;
+        T value;
+    };
+
+    struct File
+    {
+        Slot slots[2];
+    };
+
+    // FNV-1a over the sequence number and the record
+    static uint64_t checksum(const Slot &slot)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        const auto mix = [&hash](const void *data, std::size_t size)
+        {
+            const unsigned char *bytes = static_cast<const unsigned char *>(data);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+            }
+        };
+        mix(&slot.sequence, sizeof(slot.sequence));
+        mix(&slot.value, sizeof(T));
+        return hash;
+    }
+
+    bool valid(const Slot &slot) const
+    {
+        return slot.magic == kMagic && slot.version == version_ && slot.size == sizeof(T) && slot.checksum == checksum(slot);
+    }
+
+    File *file_ = nullptr;
+    uint32_t version_ = 0;
+};
+
+#endif  // LOCALIZATION_COMMON__STATE_FILE_HPP_
@@ -0,0 +1,113 @@
+// LD_PRELOAD library behind AllocationGuard (see localization_common/allocation_guard.hpp):
+// replaces the glibc allocation entry points, forwards them to the glibc implementation and
+// aborts when one is called inside a guarded scope. operator new and the STL end up here too.
+// free is not checked: releasing a message the transport handed over is expected.
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *pointer, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+void *__libc_valloc(std::size_t size);
+void *__libc_pvalloc(std::size_t size);
+}
+
+namespace
+{
+
+// initial-exec: the library is loaded at startup, and the default model could allocate on the
+// first access from a new thread
+thread_local int guard_depth __attribute__((tls_model("initial-exec"))) = 0;
+
+void check(const char *function)
+{
+    if (guard_depth == 0)
+    {
+        return;
+    }
+    // Nothing here may allocate: write(2) instead of stdio
+    static const char kPrefix[] = "localization_allocation_hook: ";
+    static const char kSuffix[] = " in an allocation-free scope (AllocationGuard), aborting\n";
+    ssize_t written = ::write(STDERR_FILENO, kPrefix, sizeof(kPrefix) - 1);
+    written = ::write(STDERR_FILENO, function, std::strlen(function));
+    written = ::write(STDERR_FILENO, kSuffix, sizeof(kSuffix) - 1);
+    static_cast<void>(written);
+    guard_depth = 0;
+    std::abort();
+}
+
+}  // namespace
+
+extern "C" {
+
+__attribute__((visibility("default"))) int *localization_allocation_guard_depth()
+{
+    return &guard_depth;
+}
+
+__attribute__((visibility("default"))) void *malloc(std::size_t size)
+{
+    check("malloc");
+    return __libc_malloc(size);
+}
+
+__attribute__((visibility("default"))) void *calloc(std::size_t count, std::size_t size)
+{
+    check("calloc");
+    return __libc_calloc(count, size);
+}
+
+__attribute__((visibility("default"))) void *realloc(void *pointer, std::size_t size)
+{
+    check("realloc");
+    return __libc_realloc(pointer, size);
+}
+
+__attribute__((visibility("default"))) void *memalign(std::size_t alignment, std::size_t size)
+{
+    check("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+__attribute__((visibility("default"))) void *aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    check("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+__attribute__((visibility("default"))) int posix_memalign(void **pointer, std::size_t alignment, std::size_t size)
+{
+    check("posix_memalign");
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+    void *memory = __libc_memalign(alignment, size);
+    if (!memory && size != 0)
+    {
+        return ENOMEM;
+    }
+    *pointer = memory;
+    return 0;
+}
+
+__attribute__((visibility("default"))) void *valloc(std::size_t size)
+{
+    check("valloc");
+    return __libc_valloc(size);
+}
+
+__attribute__((visibility("default"))) void *pvalloc(std::size_t size)
+{
+    check("pvalloc");
+    return __libc_pvalloc(size);
+}
+
+}  // extern "C"
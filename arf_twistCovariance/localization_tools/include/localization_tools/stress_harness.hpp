@@ -0,0 +1,271 @@
+#ifndef LOCALIZATION_TOOLS__STRESS_HARNESS_HPP_
+#define LOCALIZATION_TOOLS__STRESS_HARNESS_HPP_
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "localization_tools/tool_options.hpp"
+
+// ROS-independent parts of localization_stress: the synthetic vehicle, the sensor
+// schedules with their dropout patterns, the simulated-time history used to measure
+// latency, and the per-thread CPU accounting.
+
+// Vehicle driving a circle of radius [m] at speed [m/s] counter-clockwise around the
+// origin of a local east-north plane at (latitude, longitude) [deg]
+class CircleTrajectory
+{
+public:
+    struct State
+    {
+        double east;      // [m]
+        double north;     // [m]
+        double yaw;       // [rad], ENU heading
+        double speed;     // [m/s], along the heading
+        double yaw_rate;  // [rad/s]
+    };
+
+    CircleTrajectory(double latitude, double longitude, double radius, double speed)
+        : latitude_(latitude), longitude_(longitude), radius_(std::max(radius, 1.0)), speed_(speed)
+    {
+    }
+
+    State at(double time_s) const
+    {
+        const double yaw_rate = speed_ / radius_;
+        const double angle = yaw_rate * time_s;
+        return {radius_ * std::cos(angle), radius_ * std::sin(angle), angle + 0.5 * M_PI, speed_, yaw_rate};
+    }
+
+    // Local tangent plane approximation, well below the noise at the radii used here
+    void geodetic(double east, double north, double &latitude, double &longitude) const
+    {
+        constexpr double kEarthRadius = 6378137.0;
+        constexpr double kRadToDeg = 180.0 / M_PI;
+        latitude = latitude_ + north / kEarthRadius * kRadToDeg;
+        longitude = longitude_ + east / (kEarthRadius * std::cos(latitude_ / kRadToDeg)) * kRadToDeg;
+    }
+
+private:
+    double latitude_;
+    double longitude_;
+    double radius_;
+    double speed_;
+};
+
+// Sample times of one synthetic sensor on simulated time, with random dropouts and
+// periodic outages. Options <name>.rate [Hz] (0: off), <name>.noise (position sigma in
+// m or twist sigma in m/s and rad/s), <name>.dropout (probability of losing a sample),
+// <name>.outage_period and <name>.outage_duration [s] (nothing is sent for duration at
+// the start of every period). Every schedule has its own generator seeded from seed, so
+// changing one sensor leaves the samples of the others unchanged.
+class SensorSchedule
+{
+public:
+    SensorSchedule(const std::string &name, ToolOptions &options, double default_rate, double default_noise, uint64_t seed)
+        : name_(name), random_(seed)
+    {
+        const double rate = options.number(name + ".rate", default_rate);
+        period_ns_ = rate > 0.0 ? static_cast<int64_t>(std::llround(1e9 / rate)) : 0;
+        noise_ = options.number(name + ".noise", default_noise);
+        dropout_ = std::min(std::max(options.number(name + ".dropout", 0.0), 0.0), 1.0);
+        outage_period_ns_ = static_cast<int64_t>(options.number(name + ".outage_period", 0.0) * 1e9);
+        outage_duration_ns_ = static_cast<int64_t>(options.number(name + ".outage_duration", 0.0) * 1e9);
+    }
+
+    const std::string &name() const { return name_; }
+    bool enabled() const { return period_ns_ > 0; }
+    int64_t period() const { return period_ns_; }
+    double noise() const { return noise_; }
+
+    // Starts the sample grid at start_ns; outages are counted from there too
+    void start(int64_t start_ns)
+    {
+        start_ns_ = start_ns;
+        next_ns_ = start_ns;
+    }
+
+    // True when a sample is due at time_ns and survives the dropout pattern; at most one
+    // sample per call, so the clock step must not exceed the period
+    bool due(int64_t time_ns)
+    {
+        if (period_ns_ <= 0 || time_ns < next_ns_)
+        {
+            return false;
+        }
+        while (next_ns_ <= time_ns)
+        {
+            next_ns_ += period_ns_;
+        }
+        ++scheduled_;
+
+        const bool outage = outage_period_ns_ > 0 && (time_ns - start_ns_) % outage_period_ns_ < outage_duration_ns_;
+        // Drawn even in an outage, so an outage does not shift the later dropouts
+        const bool dropped = std::uniform_real_distribution<double>(0.0, 1.0)(random_) < dropout_;
+        if (outage || dropped)
+        {
+            ++dropped_;
+            return false;
+        }
+        return true;
+    }
+
+    // Zero-mean Gaussian sample with sigma noise() * scale
+    double noise(double scale) { return noise_ > 0.0 ? std::normal_distribution<double>(0.0, noise_ * scale)(random_) : 0.0; }
+
+    uint64_t scheduled() const { return scheduled_; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    std::string name_;
+    std::mt19937_64 random_;
+    int64_t period_ns_ = 0;
+    double noise_ = 0.0;
+    double dropout_ = 0.0;
+    int64_t outage_period_ns_ = 0;
+    int64_t outage_duration_ns_ = 0;
+    int64_t start_ns_ = 0;
+    int64_t next_ns_ = 0;
+    uint64_t scheduled_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+// Wall time at which each simulated clock step was published. Written by the clock
+// thread before the step's messages go out, read by the probes to turn an output stamp
+// into the wall time its data became available.
+class ClockHistory
+{
+public:
+    ClockHistory(int64_t start_ns, int64_t step_ns, std::size_t steps)
+        : start_ns_(start_ns), step_ns_(std::max<int64_t>(step_ns, 1)), wall_ns_(steps)
+    {
+        for (std::atomic<int64_t> &wall_ns : wall_ns_)
+        {
+            wall_ns.store(kUnset, std::memory_order_relaxed);
+        }
+    }
+
+    void record(std::size_t step, int64_t wall_ns)
+    {
+        wall_ns_[step].store(wall_ns, std::memory_order_release);
+        published_.store(step + 1, std::memory_order_release);
+    }
+
+    // Wall time of the first step at or after stamp_ns; a stamp ahead of the clock (an
+    // extrapolated output) maps to the latest step, a stamp before the start to the first
+    int64_t wallAt(int64_t stamp_ns) const
+    {
+        const std::size_t published = published_.load(std::memory_order_acquire);
+        if (published == 0)
+        {
+            return kUnset;
+        }
+        const int64_t offset_ns = std::max<int64_t>(stamp_ns - start_ns_, 0);
+        const std::size_t step = std::min(static_cast<std::size_t>((offset_ns + step_ns_ - 1) / step_ns_), published - 1);
+        return wall_ns_[step].load(std::memory_order_acquire);
+    }
+
+    static constexpr int64_t kUnset = -1;
+
+private:
+    int64_t start_ns_;
+    int64_t step_ns_;
+    std::vector<std::atomic<int64_t>> wall_ns_;
+    std::atomic<std::size_t> published_{0};
+};
+
+// Exact percentiles of latency samples (sorted once at the end)
+struct LatencySummary
+{
+    std::size_t count = 0;
+    double p50_ms = 0.0;
+    double p90_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+
+    static LatencySummary of(std::vector<int64_t> samples_ns)
+    {
+        LatencySummary summary;
+        summary.count = samples_ns.size();
+        if (samples_ns.empty())
+        {
+            return summary;
+        }
+        std::sort(samples_ns.begin(), samples_ns.end());
+        const auto percentile = [&samples_ns](double quantile)
+        {
+            const std::size_t rank = static_cast<std::size_t>(std::ceil(quantile * static_cast<double>(samples_ns.size())));
+            return static_cast<double>(samples_ns[std::max<std::size_t>(rank, 1) - 1]) * 1e-6;
+        };
+        summary.p50_ms = percentile(0.50);
+        summary.p90_ms = percentile(0.90);
+        summary.p99_ms = percentile(0.99);
+        summary.max_ms = static_cast<double>(samples_ns.back()) * 1e-6;
+        return summary;
+    }
+};
+
+// User + system CPU time [s] of this process's threads, summed per thread name
+// (/proc/self/task/<tid>/comm, at most 15 characters)
+inline std::map<std::string, double> threadCpuSeconds()
+{
+    std::map<std::string, double> seconds;
+    const double ticks_per_second = static_cast<double>(::sysconf(_SC_CLK_TCK));
+    DIR *tasks = ::opendir("/proc/self/task");
+    if (!tasks)
+    {
+        return seconds;
+    }
+    while (const dirent *entry = ::readdir(tasks))
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        const std::string task = std::string("/proc/self/task/") + entry->d_name;
+        std::string name;
+        std::ifstream(task + "/comm") >> name;
+        std::string stat;
+        std::getline(std::ifstream(task + "/stat"), stat);
+
+        // The fields after the parenthesised name start with field 3 (state); utime and
+        // stime are fields 14 and 15
+        const std::size_t name_end = stat.rfind(')');
+        if (name.empty() || name_end == std::string::npos)
+        {
+            continue;
+        }
+        std::istringstream fields(stat.substr(name_end + 2));
+        std::string field;
+        unsigned long long utime = 0;
+        unsigned long long stime = 0;
+        for (int index = 3; index <= 15 && fields >> field; ++index)
+        {
+            if (index == 14)
+            {
+                utime = std::stoull(field);
+            }
+            else if (index == 15)
+            {
+                stime = std::stoull(field);
+            }
+        }
+        seconds[name] += static_cast<double>(utime + stime) / ticks_per_second;
+    }
+    ::closedir(tasks);
+    return seconds;
+}
+
+#endif  // LOCALIZATION_TOOLS__STRESS_HARNESS_HPP_
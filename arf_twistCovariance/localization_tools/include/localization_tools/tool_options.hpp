@@ -0,0 +1,68 @@
+#ifndef LOCALIZATION_TOOLS__TOOL_OPTIONS_HPP_
+#define LOCALIZATION_TOOLS__TOOL_OPTIONS_HPP_
+
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+// key:=value arguments. Every lookup removes its key, so the keys left over at the end
+// are unknown ones.
+class ToolOptions
+{
+public:
+    // arguments[first..]: the command line without the program and positional arguments
+    bool parse(const std::vector<std::string> &arguments, std::size_t first)
+    {
+        for (std::size_t i = first; i < arguments.size(); ++i)
+        {
+            const std::string &argument = arguments[i];
+            const std::size_t separator = argument.find(":=");
+            if (separator == std::string::npos || separator == 0)
+            {
+                std::fprintf(stderr, "Invalid argument '%s', expected key:=value\n", argument.c_str());
+                return false;
+            }
+            values_[argument.substr(0, separator)] = argument.substr(separator + 2);
+        }
+        return true;
+    }
+
+    std::string text(const std::string &key, const std::string &default_value)
+    {
+        const auto it = values_.find(key);
+        if (it == values_.end())
+        {
+            return default_value;
+        }
+        const std::string value = it->second;
+        values_.erase(it);
+        return value;
+    }
+
+    double number(const std::string &key, double default_value)
+    {
+        const std::string value = text(key, "");
+        return value.empty() ? default_value : std::stod(value);
+    }
+
+    bool flag(const std::string &key, bool default_value)
+    {
+        const std::string value = text(key, "");
+        return value.empty() ? default_value : value == "true" || value == "1";
+    }
+
+    void warnUnused() const
+    {
+        for (const auto &entry : values_)
+        {
+            std::fprintf(stderr, "Unknown option '%s' ignored\n", entry.first.c_str());
+        }
+    }
+
+private:
+    std::map<std::string, std::string> values_;
+};
+
+#endif  // LOCALIZATION_TOOLS__TOOL_OPTIONS_HPP_
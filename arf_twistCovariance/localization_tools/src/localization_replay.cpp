@@ -0,0 +1,599 @@
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/serialized_message.hpp>
+#include <rclcpp/time.hpp>
+#include <rosbag2_cpp/reader.hpp>
+#include <rosbag2_cpp/writer.hpp>
+#include <geometry_msgs/msg/pose_stamped.hpp>
+#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
+#include <geometry_msgs/msg/twist_with_covariance_stamped.hpp>
+#include <tf2_msgs/msg/tf_message.hpp>
+
+#include <gnss2map/gnss_pose_projector.hpp>
+#include <localization_tools/tool_options.hpp>
+#include <pose_covariance_publisher/gnss_pose_processor.hpp>
+#include <pose_fusion/pose_fusion_engine.hpp>
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <limits>
+#include <map>
+#include <queue>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Offline replay of pose_covariance_publisher -> gnss2map -> pose_fusion_node on a rosbag2
+// file, without DDS and as fast as the CPU allows:
+//
+//   localization_replay <input_bag> <output_bag> [key:=value ...]
+//
+// The inputs of the live pipeline (/gnss_pose, the LiDAR pose and the EKF twist) are read
+// with rosbag2_cpp::Reader, put back into header stamp order within reorder_window and run
+// through the same processing classes the nodes use. Time is the message stamp: the fixed
+// rate output ticks at grid times derived from the stamps, after every input stamped at or
+// before the grid time has been processed, i.e. the live pipeline without transport or
+// scheduling delay. The results are written to a new bag with receive time = stamp:
+//   /gnss_pose_with_covariance, /fix_twist             (pose_covariance_publisher)
+//   /fix_pose                                         (gnss2map, remapped as in the launch file)
+//   /final/pose_with_covariance, /fused_twist, /tf    (pose_fusion_node)
+// The GNSS antenna lever arm is taken from the base_frame -> gnss_frame transform on
+// /tf_static. The keys are the parameter names of the three nodes (see the
+// LocalizationReplay constructor), plus the input topic names and reorder_window.
+
+namespace
+{
+
+template <typename MessageT>
+MessageT deserialize(const rosbag2_storage::SerializedBagMessage &bag_message)
+{
+    static const rclcpp::Serialization<MessageT> serialization;
+    const rclcpp::SerializedMessage serialized(*bag_message.serialized_data);
+    MessageT message;
+    serialization.deserialize_message(&serialized, &message);
+    return message;
+}
+
+int64_t toNanoseconds(const builtin_interfaces::msg::Time &stamp)
+{
+    return rclcpp::Time(stamp).nanoseconds();
+}
+
+// Strategy: fusion strategy of the pose_fusion engine, chosen by fusion_mode in main()
+template <typename Strategy>
+class LocalizationReplay
+{
+public:
+    explicit LocalizationReplay(ToolOptions &options)
+    {
+        gnss_topic_ = options.text("gnss_topic", "/gnss_pose");
+        lidar_topic_ = options.text("lidar_topic", "/localization/pose_with_covariance");
+        ekf_twist_topic_ = options.text("ekf_twist_topic", "/localization/pose_twist_fusion_filter/twist_with_covariance");
+        tf_static_topic_ = options.text("tf_static_topic", "/tf_static");
+        // Messages are held back this long [s] of stamp time to restore stamp order
+        reorder_window_ns_ = static_cast<int64_t>(options.number("reorder_window", 0.5) * 1e9);
+
+        // pose_covariance_publisher
+        const std::string rate_method = options.text("rate_method", "least_squares");
+        RateMethod method = RateMethod::kLeastSquares;
+        if (rate_method == "savitzky_golay")
+        {
+            method = RateMethod::kSavitzkyGolay;
+        }
+        else if (rate_method == "difference")
+        {
+            method = RateMethod::kDifference;
+        }
+        else if (rate_method != "least_squares")
+        {
+            std::fprintf(stderr, "Unknown rate_method '%s', using 'least_squares'\n", rate_method.c_str());
+        }
+        processor_.configure(static_cast<std::size_t>(std::max(options.number("covariance_window", 20.0), 2.0)),
+                             options.number("covariance_decay", 0.0), options.number("covariance_floor", 1e-4), method,
+                             static_cast<std::size_t>(std::max(options.number("rate_window", 5.0), 2.0)),
+                             options.flag("input_is_geodetic", true));
+        fix_twist_.header.frame_id = "base_link";
+
+        // gnss2map
+        fix_pose_.header.frame_id = options.text("target_frame", "map");
+        gnss_frame_ = options.text("gnss_frame", "gnss");
+        base_frame_ = options.text("base_frame", "base_link");
+
+        // pose_fusion_node
+        PoseFusionConfig config;
+        config.sync_window_ns = static_cast<int64_t>(options.number("sync_window", 0.1) * 1e9);
+        config.interpolate = options.text("sync_mode", "interpolate") != "nearest";
+        // The replay feeds the default sources of pose_fusion_node, one slot each
+        config.pose_source_weights = {options.number("sources.lidar.weight", 1.0), options.number("sources.gnss.weight", 1.0)};
+        config.twist_source_weights = {options.number("sources.ekf.weight", 1.0), options.number("sources.filter.weight", 1.0)};
+        config.min_pose_sources = static_cast<std::size_t>(std::max(options.number("min_pose_sources", 0.0), 0.0));
+        config.min_twist_sources = static_cast<std::size_t>(std::max(options.number("min_twist_sources", 0.0), 0.0));
+        // Receipt timeouts on bag time [s] (0: never)
+        const double source_timeout = options.number("source_timeout", 1.0);
+        const auto timeout_ns = [&](const char *name) { return static_cast<int64_t>(options.number(name, source_timeout) * 1e9); };
+        config.pose_source_timeouts_ns = {timeout_ns("sources.lidar.timeout"), timeout_ns("sources.gnss.timeout")};
+        config.twist_source_timeouts_ns = {timeout_ns("sources.ekf.timeout"), timeout_ns("sources.filter.timeout")};
+        const double output_rate = options.number("output_rate_hz", 100.0);
+        config.output_period_ns = output_rate > 0.0 ? static_cast<int64_t>(1e9 / output_rate) : 0;
+        config.output_deadline_ns = static_cast<int64_t>(options.number("output_deadline", 0.0) * 1e9);
+        config.output_extrapolate = options.flag("output_extrapolate", true);
+        config.output_max_extrapolation_ns = static_cast<int64_t>(options.number("output_max_extrapolation", 0.5) * 1e9);
+        config.ekf_process_noise_position = options.number("ekf_process_noise_position", config.ekf_process_noise_position);
+        config.ekf_process_noise_orientation = options.number("ekf_process_noise_orientation", config.ekf_process_noise_orientation);
+        config.gate_chi_square = options.number("gate_chi_square", 0.0);
+        config.gate_downweight = options.text("gate_mode", "reject") == "downweight";
+        config.change_epsilon = options.number("change_epsilon", 0.0);
+        engine_.configure(config);
+
+        const std::string map_frame = options.text("map_frame", "map");
+        const std::string odom_frame = options.text("odom_frame", "odom");
+        final_pose_.header.frame_id = map_frame;
+        fused_twist_.header.frame_id = base_frame_;
+
+        const std::string tf_mode = options.text("tf_mode", "single");
+        if (tf_mode == "batch")
+        {
+            tf_message_.transforms.resize(2);
+            tf_message_.transforms[0].header.frame_id = map_frame;
+            tf_message_.transforms[0].child_frame_id = odom_frame;
+            tf_message_.transforms[1].header.frame_id = odom_frame;
+            tf_message_.transforms[1].child_frame_id = base_frame_;
+        }
+        else if (tf_mode == "single")
+        {
+            tf_message_.transforms.resize(1);
+            tf_message_.transforms[0].header.frame_id = map_frame;
+            tf_message_.transforms[0].child_frame_id = base_frame_;
+        }
+        else if (tf_mode != "none")
+        {
+            std::fprintf(stderr, "Unknown tf_mode '%s', using 'none'\n", tf_mode.c_str());
+        }
+    }
+
+    bool run(const std::string &input_uri, const std::string &output_uri)
+    {
+        rosbag2_cpp::Reader reader;
+        reader.open(input_uri);
+        if (!checkTopics(reader))
+        {
+            return false;
+        }
+        writer_.open(output_uri);
+
+        const auto wall_start = std::chrono::steady_clock::now();
+        uint64_t sequence = 0;
+        while (reader.has_next())
+        {
+            const std::shared_ptr<rosbag2_storage::SerializedBagMessage> bag_message = reader.read_next();
+            QueuedMessage queued;
+            queued.sequence = sequence++;
+            if (bag_message->topic_name == gnss_topic_)
+            {
+                queued.message = deserialize<geometry_msgs::msg::PoseStamped>(*bag_message);
+                queued.stamp_ns = toNanoseconds(std::get<geometry_msgs::msg::PoseStamped>(queued.message).header.stamp);
+            }
+            else if (bag_message->topic_name == lidar_topic_)
+            {
+                queued.message = deserialize<geometry_msgs::msg::PoseWithCovarianceStamped>(*bag_message);
+                queued.stamp_ns = toNanoseconds(std::get<geometry_msgs::msg::PoseWithCovarianceStamped>(queued.message).header.stamp);
+            }
+            else if (bag_message->topic_name == ekf_twist_topic_)
+            {
+                queued.message = deserialize<geometry_msgs::msg::TwistWithCovarianceStamped>(*bag_message);
+                queued.stamp_ns = toNanoseconds(std::get<geometry_msgs::msg::TwistWithCovarianceStamped>(queued.message).header.stamp);
+            }
+            else
+            {
+                // Static transforms apply from the time they are read, like the node's TF lookup
+                if (bag_message->topic_name == tf_static_topic_ && !projector_.antenna_to_base_cached())
+                {
+                    cacheAntennaTransform(deserialize<tf2_msgs::msg::TFMessage>(*bag_message));
+                }
+                continue;
+            }
+            ++messages_read_;
+
+            newest_stamp_ns_ = std::max(newest_stamp_ns_, queued.stamp_ns);
+            queue_.push(std::move(queued));
+            while (!queue_.empty() && queue_.top().stamp_ns <= newest_stamp_ns_ - reorder_window_ns_)
+            {
+                process(queue_.top());
+                queue_.pop();
+            }
+        }
+        while (!queue_.empty())
+        {
+            process(queue_.top());
+            queue_.pop();
+        }
+        // Ticks up to and including the last input stamp
+        if (last_stamp_ns_ != std::numeric_limits<int64_t>::min())
+        {
+            runOutput(last_stamp_ns_ + 1);
+        }
+
+        const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        report(wall_s);
+        if (!projector_.antenna_to_base_cached())
+        {
+            std::fprintf(stderr, "No %s -> %s transform on %s, /fix_pose holds the %s position\n",
+                         base_frame_.c_str(), gnss_frame_.c_str(), tf_static_topic_.c_str(), gnss_frame_.c_str());
+        }
+        return true;
+    }
+
+private:
+    struct QueuedMessage
+    {
+        int64_t stamp_ns = 0;
+        uint64_t sequence = 0;  // bag order among equal stamps
+        std::variant<geometry_msgs::msg::PoseStamped, geometry_msgs::msg::PoseWithCovarianceStamped,
+                     geometry_msgs::msg::TwistWithCovarianceStamped> message;
+    };
+
+    // Min-heap on (stamp, bag order)
+    struct LaterFirst
+    {
+        bool operator()(const QueuedMessage &a, const QueuedMessage &b) const
+        {
+            return a.stamp_ns != b.stamp_ns ? a.stamp_ns > b.stamp_ns : a.sequence > b.sequence;
+        }
+    };
+
+    bool checkTopics(rosbag2_cpp::Reader &reader) const
+    {
+        const std::map<std::string, std::string> expected = {
+            {gnss_topic_, "geometry_msgs/msg/PoseStamped"},
+            {lidar_topic_, "geometry_msgs/msg/PoseWithCovarianceStamped"},
+            {ekf_twist_topic_, "geometry_msgs/msg/TwistWithCovarianceStamped"},
+            {tf_static_topic_, "tf2_msgs/msg/TFMessage"}};
+
+        std::map<std::string, std::string> found;
+        for (const auto &topic : reader.get_all_topics_and_types())
+        {
+            found[topic.name] = topic.type;
+        }
+
+        bool ok = true;
+        for (const auto &entry : expected)
+        {
+            const auto it = found.find(entry.first);
+            if (it == found.end())
+            {
+                std::fprintf(stderr, "Input bag has no %s\n", entry.first.c_str());
+            }
+            else if (it->second != entry.second)
+            {
+                std::fprintf(stderr, "%s is %s, expected %s\n", entry.first.c_str(), it->second.c_str(), entry.second.c_str());
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    void cacheAntennaTransform(const tf2_msgs::msg::TFMessage &tf_message)
+    {
+        for (const auto &transform : tf_message.transforms)
+        {
+            if (transform.header.frame_id != base_frame_ || transform.child_frame_id != gnss_frame_)
+            {
+                continue;
+            }
+            const auto &t = transform.transform;
+            Eigen::Isometry3d base_to_antenna = Eigen::Isometry3d::Identity();
+            base_to_antenna.translation() << t.translation.x, t.translation.y, t.translation.z;
+            base_to_antenna.linear() = Eigen::Quaterniond(t.rotation.w, t.rotation.x, t.rotation.y, t.rotation.z)
+                                           .normalized().toRotationMatrix();
+            projector_.set_antenna_to_base(base_to_antenna.inverse());
+            return;
+        }
+    }
+
+    void process(const QueuedMessage &queued)
+    {
+        if (queued.stamp_ns < last_stamp_ns_)
+        {
+            // Older than reorder_window behind the newest stamp: processed out of order
+            ++messages_late_;
+        }
+        else
+        {
+            // Ticks stamped before this message only see the inputs up to their grid time
+            runOutput(queued.stamp_ns);
+            last_stamp_ns_ = queued.stamp_ns;
+        }
+        if (first_stamp_ns_ == std::numeric_limits<int64_t>::min())
+        {
+            first_stamp_ns_ = queued.stamp_ns;
+        }
+
+        if (const auto *gnss = std::get_if<geometry_msgs::msg::PoseStamped>(&queued.message))
+        {
+            processGnss(queued.stamp_ns, *gnss);
+        }
+        else if (const auto *lidar = std::get_if<geometry_msgs::msg::PoseWithCovarianceStamped>(&queued.message))
+        {
+            handlePoseUpdate(engine_.addPose(kLidarSource, queued.stamp_ns, lidar->pose, queued.stamp_ns));
+        }
+        else if (const auto *ekf_twist = std::get_if<geometry_msgs::msg::TwistWithCovarianceStamped>(&queued.message))
+        {
+            handleTwistUpdate(engine_.addTwist(kEkfTwistSource, queued.stamp_ns, ekf_twist->twist, queued.stamp_ns));
+        }
+    }
+
+    // /gnss_pose -> /gnss_pose_with_covariance (+ /fix_twist) -> /fix_pose -> fusion
+    void processGnss(int64_t stamp_ns, const geometry_msgs::msg::PoseStamped &gnss)
+    {
+        gnss_pose_.header = gnss.header;
+        gnss_pose_.pose.pose = gnss.pose;
+        const bool twist_valid = processor_.process(stamp_ns, gnss.pose, gnss_pose_.pose.covariance, twist_, fix_twist_.twist.covariance);
+        write(gnss_pose_, "/gnss_pose_with_covariance", stamp_ns);
+
+        fix_pose_.header.stamp = gnss.header.stamp;
+        projector_.project(gnss_pose_.pose, fix_pose_.pose);
+        write(fix_pose_, "/fix_pose", stamp_ns);
+        handlePoseUpdate(engine_.addPose(kGnssSource, stamp_ns, fix_pose_.pose, stamp_ns));
+
+        if (!twist_valid)
+        {
+            return;
+        }
+        fix_twist_.header.stamp = gnss.header.stamp;
+        fix_twist_.twist.twist.linear.x = twist_[0];
+        fix_twist_.twist.twist.linear.y = twist_[1];
+        fix_twist_.twist.twist.linear.z = twist_[2];
+        fix_twist_.twist.twist.angular.x = twist_[3];
+        fix_twist_.twist.twist.angular.y = twist_[4];
+        fix_twist_.twist.twist.angular.z = twist_[5];
+        write(fix_twist_, "/fix_twist", stamp_ns);
+        handleTwistUpdate(engine_.addTwist(kFilterTwistSource, stamp_ns, fix_twist_.twist, stamp_ns));
+    }
+
+    void handlePoseUpdate(const PoseUpdate &update)
+    {
+        fallbacks_ += update.fallback ? 1 : 0;
+        ekf_rejected_ += update.ekf_rejected ? 1 : 0;
+        ekf_late_ += update.ekf_late ? 1 : 0;
+        gated_ += update.gated ? 1 : 0;
+        downweighted_ += update.downweighted ? 1 : 0;
+        unchanged_ += update.fused && !update.changed ? 1 : 0;
+        if (update.changed && !engine_.scheduledOutput())
+        {
+            final_pose_.pose = engine_.fusedPose();
+            writeFinalPose(update.stamp_ns);
+        }
+    }
+
+    void handleTwistUpdate(const TwistUpdate &update)
+    {
+        fallbacks_ += update.fallback ? 1 : 0;
+        unchanged_ += update.fused && !update.changed ? 1 : 0;
+        if (update.changed)
+        {
+            fused_twist_.header.stamp = rclcpp::Time(update.stamp_ns);
+            fused_twist_.twist = engine_.fusedTwist();
+            write(fused_twist_, "/fused_twist", update.stamp_ns);
+        }
+    }
+
+    // Output ticks at the grid times before until_ns
+    void runOutput(int64_t until_ns)
+    {
+        if (!engine_.scheduledOutput())
+        {
+            return;
+        }
+        const int64_t period_ns = engine_.config().output_period_ns;
+        if (next_output_ns_ == std::numeric_limits<int64_t>::min())
+        {
+            next_output_ns_ = until_ns;
+        }
+        // Across a gap in the inputs longer than the extrapolation limit every tick would be
+        // stale (or a pure EKF prediction); resume the grid shortly before until_ns
+        const int64_t max_gap_ns = std::max(engine_.config().output_max_extrapolation_ns, period_ns);
+        if (until_ns - next_output_ns_ > max_gap_ns)
+        {
+            next_output_ns_ += (until_ns - next_output_ns_ - max_gap_ns) / period_ns * period_ns;
+        }
+
+        StateVector state;
+        StateMatrix covariance;
+        for (; next_output_ns_ < until_ns; next_output_ns_ += period_ns)
+        {
+            const OutputResult output = engine_.output(next_output_ns_, state, covariance);
+            stale_outputs_ += output.stale ? 1 : 0;
+            if (!output.valid)
+            {
+                continue;
+            }
+            statePose(state, final_pose_.pose.pose);
+            covarianceMap(final_pose_.pose.covariance) = covariance;
+            writeFinalPose(output.tick.stamp_ns);
+        }
+    }
+
+    void writeFinalPose(int64_t stamp_ns)
+    {
+        final_pose_.header.stamp = rclcpp::Time(stamp_ns);
+        write(final_pose_, "/final/pose_with_covariance", stamp_ns);
+
+        if (tf_message_.transforms.empty())
+        {
+            return;
+        }
+        const geometry_msgs::msg::Pose &pose = final_pose_.pose.pose;
+        geometry_msgs::msg::TransformStamped &first = tf_message_.transforms[0];
+        first.header.stamp = final_pose_.header.stamp;
+        if (tf_message_.transforms.size() == 1)
+        {
+            first.transform.translation.x = pose.position.x;
+            first.transform.translation.y = pose.position.y;
+            first.transform.translation.z = pose.position.z;
+            first.transform.rotation = pose.orientation;
+        }
+        else
+        {
+            const StateVector &odom_state = engine_.advanceOdometry(stamp_ns);
+            const Eigen::Isometry3d map_to_odom = mapToOdom(pose, odom_state);
+            const Eigen::Quaterniond map_to_odom_rotation(map_to_odom.rotation());
+            first.transform.translation.x = map_to_odom.translation().x();
+            first.transform.translation.y = map_to_odom.translation().y();
+            first.transform.translation.z = map_to_odom.translation().z();
+            first.transform.rotation.x = map_to_odom_rotation.x();
+            first.transform.rotation.y = map_to_odom_rotation.y();
+            first.transform.rotation.z = map_to_odom_rotation.z();
+            first.transform.rotation.w = map_to_odom_rotation.w();
+
+            geometry_msgs::msg::TransformStamped &odom_base = tf_message_.transforms[1];
+            const Eigen::Quaterniond odom_to_base_rotation = PoseTwistModel::quaternion(odom_state);
+            odom_base.header.stamp = final_pose_.header.stamp;
+            odom_base.transform.translation.x = odom_state(0);
+            odom_base.transform.translation.y = odom_state(1);
+            odom_base.transform.translation.z = odom_state(2);
+            odom_base.transform.rotation.x = odom_to_base_rotation.x();
+            odom_base.transform.rotation.y = odom_to_base_rotation.y();
+            odom_base.transform.rotation.z = odom_to_base_rotation.z();
+            odom_base.transform.rotation.w = odom_to_base_rotation.w();
+        }
+        write(tf_message_, "/tf", stamp_ns);
+    }
+
+    template <typename MessageT>
+    void write(const MessageT &message, const std::string &topic, int64_t stamp_ns)
+    {
+        writer_.write(message, topic, rclcpp::Time(stamp_ns));
+        ++messages_written_[topic];
+    }
+
+    void report(double wall_s) const
+    {
+        const double bag_s = last_stamp_ns_ > first_stamp_ns_ ? static_cast<double>(last_stamp_ns_ - first_stamp_ns_) * 1e-9 : 0.0;
+        std::printf("Read %llu input messages (%llu out of stamp order), %.1f s of data in %.2f s wall time (%.0fx real time)\n",
+                    static_cast<unsigned long long>(messages_read_), static_cast<unsigned long long>(messages_late_),
+                    bag_s, wall_s, wall_s > 0.0 ? bag_s / wall_s : 0.0);
+        for (const auto &entry : messages_written_)
+        {
+            std::printf("  %-30s %llu\n", entry.first.c_str(), static_cast<unsigned long long>(entry.second));
+        }
+        std::printf("Stale outputs: %llu, weighted fallbacks: %llu, rejected EKF updates: %llu, late EKF updates: %llu\n",
+                    static_cast<unsigned long long>(stale_outputs_), static_cast<unsigned long long>(fallbacks_),
+                    static_cast<unsigned long long>(ekf_rejected_), static_cast<unsigned long long>(ekf_late_));
+        std::printf("Gated poses: %llu, downweighted poses: %llu, unchanged fusions: %llu\n", static_cast<unsigned long long>(gated_),
+                    static_cast<unsigned long long>(downweighted_), static_cast<unsigned long long>(unchanged_));
+        const SourceWatchdog &watchdog = engine_.watchdog();
+        if (watchdog.enabled())
+        {
+            const char *names[] = {"lidar_pose", "gnss_pose", "ekf_twist", "filter_twist"};
+            std::printf("Source timeouts:");
+            for (std::size_t i = 0; i < watchdog.size(); ++i)
+            {
+                std::printf(" %s %llu", names[i], static_cast<unsigned long long>(watchdog.timeouts(i)));
+            }
+            std::printf("\n");
+        }
+    }
+
+    using StateVector = typename PoseFusionEngine<Strategy>::StateVector;
+    using StateMatrix = typename PoseFusionEngine<Strategy>::StateMatrix;
+
+    // Source slots of the engine, in the order of the default pose_fusion_node sources
+    static constexpr std::size_t kLidarSource = 0;
+    static constexpr std::size_t kGnssSource = 1;
+    static constexpr std::size_t kEkfTwistSource = 0;
+    static constexpr std::size_t kFilterTwistSource = 1;
+
+    std::string gnss_topic_;
+    std::string lidar_topic_;
+    std::string ekf_twist_topic_;
+    std::string tf_static_topic_;
+    std::string gnss_frame_;
+    std::string base_frame_;
+    int64_t reorder_window_ns_ = 0;
+
+    // The processing of the three nodes
+    GnssPoseProcessor processor_;
+    GnssPoseProjector projector_;
+    PoseFusionEngine<Strategy> engine_;
+
+    std::priority_queue<QueuedMessage, std::vector<QueuedMessage>, LaterFirst> queue_;
+    int64_t newest_stamp_ns_ = std::numeric_limits<int64_t>::min();
+    int64_t first_stamp_ns_ = std::numeric_limits<int64_t>::min();
+    int64_t last_stamp_ns_ = std::numeric_limits<int64_t>::min();
+    int64_t next_output_ns_ = std::numeric_limits<int64_t>::min();
+
+    // Output messages, reused; the frame ids are set once in the constructor
+    geometry_msgs::msg::PoseWithCovarianceStamped gnss_pose_;
+    geometry_msgs::msg::PoseWithCovarianceStamped fix_pose_;
+    geometry_msgs::msg::TwistWithCovarianceStamped fix_twist_;
+    Vector6 twist_;
+    geometry_msgs::msg::PoseWithCovarianceStamped final_pose_;
+    geometry_msgs::msg::TwistWithCovarianceStamped fused_twist_;
+    tf2_msgs::msg::TFMessage tf_message_;
+
+    rosbag2_cpp::Writer writer_;
+
+    uint64_t messages_read_ = 0;
+    uint64_t messages_late_ = 0;
+    uint64_t stale_outputs_ = 0;
+    uint64_t fallbacks_ = 0;
+    uint64_t ekf_rejected_ = 0;
+    uint64_t ekf_late_ = 0;
+    uint64_t gated_ = 0;
+    uint64_t downweighted_ = 0;
+    uint64_t unchanged_ = 0;
+    std::map<std::string, uint64_t> messages_written_;
+};
+
+template <typename Strategy>
+int runReplay(ToolOptions &options, const std::string &input_bag, const std::string &output_bag)
+{
+    LocalizationReplay<Strategy> replay(options);
+    options.warnUnused();
+    return replay.run(input_bag, output_bag) ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "Usage: %s <input_bag> <output_bag> [key:=value ...]\n", argv[0]);
+        return 2;
+    }
+
+    ToolOptions options;
+    if (!options.parse(std::vector<std::string>(argv, argv + argc), 3))
+    {
+        return 2;
+    }
+
+    try
+    {
+        // "information" (inverse-covariance), "weighted" (fixed weights) or "ekf"
+        const std::string fusion_mode = options.text("fusion_mode", "information");
+        if (fusion_mode == "weighted")
+        {
+            return runReplay<WeightedFusion>(options, argv[1], argv[2]);
+        }
+        if (fusion_mode == "ekf")
+        {
+            return runReplay<EkfFusion>(options, argv[1], argv[2]);
+        }
+        if (fusion_mode != "information")
+        {
+            std::fprintf(stderr, "Unknown fusion_mode '%s', using 'information'\n", fusion_mode.c_str());
+        }
+        return runReplay<InformationFusion>(options, argv[1], argv[2]);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "Replay failed: %s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,541 @@
+#include <ament_index_cpp/get_package_share_directory.hpp>
+#include <ament_index_cpp/get_resource.hpp>
+#include <class_loader/class_loader.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_components/node_factory.hpp>
+#include <rclcpp_components/node_instance_wrapper.hpp>
+#include <geometry_msgs/msg/pose_stamped.hpp>
+#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
+#include <geometry_msgs/msg/transform_stamped.hpp>
+#include <geometry_msgs/msg/twist_with_covariance_stamped.hpp>
+#include <rosgraph_msgs/msg/clock.hpp>
+#include <tf2_ros/static_transform_broadcaster.hpp>
+
+#include <gnss2map/utm_projection.hpp>
+#include <localization_tools/stress_harness.hpp>
+#include <localization_tools/tool_options.hpp>
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Load test of pose_covariance_publisher, gnss2map and pose_fusion_node in one process on
+// simulated time:
+//
+//   localization_stress [key:=value ...] [--ros-args ...]
+//
+// The three components are loaded from their plugin libraries (as component_container
+// does) with use_sim_time, each on its own SingleThreadedExecutor thread. The harness
+// publishes /clock in clock_step increments, paced at real_time_factor (0: as fast as
+// the CPU allows), and after every step the samples of the synthetic sensors that are due:
+//   /gnss_pose                                    (gnss.*: latitude, longitude, altitude)
+//   /localization/pose_with_covariance            (lidar.*: the same truth in the map frame)
+//   /localization/pose_twist_fusion_filter/twist_with_covariance   (twist.*)
+// with the rates, noise and dropout patterns of SensorSchedule. The truth is a circle
+// (radius, speed) at origin_latitude / origin_longitude; every random draw comes from
+// seed, so a run always sends the same messages. base_link -> gnss is an identity on
+// /tf_static.
+//
+// After warmup [s of simulated time], every output is timed against the wall time at which
+// the clock reached its stamp, i.e. the transport, queueing and processing delay of the
+// pipeline behind the sample. The report lists per output the delivered rate and the
+// latency percentiles, per thread name the CPU load (the components' executor threads are
+// named after them), and the real-time factor reached. A component is saturated when its
+// CPU approaches 100 % and its latency grows without bound; raise the rates or
+// real_time_factor to find that point. report_csv appends the rows to a file for sweeps.
+//
+// Component parameters come from <name>_params (default: the package's config file) with
+// state_file disabled, so no run warm-starts from another.
+
+namespace
+{
+
+using PoseMsg = geometry_msgs::msg::PoseStamped;
+using PoseCovMsg = geometry_msgs::msg::PoseWithCovarianceStamped;
+using TwistCovMsg = geometry_msgs::msg::TwistWithCovarianceStamped;
+
+int64_t steadyNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void nameThread(const char *name)
+{
+    pthread_setname_np(pthread_self(), name);
+}
+
+// A component instantiated from its rclcpp_components plugin. The node is destroyed
+// before its library is unloaded.
+class LoadedComponent
+{
+public:
+    LoadedComponent(const std::string &package, const std::string &plugin, const rclcpp::NodeOptions &options)
+    {
+        std::string resources;
+        std::string prefix;
+        if (!ament_index_cpp::get_resource("rclcpp_components", package, resources, &prefix))
+        {
+            throw std::runtime_error("package " + package + " registers no components");
+        }
+
+        // One "<class>;<library>" line per component, the library relative to the prefix
+        std::istringstream lines(resources);
+        std::string line;
+        std::string library;
+        while (std::getline(lines, line))
+        {
+            const std::size_t separator = line.find(';');
+            if (separator != std::string::npos && line.substr(0, separator) == plugin)
+            {
+                library = line.substr(separator + 1);
+                if (!library.empty() && library.front() != '/')
+                {
+                    library = prefix + "/" + library;
+                }
+                break;
+            }
+        }
+        if (library.empty())
+        {
+            throw std::runtime_error("package " + package + " has no component " + plugin);
+        }
+
+        loader_ = std::make_unique<class_loader::ClassLoader>(library);
+        const auto factory = loader_->createInstance<rclcpp_components::NodeFactory>("rclcpp_components::NodeFactoryTemplate<" + plugin + ">");
+        node_ = factory->create_node_instance(options);
+    }
+
+    ~LoadedComponent() { node_ = rclcpp_components::NodeInstanceWrapper(); }
+
+    rclcpp::node_interfaces::NodeBaseInterface::SharedPtr node() { return node_.get_node_base_interface(); }
+
+private:
+    std::unique_ptr<class_loader::ClassLoader> loader_;
+    rclcpp_components::NodeInstanceWrapper node_;
+};
+
+// Executor thread named after what it runs, so its CPU time can be told apart
+class ExecutorThread
+{
+public:
+    ExecutorThread(const std::string &name, rclcpp::node_interfaces::NodeBaseInterface::SharedPtr node) : name_(name)
+    {
+        executor_.add_node(node);
+        thread_ = std::thread([this]()
+        {
+            nameThread(name_.c_str());
+            executor_.spin();
+        });
+    }
+
+    ~ExecutorThread()
+    {
+        executor_.cancel();
+        thread_.join();
+    }
+
+private:
+    std::string name_;
+    rclcpp::executors::SingleThreadedExecutor executor_;
+    std::thread thread_;
+};
+
+// Latency of one output topic against the simulated clock
+class OutputProbe
+{
+public:
+    OutputProbe(const std::string &topic, const std::string &component, const ClockHistory &clock, int64_t measure_from_ns,
+                std::size_t expected)
+        : topic_(topic), component_(component), clock_(clock), measure_from_ns_(measure_from_ns)
+    {
+        latencies_ns_.reserve(expected);
+    }
+
+    template <typename MessageT>
+    void subscribe(rclcpp::Node &node)
+    {
+        subscription_ = node.create_subscription<MessageT>(topic_, rclcpp::QoS(100), [this](const typename MessageT::ConstSharedPtr message)
+                                                           { record(rclcpp::Time(message->header.stamp).nanoseconds()); });
+    }
+
+    const std::string &topic() const { return topic_; }
+    const std::string &component() const { return component_; }
+    // Only read once the probe thread stopped
+    uint64_t received() const { return received_; }
+    const std::vector<int64_t> &latencies() const { return latencies_ns_; }
+
+private:
+    void record(int64_t stamp_ns)
+    {
+        const int64_t now_ns = steadyNow();
+        if (stamp_ns < measure_from_ns_)
+        {
+            return;
+        }
+        ++received_;
+        const int64_t available_ns = clock_.wallAt(stamp_ns);
+        if (available_ns != ClockHistory::kUnset)
+        {
+            latencies_ns_.push_back(std::max<int64_t>(now_ns - available_ns, 0));
+        }
+    }
+
+    std::string topic_;
+    std::string component_;
+    const ClockHistory &clock_;
+    int64_t measure_from_ns_;
+    uint64_t received_ = 0;
+    std::vector<int64_t> latencies_ns_;
+    rclcpp::SubscriptionBase::SharedPtr subscription_;
+};
+
+template <typename MessageT>
+void addProbe(std::vector<std::unique_ptr<OutputProbe>> &probes, rclcpp::Node &node, const std::string &topic, const std::string &component,
+              const ClockHistory &clock, int64_t measure_from_ns, std::size_t expected)
+{
+    probes.push_back(std::make_unique<OutputProbe>(topic, component, clock, measure_from_ns, expected));
+    probes.back()->subscribe<MessageT>(node);
+}
+
+rclcpp::NodeOptions componentOptions(ToolOptions &options, const std::string &name, const std::string &package, const std::string &file,
+                                     bool intra_process, const std::vector<std::string> &remaps)
+{
+    // "none": the node's defaults
+    std::string params = options.text(name + "_params", "");
+    if (params.empty())
+    {
+        params = ament_index_cpp::get_package_share_directory(package) + "/config/" + file;
+    }
+
+    std::vector<std::string> arguments = {"--ros-args"};
+    if (params != "none")
+    {
+        arguments.insert(arguments.end(), {"--params-file", params});
+    }
+    for (const std::string &remap : remaps)
+    {
+        arguments.insert(arguments.end(), {"-r", remap});
+    }
+
+    rclcpp::NodeOptions node_options;
+    node_options.use_intra_process_comms(intra_process);
+    node_options.arguments(arguments);
+    // Overrides take precedence over the parameter file
+    node_options.parameter_overrides({rclcpp::Parameter("use_sim_time", true), rclcpp::Parameter("state_file", std::string(""))});
+    return node_options;
+}
+
+void setDiagonal(std::array<double, 36> &covariance, double linear_variance, double angular_variance)
+{
+    covariance.fill(0.0);
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        covariance[i * 7] = linear_variance;
+        covariance[(i + 3) * 7] = angular_variance;
+    }
+}
+
+void setYaw(geometry_msgs::msg::Quaternion &orientation, double yaw)
+{
+    orientation.x = 0.0;
+    orientation.y = 0.0;
+    orientation.z = std::sin(0.5 * yaw);
+    orientation.w = std::cos(0.5 * yaw);
+}
+
+int runStress(ToolOptions &options)
+{
+    const double duration = std::max(options.number("duration", 30.0), 0.0);
+    const double warmup = std::min(std::max(options.number("warmup", 2.0), 0.0), duration);
+    const double real_time_factor = options.number("real_time_factor", 1.0);
+    const int64_t clock_step_ns = std::max<int64_t>(static_cast<int64_t>(options.number("clock_step", 0.001) * 1e9), 1000);
+    // Wall time [s] for discovery before the run and for in-flight messages after it
+    const auto settle = std::chrono::duration<double>(options.number("settle", 1.0));
+    const bool intra_process = options.flag("use_intra_process_comms", true);
+    const uint64_t seed = static_cast<uint64_t>(options.number("seed", 42.0));
+    const std::string report_csv = options.text("report_csv", "");
+
+    const CircleTrajectory trajectory(options.number("origin_latitude", 37.5665), options.number("origin_longitude", 126.978),
+                                      options.number("radius", 50.0), options.number("speed", 10.0));
+    const double altitude = options.number("altitude", 40.0);
+
+    // <name>.noise: position sigma [m] of the poses (orientation exact), linear [m/s] and
+    // angular [rad/s] sigma of the twist
+    std::vector<SensorSchedule> sensors;
+    sensors.emplace_back("gnss", options, 10.0, 0.5, seed);
+    sensors.emplace_back("lidar", options, 10.0, 0.05, seed + 1);
+    sensors.emplace_back("twist", options, 50.0, 0.05, seed + 2);
+    SensorSchedule &gnss = sensors[0];
+    SensorSchedule &lidar = sensors[1];
+    SensorSchedule &twist = sensors[2];
+    for (const SensorSchedule &sensor : sensors)
+    {
+        if (sensor.enabled() && sensor.period() < clock_step_ns)
+        {
+            std::fprintf(stderr, "%s.rate is above the clock rate, sending one sample per clock_step\n", sensor.name().c_str());
+        }
+    }
+
+    std::vector<std::unique_ptr<LoadedComponent>> components;
+    components.push_back(std::make_unique<LoadedComponent>(
+        "pose_covariance_publisher", "PoseCovariancePublisher",
+        componentOptions(options, "covariance", "pose_covariance_publisher", "pose_covariance_publisher.param.yaml", intra_process, {})));
+    components.push_back(std::make_unique<LoadedComponent>(
+        "gnss2map", "Gnss_to_map",
+        componentOptions(options, "gnss2map", "gnss2map", "map_info.param.yaml", intra_process,
+                         {"/gnss_pose:=/gnss_pose_with_covariance", "/gnss2map:=/fix_pose"})));
+    components.push_back(std::make_unique<LoadedComponent>(
+        "pose_fusion", "PoseFusionNode",
+        componentOptions(options, "pose_fusion", "pose_fusion", "pose_fusion.param.yaml", intra_process, {})));
+    options.warnUnused();
+
+    auto harness = std::make_shared<rclcpp::Node>("localization_stress", rclcpp::NodeOptions().use_intra_process_comms(intra_process));
+    auto probe_node = std::make_shared<rclcpp::Node>("localization_stress_probe", rclcpp::NodeOptions().use_intra_process_comms(intra_process));
+
+    auto clock_pub = harness->create_publisher<rosgraph_msgs::msg::Clock>("/clock", rclcpp::ClockQoS());
+    auto gnss_pub = harness->create_publisher<PoseMsg>("/gnss_pose", rclcpp::QoS(10));
+    auto lidar_pub = harness->create_publisher<PoseCovMsg>("/localization/pose_with_covariance", rclcpp::QoS(10));
+    auto twist_pub = harness->create_publisher<TwistCovMsg>("/localization/pose_twist_fusion_filter/twist_with_covariance", rclcpp::QoS(10));
+
+    tf2_ros::StaticTransformBroadcaster static_broadcaster(harness);
+    geometry_msgs::msg::TransformStamped base_to_gnss;
+    base_to_gnss.header.frame_id = "base_link";
+    base_to_gnss.child_frame_id = "gnss";
+    base_to_gnss.transform.rotation.w = 1.0;
+    static_broadcaster.sendTransform(base_to_gnss);
+
+    // Simulated time starts away from zero, which the nodes treat as "no clock yet"
+    const int64_t start_ns = 1000000000000;
+    const std::size_t steps = static_cast<std::size_t>(duration * 1e9 / static_cast<double>(clock_step_ns)) + 1;
+    const int64_t measure_from_ns = start_ns + static_cast<int64_t>(warmup * 1e9);
+    ClockHistory clock(start_ns, clock_step_ns, steps);
+
+    // Storage for a 1 kHz output; grows beyond that
+    const std::size_t expected = static_cast<std::size_t>((duration - warmup) * 1000.0) + 1024;
+    std::vector<std::unique_ptr<OutputProbe>> probes;
+    addProbe<PoseCovMsg>(probes, *probe_node, "/gnss_pose_with_covariance", "covariance", clock, measure_from_ns, expected);
+    addProbe<TwistCovMsg>(probes, *probe_node, "/fix_twist", "covariance", clock, measure_from_ns, expected);
+    addProbe<PoseCovMsg>(probes, *probe_node, "/fix_pose", "gnss2map", clock, measure_from_ns, expected);
+    addProbe<PoseCovMsg>(probes, *probe_node, "/final/pose_with_covariance", "pose_fusion", clock, measure_from_ns, expected);
+    addProbe<TwistCovMsg>(probes, *probe_node, "/fused_twist", "pose_fusion", clock, measure_from_ns, expected);
+
+    // The thread names are what the CPU report groups by
+    std::vector<std::unique_ptr<ExecutorThread>> executors;
+    executors.push_back(std::make_unique<ExecutorThread>("covariance", components[0]->node()));
+    executors.push_back(std::make_unique<ExecutorThread>("gnss2map", components[1]->node()));
+    executors.push_back(std::make_unique<ExecutorThread>("pose_fusion", components[2]->node()));
+    executors.push_back(std::make_unique<ExecutorThread>("stress_probe", probe_node->get_node_base_interface()));
+    nameThread("stress_clock");
+
+    rosgraph_msgs::msg::Clock clock_msg;
+    clock_msg.clock = rclcpp::Time(start_ns);
+    clock_pub->publish(clock_msg);
+    std::this_thread::sleep_for(settle);
+
+    UtmProjection projection;
+    for (SensorSchedule &sensor : sensors)
+    {
+        sensor.start(start_ns);
+    }
+    std::map<std::string, double> cpu_before;
+    int64_t measure_wall_ns = 0;
+    uint64_t late_steps = 0;
+    const int64_t wall_start_ns = steadyNow();
+    for (std::size_t step = 0; step < steps; ++step)
+    {
+        const int64_t time_ns = start_ns + static_cast<int64_t>(step) * clock_step_ns;
+        if (real_time_factor > 0.0)
+        {
+            const int64_t target_ns = wall_start_ns + static_cast<int64_t>(static_cast<double>(time_ns - start_ns) / real_time_factor);
+            const int64_t now_ns = steadyNow();
+            if (now_ns < target_ns)
+            {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(target_ns - now_ns));
+            }
+            else if (now_ns - target_ns > clock_step_ns)
+            {
+                ++late_steps;
+            }
+        }
+        if (measure_wall_ns == 0 && time_ns >= measure_from_ns)
+        {
+            cpu_before = threadCpuSeconds();
+            measure_wall_ns = steadyNow();
+        }
+
+        clock.record(step, steadyNow());
+        clock_msg.clock = rclcpp::Time(time_ns);
+        clock_pub->publish(clock_msg);
+
+        const builtin_interfaces::msg::Time stamp = rclcpp::Time(time_ns);
+        const CircleTrajectory::State truth = trajectory.at(static_cast<double>(time_ns - start_ns) * 1e-9);
+        if (gnss.due(time_ns))
+        {
+            auto message = std::make_unique<PoseMsg>();
+            message->header.stamp = stamp;
+            message->header.frame_id = "gnss";
+            trajectory.geodetic(truth.east + gnss.noise(1.0), truth.north + gnss.noise(1.0), message->pose.position.x,
+                                message->pose.position.y);
+            message->pose.position.z = altitude + gnss.noise(1.0);
+            setYaw(message->pose.orientation, truth.yaw);
+            gnss_pub->publish(std::move(message));
+        }
+        if (lidar.due(time_ns))
+        {
+            double latitude = 0.0;
+            double longitude = 0.0;
+            trajectory.geodetic(truth.east, truth.north, latitude, longitude);
+            auto message = std::make_unique<PoseCovMsg>();
+            message->header.stamp = stamp;
+            message->header.frame_id = "map";
+            projection.to_map(latitude, longitude, message->pose.pose.position.x, message->pose.pose.position.y);
+            message->pose.pose.position.x += lidar.noise(1.0);
+            message->pose.pose.position.y += lidar.noise(1.0);
+            message->pose.pose.position.z = altitude + lidar.noise(1.0);
+            setYaw(message->pose.pose.orientation, truth.yaw);
+            setDiagonal(message->pose.covariance, std::max(lidar.noise() * lidar.noise(), 1e-6), 1e-4);
+            lidar_pub->publish(std::move(message));
+        }
+        if (twist.due(time_ns))
+        {
+            auto message = std::make_unique<TwistCovMsg>();
+            message->header.stamp = stamp;
+            message->header.frame_id = "base_link";
+            message->twist.twist.linear.x = truth.speed + twist.noise(1.0);
+            message->twist.twist.angular.z = truth.yaw_rate + twist.noise(1.0);
+            setDiagonal(message->twist.covariance, std::max(twist.noise() * twist.noise(), 1e-6), std::max(twist.noise() * twist.noise(), 1e-6));
+            twist_pub->publish(std::move(message));
+        }
+    }
+    const int64_t wall_end_ns = steadyNow();
+    const std::map<std::string, double> cpu_after = threadCpuSeconds();
+
+    // In-flight messages, then the probes can be read
+    std::this_thread::sleep_for(settle);
+    executors.clear();
+
+    const double simulated = static_cast<double>(steps - 1) * static_cast<double>(clock_step_ns) * 1e-9;
+    const double wall = static_cast<double>(wall_end_ns - wall_start_ns) * 1e-9;
+    const double measured_simulated = duration - warmup;
+    const double measured_wall = measure_wall_ns > 0 ? static_cast<double>(wall_end_ns - measure_wall_ns) * 1e-9 : 0.0;
+    const double achieved_factor = wall > 0.0 ? simulated / wall : 0.0;
+
+    std::printf("Simulated %.1f s in %.2f s wall time (%.2fx real time", simulated, wall, achieved_factor);
+    if (real_time_factor > 0.0)
+    {
+        std::printf(", target %.2fx, %llu steps late", real_time_factor, static_cast<unsigned long long>(late_steps));
+    }
+    std::printf(")\nInputs                 rate [Hz]   sent  dropped\n");
+    for (const SensorSchedule &sensor : sensors)
+    {
+        std::printf("  %-20s %9.1f %6llu %8llu\n", sensor.name().c_str(), sensor.enabled() ? 1e9 / static_cast<double>(sensor.period()) : 0.0,
+                    static_cast<unsigned long long>(sensor.scheduled() - sensor.dropped()), static_cast<unsigned long long>(sensor.dropped()));
+    }
+
+    std::printf("Outputs after %.1f s warmup   component     msgs  Hz (sim)  p50     p90     p99     max [ms]\n", warmup);
+    std::vector<LatencySummary> summaries;
+    for (const auto &probe : probes)
+    {
+        summaries.push_back(LatencySummary::of(probe->latencies()));
+        const LatencySummary &summary = summaries.back();
+        std::printf("  %-28s %-11s %6llu %8.1f %7.3f %7.3f %7.3f %7.3f\n", probe->topic().c_str(), probe->component().c_str(),
+                    static_cast<unsigned long long>(probe->received()),
+                    measured_simulated > 0.0 ? static_cast<double>(probe->received()) / measured_simulated : 0.0, summary.p50_ms,
+                    summary.p90_ms, summary.p99_ms, summary.max_ms);
+    }
+
+    // Percent of one core over the measured wall time, busiest first
+    std::vector<std::pair<double, std::string>> cpu;
+    for (const auto &entry : cpu_after)
+    {
+        const auto before = cpu_before.find(entry.first);
+        const double seconds = entry.second - (before != cpu_before.end() ? before->second : 0.0);
+        if (measured_wall > 0.0 && seconds > 0.0)
+        {
+            cpu.emplace_back(100.0 * seconds / measured_wall, entry.first);
+        }
+    }
+    std::sort(cpu.rbegin(), cpu.rend());
+    std::printf("CPU by thread [%% of one core]\n");
+    for (const auto &entry : cpu)
+    {
+        std::printf("  %-20s %6.1f\n", entry.second.c_str(), entry.first);
+    }
+
+    if (!report_csv.empty())
+    {
+        const bool write_header = !std::ifstream(report_csv).good();
+        std::FILE *file = std::fopen(report_csv.c_str(), "a");
+        if (!file)
+        {
+            std::fprintf(stderr, "Cannot append to %s\n", report_csv.c_str());
+            return 1;
+        }
+        if (write_header)
+        {
+            std::fprintf(file, "gnss_rate,lidar_rate,twist_rate,real_time_factor,achieved_factor,item,count,rate_hz,p50_ms,p90_ms,p99_ms,"
+                               "max_ms,cpu_percent\n");
+        }
+        const auto rate = [](const SensorSchedule &sensor) { return sensor.enabled() ? 1e9 / static_cast<double>(sensor.period()) : 0.0; };
+        const std::string run = [&]()
+        {
+            char text[128];
+            std::snprintf(text, sizeof(text), "%.1f,%.1f,%.1f,%.2f,%.3f", rate(gnss), rate(lidar), rate(twist), real_time_factor, achieved_factor);
+            return std::string(text);
+        }();
+        for (std::size_t i = 0; i < probes.size(); ++i)
+        {
+            std::fprintf(file, "%s,%s,%llu,%.2f,%.4f,%.4f,%.4f,%.4f,\n", run.c_str(), probes[i]->topic().c_str(),
+                         static_cast<unsigned long long>(probes[i]->received()),
+                         measured_simulated > 0.0 ? static_cast<double>(probes[i]->received()) / measured_simulated : 0.0,
+                         summaries[i].p50_ms, summaries[i].p90_ms, summaries[i].p99_ms, summaries[i].max_ms);
+        }
+        for (const auto &entry : cpu)
+        {
+            std::fprintf(file, "%s,thread:%s,,,,,,,%.2f\n", run.c_str(), entry.second.c_str(), entry.first);
+        }
+        std::fclose(file);
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    rclcpp::init(argc, argv);
+
+    ToolOptions options;
+    if (!options.parse(rclcpp::remove_ros_arguments(argc, argv), 1))
+    {
+        rclcpp::shutdown();
+        return 2;
+    }
+
+    int result = 1;
+    try
+    {
+        result = runStress(options);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "Stress run failed: %s\n", e.what());
+    }
+    rclcpp::shutdown();
+    return result;
+}
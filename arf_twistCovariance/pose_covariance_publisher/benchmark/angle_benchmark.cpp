@@ -0,0 +1,116 @@
+#include "pose_covariance_publisher/angle_utils.hpp"
+#include "pose_covariance_publisher/twist_estimator.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+// PoseCovariancePublisher 의 yaw 계산과 각도 정규화 벤치마크
+
+namespace
+{
+
+constexpr std::size_t kSampleCount = 1024;
+
+std::vector<geometry_msgs::msg::Quaternion> make_quaternions()
+{
+  std::vector<geometry_msgs::msg::Quaternion> quaternions(kSampleCount);
+  for (std::size_t i = 0; i < kSampleCount; ++i) {
+    const double half_yaw = 0.5 * (-M_PI + 2.0 * M_PI * static_cast<double>(i) / kSampleCount);
+    quaternions[i].z = std::sin(half_yaw);
+    quaternions[i].w = std::cos(half_yaw);
+  }
+  return quaternions;
+}
+
+void BM_CalculateYaw(benchmark::State & state)
+{
+  const std::vector<geometry_msgs::msg::Quaternion> quaternions = make_quaternions();
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(calculate_yaw(quaternions[i]));
+    i = (i + 1) % kSampleCount;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CalculateYaw);
+
+// range(0): 입력 각도의 최대 크기 [pi 단위]. 콜백에서는 yaw 차이라 2 pi 이내이고,
+// 큰 값은 반복 루프의 최악 경우를 확인하기 위한 것
+void BM_NormalizeAngle(benchmark::State & state)
+{
+  const double range = static_cast<double>(state.range(0)) * M_PI;
+  std::vector<double> angles(kSampleCount);
+  for (std::size_t i = 0; i < kSampleCount; ++i) {
+    angles[i] = -range + 2.0 * range * static_cast<double>(i) / kSampleCount;
+  }
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(normalize_angle(angles[i]));
+    i = (i + 1) % kSampleCount;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NormalizeAngle)->Arg(2)->Arg(16)->Arg(1024);
+
+// 콜백과 같은 순서: 현재 yaw 계산 후 이전 yaw 와의 차이 정규화
+void BM_YawRate(benchmark::State & state)
+{
+  const std::vector<geometry_msgs::msg::Quaternion> quaternions = make_quaternions();
+  double last_yaw = calculate_yaw(quaternions[0]);
+  std::size_t i = 1;
+  for (auto _ : state) {
+    const double current_yaw = calculate_yaw(quaternions[i]);
+    benchmark::DoNotOptimize(normalize_angle(current_yaw - last_yaw) / 0.1);
+    last_yaw = current_yaw;
+    i = (i + 7) % kSampleCount;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_YawRate);
+
+// range(0): RateMethod, range(1): rate_window. 10 Hz stamps, 샘플 추가 + 추정 한 번
+void BM_RateEstimator(benchmark::State & state)
+{
+  RateEstimator<1, 32> estimator;
+  estimator.configure(static_cast<RateMethod>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+  int64_t stamp_ns = 0;
+  double yaw = 0.0;
+  for (auto _ : state) {
+    stamp_ns += 100000000;
+    yaw += 0.01;
+    estimator.push(stamp_ns, {yaw});
+    RateEstimate<1> estimate;
+    benchmark::DoNotOptimize(estimator.estimate(estimate));
+    benchmark::DoNotOptimize(estimate);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RateEstimator)->ArgsProduct({{0, 1, 2}, {5, 15}})->ArgNames({"method", "window"});
+
+// range(0): rate_window. 5 m/s, 0.2 rad/s 곡선 주행 자세, 샘플 추가 + SE(3) 로그 적합 한 번
+void BM_TwistEstimator(benchmark::State & state)
+{
+  TwistEstimator<32> estimator;
+  estimator.configure(RateMethod::kLeastSquares, static_cast<std::size_t>(state.range(0)));
+  int64_t stamp_ns = 0;
+  double yaw = 0.0;
+  Eigen::Vector3d position = Eigen::Vector3d::Zero();
+  for (auto _ : state) {
+    stamp_ns += 100000000;
+    yaw += 0.02;
+    position += 0.5 * Eigen::Vector3d(std::cos(yaw), std::sin(yaw), 0.0);
+    estimator.push(stamp_ns, position, Eigen::Quaterniond(Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ())));
+    RateEstimate<6> estimate;
+    benchmark::DoNotOptimize(estimator.estimate(estimate));
+    benchmark::DoNotOptimize(estimate);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TwistEstimator)->Arg(5)->Arg(15)->ArgName("window");
+
+}  // namespace
+
+BENCHMARK_MAIN();
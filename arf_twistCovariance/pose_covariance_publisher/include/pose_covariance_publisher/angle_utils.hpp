@@ -0,0 +1,40 @@
+#ifndef POSE_COVARIANCE_PUBLISHER__ANGLE_UTILS_HPP_
+#define POSE_COVARIANCE_PUBLISHER__ANGLE_UTILS_HPP_
+
+#include "geometry_msgs/msg/quaternion.hpp"
+
+#include <cmath>
+
+// 노드 상태와 무관한 각도 계산 함수 (벤치마크에서도 그대로 사용)
+
+// 쿼터니언을 사용하여 yaw (방위각) 계산
+inline double calculate_yaw(const geometry_msgs::msg::Quaternion &quat)
+{
+  double siny_cosp = 2.0 * (quat.w * quat.z + quat.x * quat.y);
+  double cosy_cosp = 1.0 - 2.0 * (quat.y * quat.y + quat.z * quat.z);
+  return std::atan2(siny_cosp, cosy_cosp);
+}
+
+// 쿼터니언에서 roll, pitch 계산 (yaw 와 같은 ZYX 순서)
+inline double calculate_roll(const geometry_msgs::msg::Quaternion &quat)
+{
+  double sinr_cosp = 2.0 * (quat.w * quat.x + quat.y * quat.z);
+  double cosr_cosp = 1.0 - 2.0 * (quat.x * quat.x + quat.y * quat.y);
+  return std::atan2(sinr_cosp, cosr_cosp);
+}
+
+inline double calculate_pitch(const geometry_msgs::msg::Quaternion &quat)
+{
+  double sinp = 2.0 * (quat.w * quat.y - quat.z * quat.x);
+  return std::asin(sinp > 1.0 ? 1.0 : (sinp < -1.0 ? -1.0 : sinp));
+}
+
+// 각도를 -π에서 π 사이로 정규화
+inline double normalize_angle(double angle)
+{
+  while (angle > M_PI) angle -= 2.0 * M_PI;
+  while (angle < -M_PI) angle += 2.0 * M_PI;
+  return angle;
+}
+
+#endif  // POSE_COVARIANCE_PUBLISHER__ANGLE_UTILS_HPP_
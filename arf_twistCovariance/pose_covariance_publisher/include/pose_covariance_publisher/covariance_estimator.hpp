@@ -0,0 +1,218 @@
+#ifndef POSE_COVARIANCE_PUBLISHER__COVARIANCE_ESTIMATOR_HPP_
+#define POSE_COVARIANCE_PUBLISHER__COVARIANCE_ESTIMATOR_HPP_
+
+#include "pose_covariance_publisher/angle_utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// 6 자유도 벡터 [x, y, z, roll, pitch, yaw] 와 ROS 메시지와 같은 row-major 6x6 공분산
+using Vector6 = std::array<double, 6>;
+using Covariance6 = std::array<double, 36>;
+
+// 공분산 추정 전 (샘플 부족) 에 사용하는 기존 대각 값
+constexpr double kDefaultVariance = 0.1;
+
+// 짧은 구간 등속 모델 예측에 대한 잔차 생성기.
+// 이전 두 자세로 현재 자세를 외삽하고 z_k - pred 를 잔차로 돌려준다.
+// r = z_k - (1 + rho) z_(k-1) + rho z_(k-2) (rho = dt_k / dt_(k-1)) 이므로 각 자세의
+// 측정 잡음이 독립이고 공분산이 R 이면 Cov(r) = (1 + (1 + rho)^2 + rho^2) R 이다.
+// 잔차를 이 배수의 제곱근으로 나누어 두면 잔차 공분산이 곧 측정 공분산 R 의 추정치가 된다.
+class MotionResidual
+{
+public:
+  void reset()
+  {
+    count_ = 0;
+  }
+
+  // stamp_ns 가 이전보다 크지 않으면 (중복 stamp) 무시하고 false
+  bool update(int64_t stamp_ns, const Vector6 & pose, Vector6 & residual)
+  {
+    if (count_ > 0 && stamp_ns <= stamp_ns_[1]) {
+      return false;
+    }
+
+    bool valid = false;
+    if (count_ >= 2) {
+      const double rho = static_cast<double>(stamp_ns - stamp_ns_[1]) / static_cast<double>(stamp_ns_[1] - stamp_ns_[0]);
+      const double scale = 1.0 / std::sqrt(1.0 + (1.0 + rho) * (1.0 + rho) + rho * rho);
+      for (std::size_t i = 0; i < 6; ++i) {
+        double velocity_term = pose_[1][i] - pose_[0][i];
+        double error = pose[i] - pose_[1][i];
+        if (i >= 3) {
+          velocity_term = normalize_angle(velocity_term);
+          error = normalize_angle(error);
+        }
+        residual[i] = (error - rho * velocity_term) * scale;
+      }
+      valid = true;
+    }
+
+    stamp_ns_[0] = stamp_ns_[1];
+    pose_[0] = pose_[1];
+    stamp_ns_[1] = stamp_ns;
+    pose_[1] = pose;
+    count_ = std::min<std::size_t>(count_ + 1, 2);
+    return valid;
+  }
+
+private:
+  // [0]: k-2, [1]: k-1
+  std::array<int64_t, 2> stamp_ns_{};
+  std::array<Vector6, 2> pose_{};
+  std::size_t count_ = 0;
+};
+
+// 잔차의 온라인 공분산 추정기. 갱신 비용은 윈도 길이와 무관하게 O(36) 이다.
+//  - decay == 0: 최근 window 개 잔차에 대한 sliding Welford. 고정 크기 원형 버퍼에서
+//    가장 오래된 잔차를 빼고 새 잔차를 더한다.
+//  - 0 < decay < 1: 지수 가중 (EWMA) 평균/공분산, decay 는 새 잔차의 가중치.
+//    원형 버퍼는 사용하지 않는다.
+template <std::size_t Capacity>
+class CovarianceEstimator
+{
+public:
+  // 공분산을 내보내기 위한 최소 잔차 수. window 도 이보다 작게 두지 않는다.
+  static constexpr std::size_t kMinSamples = 5;
+
+  static_assert(Capacity >= kMinSamples, "CovarianceEstimator needs room for kMinSamples residuals");
+
+  CovarianceEstimator()
+  {
+    reset();
+  }
+
+  CovarianceEstimator(std::size_t window, double decay, double variance_floor)
+  {
+    configure(window, decay, variance_floor);
+  }
+
+  // window 는 [kMinSamples, Capacity] 로 제한 (더 작으면 ready() 가 되지 않는다),
+  // decay 가 (0, 1) 밖이면 sliding window 사용. 상태는 초기화된다.
+  void configure(std::size_t window, double decay, double variance_floor)
+  {
+    window_ = std::min(std::max(window, kMinSamples), Capacity);
+    decay_ = decay > 0.0 && decay < 1.0 ? decay : 0.0;
+    variance_floor_ = variance_floor;
+    reset();
+  }
+
+  void reset()
+  {
+    head_ = 0;
+    count_ = 0;
+    mean_.fill(0.0);
+    scatter_.fill(0.0);
+  }
+
+  void add(const Vector6 & residual)
+  {
+    if (decay_ > 0.0) {
+      add_exponential(residual);
+      count_ = std::min(count_ + 1, window_);
+      return;
+    }
+
+    if (count_ == window_) {
+      remove(buffer_[head_]);
+    }
+    buffer_[head_] = residual;
+    head_ = (head_ + 1) % window_;
+    insert(residual);
+  }
+
+  bool ready() const { return count_ >= kMinSamples; }
+  std::size_t count() const { return count_; }
+
+  // 추정 공분산 (대각은 variance_floor 이상). 준비 전에는 기존 대각 값.
+  void covariance(Covariance6 & out) const
+  {
+    if (!ready()) {
+      for (std::size_t i = 0; i < 36; ++i) {
+        out[i] = (i % 7 == 0) ? kDefaultVariance : 0.0;
+      }
+      return;
+    }
+
+    // sliding window: 표본 공분산 M2 / (n - 1), EWMA: 누적 값 그대로
+    const double scale = decay_ > 0.0 ? 1.0 : 1.0 / static_cast<double>(count_ - 1);
+    for (std::size_t i = 0; i < 36; ++i) {
+      out[i] = scatter_[i] * scale;
+    }
+    for (std::size_t i = 0; i < 6; ++i) {
+      out[i * 7] = std::max(out[i * 7], variance_floor_);
+    }
+  }
+
+private:
+  // Welford 추가: mean += d / n, M2 += d (x - mean)^T
+  void insert(const Vector6 & x)
+  {
+    ++count_;
+    Vector6 delta;
+    for (std::size_t i = 0; i < 6; ++i) {
+      delta[i] = x[i] - mean_[i];
+      mean_[i] += delta[i] / static_cast<double>(count_);
+    }
+    for (std::size_t r = 0; r < 6; ++r) {
+      for (std::size_t c = 0; c < 6; ++c) {
+        scatter_[r * 6 + c] += delta[r] * (x[c] - mean_[c]);
+      }
+    }
+  }
+
+  // Welford 제거 (insert 의 역): mean -= (x - mean) / (n - 1), M2 -= (x - mean_new)(x - mean_old)^T
+  void remove(const Vector6 & x)
+  {
+    if (count_ <= 1) {
+      reset();
+      return;
+    }
+    Vector6 delta;
+    for (std::size_t i = 0; i < 6; ++i) {
+      delta[i] = x[i] - mean_[i];
+      mean_[i] -= delta[i] / static_cast<double>(count_ - 1);
+    }
+    for (std::size_t r = 0; r < 6; ++r) {
+      for (std::size_t c = 0; c < 6; ++c) {
+        scatter_[r * 6 + c] -= (x[r] - mean_[r]) * delta[c];
+      }
+    }
+    --count_;
+  }
+
+  // EWMA: d = x - mean, mean += a d, S = (1 - a)(S + a d d^T). 첫 잔차로 평균을 초기화.
+  void add_exponential(const Vector6 & x)
+  {
+    if (count_ == 0) {
+      mean_ = x;
+      return;
+    }
+    Vector6 delta;
+    for (std::size_t i = 0; i < 6; ++i) {
+      delta[i] = x[i] - mean_[i];
+      mean_[i] += decay_ * delta[i];
+    }
+    for (std::size_t r = 0; r < 6; ++r) {
+      for (std::size_t c = 0; c < 6; ++c) {
+        scatter_[r * 6 + c] = (1.0 - decay_) * (scatter_[r * 6 + c] + decay_ * delta[r] * delta[c]);
+      }
+    }
+  }
+
+  std::size_t window_ = Capacity;
+  double decay_ = 0.0;
+  double variance_floor_ = 0.0;
+
+  std::array<Vector6, Capacity> buffer_{};
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+  Vector6 mean_{};
+  Covariance6 scatter_{};
+};
+
+#endif  // POSE_COVARIANCE_PUBLISHER__COVARIANCE_ESTIMATOR_HPP_
@@ -0,0 +1,153 @@
+#ifndef POSE_COVARIANCE_PUBLISHER__GNSS_POSE_PROCESSOR_HPP_
+#define POSE_COVARIANCE_PUBLISHER__GNSS_POSE_PROCESSOR_HPP_
+
+#include "geometry_msgs/msg/pose.hpp"
+
+#include "pose_covariance_publisher/angle_utils.hpp"
+#include "pose_covariance_publisher/covariance_estimator.hpp"
+#include "pose_covariance_publisher/twist_estimator.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// /gnss_pose 한 개로 측정 공분산과 6 자유도 body twist 를 추정하는 처리부.
+// rclcpp 에 의존하지 않으므로 노드 (PoseCovariancePublisher) 와 rosbag 오프라인 재생
+// (localization_tools) 이 같은 코드를 쓴다. 스레드 안전하지 않음.
+class GnssPoseProcessor
+{
+public:
+  static constexpr std::size_t kRateCapacity = 32;
+  static constexpr std::size_t kCovarianceCapacity = 256;
+  // covariance_window 의 유효 범위 [kMinCovarianceWindow, kCovarianceCapacity]
+  static constexpr std::size_t kMinCovarianceWindow = CovarianceEstimator<kCovarianceCapacity>::kMinSamples;
+
+  // covariance_decay 가 0 이면 최근 covariance_window 개 잔차의 sliding window, (0, 1) 이면 EWMA.
+  // covariance_window 는 위 범위로 제한된다. covariance_floor 는 자세/twist 대각 분산의 하한. rate_window 는 twist 적합에 쓰는 최근 자세 수.
+  void configure(
+    std::size_t covariance_window, double covariance_decay, double covariance_floor,
+    RateMethod rate_method, std::size_t rate_window, bool input_is_geodetic)
+  {
+    covariance_estimator_.configure(std::max<std::size_t>(covariance_window, 2), covariance_decay, covariance_floor);
+    covariance_floor_ = covariance_floor;
+    twist_estimator_.configure(rate_method, std::max<std::size_t>(rate_window, 2));
+    input_is_geodetic_ = input_is_geodetic;
+    reset();
+  }
+
+  void reset()
+  {
+    motion_residual_.reset();
+    covariance_estimator_.reset();
+    twist_estimator_.reset();
+    reference_set_ = false;
+  }
+
+  // 자세 하나를 처리해 pose_covariance 를 채운다. twist 를 추정했으면 twist ([vx, vy, vz, wx, wy, wz])
+  // 와 twist_covariance 를 채우고 true. 중복/역순 stamp 나 샘플 부족이면 false (twist 는 건드리지 않음).
+  bool process(
+    int64_t stamp_ns, const geometry_msgs::msg::Pose & pose, Covariance6 & pose_covariance,
+    Vector6 & twist, Covariance6 & twist_covariance)
+  {
+    // 등속 예측 잔차로 측정 공분산 갱신
+    const Vector6 local_pose = to_local_pose(pose);
+    Vector6 residual;
+    if (motion_residual_.update(stamp_ns, local_pose, residual)) {
+      covariance_estimator_.add(residual);
+    }
+    covariance_estimator_.covariance(pose_covariance);
+
+    // 6 자유도 twist 추정용 자세 (국지 미터 좌표 위치 + 방향). 중복/역순 stamp 는 제외 (dt = 0 방지)
+    const Eigen::Vector3d position(local_pose[0], local_pose[1], local_pose[2]);
+    const Eigen::Quaterniond orientation(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+    if (!twist_estimator_.push(stamp_ns, position, orientation)) {
+      return false;
+    }
+
+    // 최근 rate_window 개 자세의 SE(3) 로그 적합으로 body twist 와 그 분산 추정 (첫 샘플에서는 불가)
+    RateEstimate<6> estimate;
+    if (!twist_estimator_.estimate(estimate)) {
+      return false;
+    }
+
+    // 적합 잔차로 구한 분산을 대각에 사용. 차분 방식은 잔차가 없으므로 두 자세 차분의
+    // 분산 2 R / dt^2 (R: 추정한 자세 측정 공분산) 의 대각을 사용한다.
+    const double dt = twist_estimator_.last_interval();
+    for (int i = 0; i < 36; ++i) {
+      twist_covariance[i] = 0.0;
+    }
+    for (int i = 0; i < 6; ++i) {
+      twist[i] = estimate.rate[i];
+      double variance = estimate.variance[i];
+      if (variance <= 0.0) {
+        variance = covariance_estimator_.ready() ? 2.0 * pose_covariance[i * 7] / (dt * dt) : kDefaultVariance;
+      }
+      twist_covariance[i * 7] = std::max(variance, covariance_floor_);
+    }
+    return true;
+  }
+
+private:
+  // WGS84 장반경, 이심률 제곱
+  static constexpr double kSemiMajorAxis = 6378137.0;
+  static constexpr double kEccentricitySquared = 6.69437999014e-3;
+  // 기준점에서 이 거리 [m] 이상 벗어나면 국지 좌표 기준점을 다시 잡는다
+  static constexpr double kReanchorDistance = 10000.0;
+
+  // 자세를 [x, y, z, roll, pitch, yaw] 로 변환. 위경도 입력이면 기준점 기준의
+  // 국지 미터 좌표 (x: 동, y: 북) 로 바꿔 gnss2map 이 내보내는 map 축과 맞춘다.
+  Vector6 to_local_pose(const geometry_msgs::msg::Pose & pose)
+  {
+    Vector6 local = {
+      pose.position.x, pose.position.y, pose.position.z,
+      calculate_roll(pose.orientation), calculate_pitch(pose.orientation), calculate_yaw(pose.orientation)};
+    if (!input_is_geodetic_) {
+      return local;
+    }
+
+    const double latitude = pose.position.x;
+    const double longitude = pose.position.y;
+    if (!reference_set_ ||
+      std::abs(latitude - reference_latitude_) * meters_per_degree_latitude_ > kReanchorDistance ||
+      std::abs(longitude - reference_longitude_) * meters_per_degree_longitude_ > kReanchorDistance)
+    {
+      // 기준 위도의 자오선/묘유선 곡률 반경으로 도 -> 미터 환산 계수 계산
+      const double sin_lat = std::sin(latitude * M_PI / 180.0);
+      const double w = 1.0 - kEccentricitySquared * sin_lat * sin_lat;
+      const double meridian_radius = kSemiMajorAxis * (1.0 - kEccentricitySquared) / (w * std::sqrt(w));
+      const double prime_vertical_radius = kSemiMajorAxis / std::sqrt(w);
+      meters_per_degree_latitude_ = meridian_radius * M_PI / 180.0;
+      meters_per_degree_longitude_ = prime_vertical_radius * std::cos(latitude * M_PI / 180.0) * M_PI / 180.0;
+      reference_latitude_ = latitude;
+      reference_longitude_ = longitude;
+      reference_set_ = true;
+      // 기준점이 바뀌면 이전 자세와 좌표가 맞지 않으므로 잔차/twist 이력도 초기화
+      motion_residual_.reset();
+      twist_estimator_.reset();
+    }
+
+    local[0] = (longitude - reference_longitude_) * meters_per_degree_longitude_;
+    local[1] = (latitude - reference_latitude_) * meters_per_degree_latitude_;
+    return local;
+  }
+
+  // 최근 자세들로 6 자유도 body twist 추정 (고정 크기 링 버퍼)
+  TwistEstimator<kRateCapacity> twist_estimator_;
+
+  // 등속 예측 잔차로 추정한 측정 공분산 (고정 크기 버퍼, 갱신당 상수 시간)
+  MotionResidual motion_residual_;
+  CovarianceEstimator<kCovarianceCapacity> covariance_estimator_;
+  double covariance_floor_ = 0.0;
+  // true: position 이 (위도, 경도, 고도) [deg, deg, m]
+  bool input_is_geodetic_ = true;
+  bool reference_set_ = false;
+  double reference_latitude_ = 0.0;
+  double reference_longitude_ = 0.0;
+  double meters_per_degree_latitude_ = 0.0;
+  double meters_per_degree_longitude_ = 0.0;
+};
+
+#endif  // POSE_COVARIANCE_PUBLISHER__GNSS_POSE_PROCESSOR_HPP_
@@ -0,0 +1,55 @@
+#ifndef POSE_COVARIANCE_PUBLISHER__POSE_COVARIANCE_PUBLISHER_HPP_
+#define POSE_COVARIANCE_PUBLISHER__POSE_COVARIANCE_PUBLISHER_HPP_
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+#include "geometry_msgs/msg/pose_stamped.hpp"
+#include "geometry_msgs/msg/pose_with_covariance_stamped.hpp"
+#include "geometry_msgs/msg/twist_with_covariance_stamped.hpp"
+
+#include "pose_covariance_publisher/gnss_pose_processor.hpp"
+
+#include <localization_common/allocation_guard.hpp>
+#include <localization_common/latency_monitor.hpp>
+#include <localization_common/lifecycle.hpp>
+#include <localization_common/message_publisher.hpp>
+#include <localization_common/qos_profiles.hpp>
+
+#include <atomic>
+#include <memory>
+
+// Lifecycle 노드: on_configure 에서 파라미터를 읽고 추정 버퍼, 발행 메시지, 구독을 모두 만든다.
+// active 상태에서만 콜백이 동작하며 추정 계산은 힙 할당을 하지 않는다 (AllocationGuard).
+// autostart (기본값 true) 이면 생성자에서 configure, activate 까지 진행한다.
+class PoseCovariancePublisher : public rclcpp_lifecycle::LifecycleNode
+{
+public:
+  explicit PoseCovariancePublisher(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+  LifecycleCallbackReturn on_configure(const rclcpp_lifecycle::State & state) override;
+  LifecycleCallbackReturn on_activate(const rclcpp_lifecycle::State & state) override;
+  LifecycleCallbackReturn on_deactivate(const rclcpp_lifecycle::State & state) override;
+  LifecycleCallbackReturn on_cleanup(const rclcpp_lifecycle::State & state) override;
+  LifecycleCallbackReturn on_shutdown(const rclcpp_lifecycle::State & state) override;
+
+private:
+  void gnss_pose_callback(const geometry_msgs::msg::PoseStamped::ConstSharedPtr msg);
+  // on_configure 에서 만든 것을 모두 해제
+  void release();
+
+  // on_activate 에서 켜고 on_deactivate 에서 끈다. 꺼져 있으면 수신 메시지는 버린다.
+  std::atomic<bool> active_{false};
+
+  rclcpp::Subscription<geometry_msgs::msg::PoseStamped>::SharedPtr gnss_pose_subscription_;
+  MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped> gnss_pose_with_covariance_publisher_;
+  MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped> lidar_pose_with_covariance_publisher_;
+  MessagePublisher<geometry_msgs::msg::TwistWithCovarianceStamped> fix_twist_publisher_;
+
+  // 공분산/twist 추정 (rclcpp 비의존, 오프라인 재생과 공유)
+  GnssPoseProcessor processor_;
+
+  std::unique_ptr<LatencyMonitor> latency_monitor_;
+  CallbackStatistics * gnss_pose_statistics_;
+};
+
+#endif  // POSE_COVARIANCE_PUBLISHER__POSE_COVARIANCE_PUBLISHER_HPP_
@@ -0,0 +1,310 @@
+#ifndef POSE_COVARIANCE_PUBLISHER__RATE_ESTIMATOR_HPP_
+#define POSE_COVARIANCE_PUBLISHER__RATE_ESTIMATOR_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// 최근 N 개 샘플에 대한 다항식 최소자승 적합으로 변화율 (미분) 을 추정한다.
+//  - kDifference:    기존 방식, 마지막 두 샘플의 차분
+//  - kLeastSquares:  1차 적합의 기울기 (구간 중앙 기준, 잡음에 가장 강함)
+//  - kSavitzkyGolay: 2차 적합의 최신 샘플에서의 미분 (지연이 작음)
+// 균등 간격 계수는 모든 N 에 대해 컴파일 타임에 생성된다. stamp 간격이 고르지 않으면
+// 실제 시간으로 1차 최소자승을 직접 푼다. 모든 상태는 고정 크기 배열이라 할당이 없다.
+enum class RateMethod
+{
+  kDifference,
+  kLeastSquares,
+  kSavitzkyGolay
+};
+
+namespace rate_fit
+{
+
+constexpr std::size_t kMaxOrder = 2;
+
+// N 개의 균등 간격 샘플 x_i = i - (N - 1) (최신 샘플이 0) 에 대한 Order 차 적합의
+// 의사역행렬 행. coefficient[j][i] 는 샘플 i 가 j 차 계수에 기여하는 가중치.
+template <std::size_t MaxN>
+struct FitCoefficients
+{
+  std::array<std::array<double, MaxN>, kMaxOrder + 1> coefficient{};
+};
+
+template <std::size_t MaxN>
+constexpr FitCoefficients<MaxN> make_fit(std::size_t n, std::size_t order)
+{
+  const std::size_t p = order + 1;
+  // 정규 방정식 A = X^T X 를 단위 행렬과 함께 Gauss-Jordan 소거
+  double a[kMaxOrder + 1][kMaxOrder + 1] = {};
+  double inverse[kMaxOrder + 1][kMaxOrder + 1] = {};
+  for (std::size_t r = 0; r < p; ++r) {
+    inverse[r][r] = 1.0;
+    for (std::size_t c = 0; c < p; ++c) {
+      for (std::size_t i = 0; i < n; ++i) {
+        const double x = static_cast<double>(i) - static_cast<double>(n - 1);
+        double power = 1.0;
+        for (std::size_t k = 0; k < r + c; ++k) {
+          power *= x;
+        }
+        a[r][c] += power;
+      }
+    }
+  }
+  for (std::size_t col = 0; col < p; ++col) {
+    const double pivot = a[col][col];
+    for (std::size_t c = 0; c < p; ++c) {
+      a[col][c] /= pivot;
+      inverse[col][c] /= pivot;
+    }
+    for (std::size_t r = 0; r < p; ++r) {
+      if (r != col) {
+        const double factor = a[r][col];
+        for (std::size_t c = 0; c < p; ++c) {
+          a[r][c] -= factor * a[col][c];
+          inverse[r][c] -= factor * inverse[col][c];
+        }
+      }
+    }
+  }
+
+  // 계수 = A^-1 X^T
+  FitCoefficients<MaxN> fit;
+  for (std::size_t j = 0; j < p; ++j) {
+    for (std::size_t i = 0; i < n; ++i) {
+      const double x = static_cast<double>(i) - static_cast<double>(n - 1);
+      double power = 1.0;
+      double weight = 0.0;
+      for (std::size_t k = 0; k < p; ++k) {
+        weight += inverse[j][k] * power;
+        power *= x;
+      }
+      fit.coefficient[j][i] = weight;
+    }
+  }
+  return fit;
+}
+
+// table[n]: n 개 샘플의 적합 계수 (n < Order + 2 항목은 사용하지 않음)
+template <std::size_t MaxN>
+constexpr std::array<FitCoefficients<MaxN>, MaxN + 1> make_fit_table(std::size_t order)
+{
+  std::array<FitCoefficients<MaxN>, MaxN + 1> table{};
+  for (std::size_t n = order + 2; n <= MaxN; ++n) {
+    table[n] = make_fit<MaxN>(n, order);
+  }
+  return table;
+}
+
+}  // namespace rate_fit
+
+template <std::size_t Dim>
+struct RateEstimate
+{
+  std::array<double, Dim> rate{};
+  // 적합 잔차로부터 계산한 각 채널 변화율의 분산
+  std::array<double, Dim> variance{};
+};
+
+// Dim 개 채널 (같은 stamp) 의 변화율을 MaxN 개 샘플 원형 버퍼에서 추정
+template <std::size_t Dim, std::size_t MaxN>
+class RateEstimator
+{
+  static_assert(MaxN >= 4, "RateEstimator needs a window of at least four samples");
+
+public:
+  // 간격이 평균에서 이 비율 이상 벗어나면 균등 간격 계수 대신 실제 시간으로 적합
+  static constexpr double kSpacingTolerance = 0.2;
+
+  RateEstimator() = default;
+
+  // window 는 [2, MaxN] 로 제한. 상태는 초기화된다.
+  void configure(RateMethod method, std::size_t window)
+  {
+    method_ = method;
+    window_ = std::min(std::max<std::size_t>(window, 2), MaxN);
+    reset();
+  }
+
+  void reset()
+  {
+    head_ = 0;
+    count_ = 0;
+  }
+
+  std::size_t count() const { return count_; }
+
+  // stamp 가 이전 샘플보다 크지 않으면 (중복/역순 stamp) 버리고 false.
+  // 값은 연속이어야 한다 (각도는 호출 전에 unwrap).
+  bool push(int64_t stamp_ns, const std::array<double, Dim> & value)
+  {
+    if (count_ > 0 && stamp_ns <= stamp_ns_[newest_index()]) {
+      return false;
+    }
+    stamp_ns_[head_] = stamp_ns;
+    value_[head_] = value;
+    head_ = (head_ + 1) % MaxN;
+    count_ = std::min(count_ + 1, window_);
+    return true;
+  }
+
+  // 샘플이 두 개 이상이면 true
+  bool estimate(RateEstimate<Dim> & out) const
+  {
+    if (count_ < 2) {
+      return false;
+    }
+
+    const std::size_t order = method_ == RateMethod::kSavitzkyGolay ? 2 : 1;
+    if (method_ == RateMethod::kDifference || count_ < order + 2) {
+      difference(out);
+      return true;
+    }
+
+    const double span_s = static_cast<double>(stamp_ns_[newest_index()] - stamp_ns_[index(0)]) * 1e-9;
+    const double spacing_s = span_s / static_cast<double>(count_ - 1);
+    if (!uniform(spacing_s)) {
+      irregular_least_squares(out);
+      return true;
+    }
+
+    const rate_fit::FitCoefficients<MaxN> & fit =
+      order == 2 ? savitzky_golay_table()[count_] : least_squares_table()[count_];
+    uniform_fit(fit, order, spacing_s, out);
+    return true;
+  }
+
+private:
+  static const std::array<rate_fit::FitCoefficients<MaxN>, MaxN + 1> & least_squares_table()
+  {
+    static constexpr std::array<rate_fit::FitCoefficients<MaxN>, MaxN + 1> table = rate_fit::make_fit_table<MaxN>(1);
+    return table;
+  }
+
+  static const std::array<rate_fit::FitCoefficients<MaxN>, MaxN + 1> & savitzky_golay_table()
+  {
+    static constexpr std::array<rate_fit::FitCoefficients<MaxN>, MaxN + 1> table = rate_fit::make_fit_table<MaxN>(2);
+    return table;
+  }
+
+  // i 번째로 오래된 샘플 (0: 가장 오래됨)
+  std::size_t index(std::size_t i) const { return (head_ + MaxN - count_ + i) % MaxN; }
+  std::size_t newest_index() const { return (head_ + MaxN - 1) % MaxN; }
+
+  double seconds_since_oldest(std::size_t i) const
+  {
+    return static_cast<double>(stamp_ns_[index(i)] - stamp_ns_[index(0)]) * 1e-9;
+  }
+
+  bool uniform(double spacing_s) const
+  {
+    for (std::size_t i = 1; i < count_; ++i) {
+      const double interval_s = seconds_since_oldest(i) - seconds_since_oldest(i - 1);
+      if (std::abs(interval_s - spacing_s) > kSpacingTolerance * spacing_s) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void difference(RateEstimate<Dim> & out) const
+  {
+    const std::size_t newest = newest_index();
+    const std::size_t previous = (head_ + MaxN - 2) % MaxN;
+    const double dt = static_cast<double>(stamp_ns_[newest] - stamp_ns_[previous]) * 1e-9;
+    for (std::size_t d = 0; d < Dim; ++d) {
+      out.rate[d] = (value_[newest][d] - value_[previous][d]) / dt;
+      // 두 점으로는 잔차를 알 수 없다
+      out.variance[d] = 0.0;
+    }
+  }
+
+  // 균등 간격: rate = sum_i w_i y_i / dt, Var = s^2 sum_i w_i^2 / dt^2,
+  // s^2 = 적합 잔차 제곱합 / (n - order - 1)
+  void uniform_fit(const rate_fit::FitCoefficients<MaxN> & fit, std::size_t order, double spacing_s, RateEstimate<Dim> & out) const
+  {
+    std::array<std::array<double, Dim>, rate_fit::kMaxOrder + 1> polynomial{};
+    double weight_norm = 0.0;
+    for (std::size_t i = 0; i < count_; ++i) {
+      const std::array<double, Dim> & y = value_[index(i)];
+      for (std::size_t j = 0; j <= order; ++j) {
+        for (std::size_t d = 0; d < Dim; ++d) {
+          polynomial[j][d] += fit.coefficient[j][i] * y[d];
+        }
+      }
+      weight_norm += fit.coefficient[1][i] * fit.coefficient[1][i];
+    }
+
+    std::array<double, Dim> residual_sum{};
+    for (std::size_t i = 0; i < count_; ++i) {
+      const double x = static_cast<double>(i) - static_cast<double>(count_ - 1);
+      const std::array<double, Dim> & y = value_[index(i)];
+      for (std::size_t d = 0; d < Dim; ++d) {
+        double fitted = polynomial[0][d] + polynomial[1][d] * x;
+        if (order == 2) {
+          fitted += polynomial[2][d] * x * x;
+        }
+        residual_sum[d] += (y[d] - fitted) * (y[d] - fitted);
+      }
+    }
+
+    const double dof = static_cast<double>(count_ - order - 1);
+    for (std::size_t d = 0; d < Dim; ++d) {
+      out.rate[d] = polynomial[1][d] / spacing_s;
+      out.variance[d] = residual_sum[d] / dof * weight_norm / (spacing_s * spacing_s);
+    }
+  }
+
+  // 불균등 간격: 실제 시간으로 1차 최소자승, Var = s^2 / sum (t - t_mean)^2
+  void irregular_least_squares(RateEstimate<Dim> & out) const
+  {
+    double t_mean = 0.0;
+    std::array<double, Dim> y_mean{};
+    for (std::size_t i = 0; i < count_; ++i) {
+      t_mean += seconds_since_oldest(i);
+      for (std::size_t d = 0; d < Dim; ++d) {
+        y_mean[d] += value_[index(i)][d];
+      }
+    }
+    t_mean /= static_cast<double>(count_);
+    for (std::size_t d = 0; d < Dim; ++d) {
+      y_mean[d] /= static_cast<double>(count_);
+    }
+
+    double stt = 0.0;
+    std::array<double, Dim> sty{};
+    for (std::size_t i = 0; i < count_; ++i) {
+      const double dt = seconds_since_oldest(i) - t_mean;
+      stt += dt * dt;
+      for (std::size_t d = 0; d < Dim; ++d) {
+        sty[d] += dt * (value_[index(i)][d] - y_mean[d]);
+      }
+    }
+
+    std::array<double, Dim> residual_sum{};
+    for (std::size_t i = 0; i < count_; ++i) {
+      const double dt = seconds_since_oldest(i) - t_mean;
+      for (std::size_t d = 0; d < Dim; ++d) {
+        const double residual = value_[index(i)][d] - y_mean[d] - sty[d] / stt * dt;
+        residual_sum[d] += residual * residual;
+      }
+    }
+
+    for (std::size_t d = 0; d < Dim; ++d) {
+      out.rate[d] = sty[d] / stt;
+      out.variance[d] = residual_sum[d] / static_cast<double>(count_ - 2) / stt;
+    }
+  }
+
+  RateMethod method_ = RateMethod::kLeastSquares;
+  std::size_t window_ = MaxN;
+
+  std::array<int64_t, MaxN> stamp_ns_{};
+  std::array<std::array<double, Dim>, MaxN> value_{};
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+};
+
+#endif  // POSE_COVARIANCE_PUBLISHER__RATE_ESTIMATOR_HPP_
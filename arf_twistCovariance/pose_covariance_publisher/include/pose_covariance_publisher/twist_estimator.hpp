@@ -0,0 +1,110 @@
+#ifndef POSE_COVARIANCE_PUBLISHER__TWIST_ESTIMATOR_HPP_
+#define POSE_COVARIANCE_PUBLISHER__TWIST_ESTIMATOR_HPP_
+
+#include "pose_covariance_publisher/rate_estimator.hpp"
+
+#include <Eigen/Geometry>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// SE(3) 로그 맵: T = (R, p) -> [rho, omega], T = exp([rho, omega]^).
+// omega = log(R), rho = V^-1 p, V^-1 = I - W / 2 + c W^2,
+// c = (1 - (theta / 2) cot(theta / 2)) / theta^2 (theta -> 0 에서 1/12 + theta^2 / 720)
+inline std::array<double, 6> se3_log(const Eigen::Quaterniond & rotation, const Eigen::Vector3d & translation)
+{
+  // AngleAxis 는 theta 를 [0, pi] 로 돌려준다 (w < 0 이면 축 부호 반전)
+  const Eigen::AngleAxisd angle_axis(rotation);
+  const double theta = angle_axis.angle();
+  const Eigen::Vector3d omega = angle_axis.axis() * theta;
+
+  const double c = theta < 1e-4 ?
+    1.0 / 12.0 + theta * theta / 720.0 :
+    (1.0 - theta * std::sin(theta) / (2.0 * (1.0 - std::cos(theta)))) / (theta * theta);
+  const Eigen::Vector3d w_p = omega.cross(translation);
+  const Eigen::Vector3d rho = translation - 0.5 * w_p + c * omega.cross(w_p);
+
+  return {rho.x(), rho.y(), rho.z(), omega.x(), omega.y(), omega.z()};
+}
+
+// 최근 N 개 자세로 6 자유도 body twist [vx, vy, vz, wx, wy, wz] 추정.
+// 각 자세를 최신 자세 기준 상대 자세의 로그 xi_i = log(T_n^-1 T_i) 로 바꾸면 일정한
+// twist 운동에서 xi_i = (t_i - t_n) xi 로 시간에 선형이므로, 6 개 채널을 RateEstimator 로
+// 한 번에 적합한 기울기가 최신 자세에서의 body twist, 잔차가 그 분산이 된다.
+template <std::size_t MaxN>
+class TwistEstimator
+{
+public:
+  void configure(RateMethod method, std::size_t window)
+  {
+    fit_.configure(method, window);
+    window_ = std::min(std::max<std::size_t>(window, 2), MaxN);
+    reset();
+  }
+
+  void reset()
+  {
+    head_ = 0;
+    count_ = 0;
+  }
+
+  // stamp 가 이전 자세보다 크지 않으면 (중복/역순 stamp) 버리고 false
+  bool push(int64_t stamp_ns, const Eigen::Vector3d & position, const Eigen::Quaterniond & orientation)
+  {
+    if (count_ > 0 && stamp_ns <= stamp_ns_[newest_index()]) {
+      return false;
+    }
+    stamp_ns_[head_] = stamp_ns;
+    position_[head_] = position;
+    orientation_[head_] = orientation.normalized();
+    head_ = (head_ + 1) % MaxN;
+    count_ = std::min(count_ + 1, window_);
+    return true;
+  }
+
+  // 자세가 두 개 이상이면 true
+  bool estimate(RateEstimate<6> & out)
+  {
+    if (count_ < 2) {
+      return false;
+    }
+
+    const std::size_t newest = newest_index();
+    const Eigen::Quaterniond inverse_orientation = orientation_[newest].conjugate();
+    fit_.reset();
+    for (std::size_t i = 0; i < count_; ++i) {
+      const std::size_t k = index(i);
+      const Eigen::Quaterniond relative_orientation = inverse_orientation * orientation_[k];
+      const Eigen::Vector3d relative_position = inverse_orientation * (position_[k] - position_[newest]);
+      fit_.push(stamp_ns_[k], se3_log(relative_orientation, relative_position));
+    }
+    return fit_.estimate(out);
+  }
+
+  // 최신 두 자세의 시간 간격 [s]
+  double last_interval() const
+  {
+    if (count_ < 2) {
+      return 0.0;
+    }
+    return static_cast<double>(stamp_ns_[newest_index()] - stamp_ns_[(head_ + MaxN - 2) % MaxN]) * 1e-9;
+  }
+
+private:
+  std::size_t index(std::size_t i) const { return (head_ + MaxN - count_ + i) % MaxN; }
+  std::size_t newest_index() const { return (head_ + MaxN - 1) % MaxN; }
+
+  std::size_t window_ = MaxN;
+  std::array<int64_t, MaxN> stamp_ns_{};
+  std::array<Eigen::Vector3d, MaxN> position_;
+  std::array<Eigen::Quaterniond, MaxN> orientation_;
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+
+  // 매 추정마다 상대 자세 로그로 다시 채우는 적합 버퍼
+  RateEstimator<6, MaxN> fit_;
+};
+
+#endif  // POSE_COVARIANCE_PUBLISHER__TWIST_ESTIMATOR_HPP_
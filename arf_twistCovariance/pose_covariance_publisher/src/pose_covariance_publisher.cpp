@@ -79,7 +79,7 @@
 //     twist_msg.twist.angular.y = 0.0;
 //     twist_msg.twist.angular.z = yaw_diff / dt;
 
-//     fix_twist_publisher_->publish(twist_msg);
+//     fix_twist_publisher_->publish(std::move(twist_msg_ptr));
 
 //     // 업데이트
 //     last_yaw_ = current_yaw;
@@ -122,129 +122,177 @@
 
 
 
-#include "rclcpp/rclcpp.hpp"
-#include "geometry_msgs/msg/pose_stamped.hpp"
-#include "geometry_msgs/msg/pose_with_covariance_stamped.hpp"
-#include "geometry_msgs/msg/twist_with_covariance_stamped.hpp"  // Update the include
+#include "pose_covariance_publisher/pose_covariance_publisher.hpp"
+
+#include <rclcpp_components/register_node_macro.hpp>
+#include <algorithm>
 #include <cmath>
+#include <memory>
+#include <string>
 
 using std::placeholders::_1;
 
-class PoseCovariancePublisher : public rclcpp::Node
+PoseCovariancePublisher::PoseCovariancePublisher(const rclcpp::NodeOptions & options)
+: LifecycleNode("pose_covariance_publisher", options), gnss_pose_statistics_(nullptr)
 {
-public:
-  PoseCovariancePublisher()
-  : Node("pose_covariance_publisher"), last_yaw_(0.0), first_yaw_received_(false)
-  {
-    // GNSS pose 구독 및 콜백 등록
-    gnss_pose_subscription_ = this->create_subscription<geometry_msgs::msg::PoseStamped>(
-      "/gnss_pose", 10, std::bind(&PoseCovariancePublisher::gnss_pose_callback, this, _1));
-
-    // /gnss_pose_with_covariance 및 /lidar_pose_with_covariance 퍼블리셔 생성
-    gnss_pose_with_covariance_publisher_ = this->create_publisher<geometry_msgs::msg::PoseWithCovarianceStamped>(
-      "/gnss_pose_with_covariance", 10);
-
-    lidar_pose_with_covariance_publisher_ = this->create_publisher<geometry_msgs::msg::PoseWithCovarianceStamped>(
-      "/lidar_pose_with_covariance", 10);
-
-    // /fix_twist 퍼블리셔를 TwistWithCovarianceStamped로 생성
-    fix_twist_publisher_ = this->create_publisher<geometry_msgs::msg::TwistWithCovarianceStamped>(
-      "/fix_twist", 10);
+  // false 이면 lifecycle manager 또는 `ros2 lifecycle set` 으로 단계적으로 올린다
+  const bool start_active = this->declare_parameter<bool>("autostart", true);
+  if (start_active) {
+    autostart(*this);
   }
+}
 
-private:
-  void gnss_pose_callback(const geometry_msgs::msg::PoseStamped::SharedPtr msg)
+LifecycleCallbackReturn PoseCovariancePublisher::on_configure(const rclcpp_lifecycle::State &)
+{
+  // 공분산 추정: covariance_decay 가 0 이면 최근 covariance_window 개 잔차의 sliding window,
+  // (0, 1) 이면 EWMA. covariance_floor 는 대각 분산의 하한.
+  const int64_t covariance_window = configuredParameter<int64_t>(*this, "covariance_window", 20);
+  const double covariance_decay = configuredParameter<double>(*this, "covariance_decay", 0.0);
+  const double covariance_floor = configuredParameter<double>(*this, "covariance_floor", 1e-4);
+  if (covariance_window < static_cast<int64_t>(GnssPoseProcessor::kMinCovarianceWindow) ||
+    covariance_window > static_cast<int64_t>(GnssPoseProcessor::kCovarianceCapacity))
   {
-    auto pose_with_covariance_msg = geometry_msgs::msg::PoseWithCovarianceStamped();
-
-    pose_with_covariance_msg.header = msg->header;
-    pose_with_covariance_msg.pose.pose = msg->pose;
-
-    // 예시 공분산 행렬 (단위 행렬)
-    for (int i = 0; i < 36; ++i) {
-      pose_with_covariance_msg.pose.covariance[i] = (i % 7 == 0) ? 0.1 : 0.0;
-    }
-
-    gnss_pose_with_covariance_publisher_->publish(pose_with_covariance_msg);
-
-    // LiDAR 공분산 메시지 발행
-    lidar_pose_with_covariance_publisher_->publish(pose_with_covariance_msg);
-
-    // 현재 yaw 계산
-    double current_yaw = calculate_yaw(msg->pose.orientation);
-
-    // 첫 번째 yaw 수신 시에는 이전 yaw를 설정만 하고, 이후에 처리
-    if (!first_yaw_received_) {
-      last_yaw_ = current_yaw;
-      last_time_ = rclcpp::Time(msg->header.stamp);  // 현재 시간을 rclcpp::Time으로 변환하여 저장
-      first_yaw_received_ = true;
-      return;
-    }
-
-    // 시간 간격 계산 (시간 변화량)
-    rclcpp::Time current_time(msg->header.stamp);  // 현재 시간을 rclcpp::Time으로 변환
-    double dt = (current_time - last_time_).seconds();  // 시간 간격 계산
+    RCLCPP_WARN(
+      this->get_logger(), "covariance_window %ld is outside [%zu, %zu], clamping it",
+      static_cast<long>(covariance_window), GnssPoseProcessor::kMinCovarianceWindow,
+      GnssPoseProcessor::kCovarianceCapacity);
+  }
 
-    // Yaw 변화 계산
-    double yaw_diff = normalize_angle(current_yaw - last_yaw_);
+  // twist 추정: "least_squares" (1차 적합 기울기), "savitzky_golay" (2차 적합, 최신 샘플 미분),
+  // "difference" (두 샘플 차분). rate_window 는 적합에 쓰는 최근 자세 수.
+  const std::string rate_method = configuredParameter<std::string>(*this, "rate_method", "least_squares");
+  const int64_t rate_window = configuredParameter<int64_t>(*this, "rate_window", 5);
+  RateMethod method = RateMethod::kLeastSquares;
+  if (rate_method == "savitzky_golay") {
+    method = RateMethod::kSavitzkyGolay;
+  } else if (rate_method == "difference") {
+    method = RateMethod::kDifference;
+  } else if (rate_method != "least_squares") {
+    RCLCPP_WARN(this->get_logger(), "Unknown rate_method '%s', using 'least_squares'", rate_method.c_str());
+  }
+  // gnss2map 앞단에서는 /gnss_pose 의 position 이 (위도, 경도, 고도)
+  const bool input_is_geodetic = configuredParameter<bool>(*this, "input_is_geodetic", true);
+  processor_.configure(
+    static_cast<std::size_t>(std::max<int64_t>(covariance_window, 2)), covariance_decay, covariance_floor,
+    method, static_cast<std::size_t>(std::max<int64_t>(rate_window, 2)), input_is_geodetic);
+
+  // 토픽별 QoS 는 qos.<토픽 키>.* 파라미터로 변경 가능 (profile: "sensor_data" 는 best effort, keep last 1)
+  // GNSS pose 구독 및 콜백 등록
+  gnss_pose_subscription_ = this->create_subscription<geometry_msgs::msg::PoseStamped>(
+    "/gnss_pose", declareQos(*this, "gnss_pose", rclcpp::QoS(10)), std::bind(&PoseCovariancePublisher::gnss_pose_callback, this, _1));
+
+  // /gnss_pose_with_covariance 및 /lidar_pose_with_covariance 퍼블리셔 생성.
+  // 메시지는 발행 경로에서 새로 만들지 않고 MessagePublisher 가 제자리에서 채운다.
+  gnss_pose_with_covariance_publisher_ = MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped>(
+    *this, "/gnss_pose_with_covariance", declareQos(*this, "gnss_pose_with_covariance", rclcpp::QoS(10)));
+
+  lidar_pose_with_covariance_publisher_ = MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped>(
+    *this, "/lidar_pose_with_covariance", declareQos(*this, "lidar_pose_with_covariance", rclcpp::QoS(10)));
+
+  // /fix_twist 퍼블리셔를 TwistWithCovarianceStamped로 생성 (frame_id 는 여기서 한 번만 설정)
+  geometry_msgs::msg::TwistWithCovarianceStamped twist_prototype;
+  twist_prototype.header.frame_id = "base_link";  // 필요에 따라 프레임 ID 조정
+  fix_twist_publisher_ = MessagePublisher<geometry_msgs::msg::TwistWithCovarianceStamped>(
+    *this, "/fix_twist", declareQos(*this, "fix_twist", rclcpp::QoS(10)), twist_prototype);
+
+  // 콜백 실행 시간, 입력 stamp 대비 지연, 도착 간격 지터를 /diagnostics로 1 Hz 발행
+  latency_monitor_ = std::make_unique<LatencyMonitor>(*this);
+  gnss_pose_statistics_ = &latency_monitor_->addCallback("gnss_pose");
+  return LifecycleCallbackReturn::SUCCESS;
+}
 
-    // TwistWithCovarianceStamped 메시지 생성 및 발행
-    auto twist_msg = geometry_msgs::msg::TwistWithCovarianceStamped();
-    twist_msg.header.stamp = msg->header.stamp;
-    twist_msg.header.frame_id = "base_link";  // 필요에 따라 프레임 ID 조정
+LifecycleCallbackReturn PoseCovariancePublisher::on_activate(const rclcpp_lifecycle::State &)
+{
+  active_.store(true, std::memory_order_relaxed);
+  return LifecycleCallbackReturn::SUCCESS;
+}
 
-    // Linear 속성들은 0으로 설정
-    twist_msg.twist.twist.linear.x = 0.0;
-    twist_msg.twist.twist.linear.y = 0.0;
-    twist_msg.twist.twist.linear.z = 0.0;
+LifecycleCallbackReturn PoseCovariancePublisher::on_deactivate(const rclcpp_lifecycle::State &)
+{
+  active_.store(false, std::memory_order_relaxed);
+  return LifecycleCallbackReturn::SUCCESS;
+}
 
-    // Angular 속성 중 z축 각속도 계산
-    twist_msg.twist.twist.angular.x = 0.0;
-    twist_msg.twist.twist.angular.y = 0.0;
-    twist_msg.twist.twist.angular.z = yaw_diff / dt;
+LifecycleCallbackReturn PoseCovariancePublisher::on_cleanup(const rclcpp_lifecycle::State &)
+{
+  release();
+  return LifecycleCallbackReturn::SUCCESS;
+}
 
-    // 예시 공분산 행렬 (단위 행렬)
-    for (int i = 0; i < 36; ++i) {
-      twist_msg.twist.covariance[i] = (i % 7 == 0) ? 0.1 : 0.0;
-    }
+LifecycleCallbackReturn PoseCovariancePublisher::on_shutdown(const rclcpp_lifecycle::State &)
+{
+  active_.store(false, std::memory_order_relaxed);
+  release();
+  return LifecycleCallbackReturn::SUCCESS;
+}
 
-    fix_twist_publisher_->publish(twist_msg);
+void PoseCovariancePublisher::release()
+{
+  gnss_pose_subscription_.reset();
+  gnss_pose_with_covariance_publisher_ = MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped>();
+  lidar_pose_with_covariance_publisher_ = MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped>();
+  fix_twist_publisher_ = MessagePublisher<geometry_msgs::msg::TwistWithCovarianceStamped>();
+  latency_monitor_.reset();
+  gnss_pose_statistics_ = nullptr;
+  // 다음 configure 가 창 크기를 다시 정하고, 이전 잔차는 버린다
+  processor_.reset();
+}
 
-    // 업데이트
-    last_yaw_ = current_yaw;
-    last_time_ = current_time;
+void PoseCovariancePublisher::gnss_pose_callback(const geometry_msgs::msg::PoseStamped::ConstSharedPtr msg)
+{
+  if (!active_.load(std::memory_order_relaxed)) {
+    return;
   }
-
-  double calculate_yaw(const geometry_msgs::msg::Quaternion &quat)
+  ScopedCallbackTimer timer(*gnss_pose_statistics_);
+
+  // 측정 공분산 갱신 및 twist 추정 (twist 는 중복/역순 stamp 나 첫 샘플에서는 없음).
+  // 버퍼는 configure 에서 잡혀 있어 여기서는 할당하지 않는다.
+  const rclcpp::Time current_time(msg->header.stamp);
+  Covariance6 pose_covariance;
+  Vector6 twist;
+  Covariance6 twist_covariance;
+  bool twist_valid;
   {
-    // 쿼터니언을 사용하여 yaw (방위각) 계산
-    double siny_cosp = 2.0 * (quat.w * quat.z + quat.x * quat.y);
-    double cosy_cosp = 1.0 - 2.0 * (quat.y * quat.y + quat.z * quat.z);
-    return std::atan2(siny_cosp, cosy_cosp);
+    AllocationGuard no_allocation;
+    twist_valid = processor_.process(
+      current_time.nanoseconds(), msg->pose, pose_covariance, twist, twist_covariance);
   }
 
-  double normalize_angle(double angle)
-  {
-    // 각도를 -π에서 π 사이로 정규화
-    while (angle > M_PI) angle -= 2.0 * M_PI;
-    while (angle < -M_PI) angle += 2.0 * M_PI;
-    return angle;
-  }
+  // 두 토픽에 같은 내용을 발행. frame_id 는 입력을 그대로 쓰되 바뀔 때만 대입한다.
+  const auto fill_pose = [&](geometry_msgs::msg::PoseWithCovarianceStamped & pose_with_covariance_msg) {
+      pose_with_covariance_msg.header.stamp = msg->header.stamp;
+      if (pose_with_covariance_msg.header.frame_id != msg->header.frame_id) {
+        pose_with_covariance_msg.header.frame_id = msg->header.frame_id;
+      }
+      pose_with_covariance_msg.pose.pose = msg->pose;
+      pose_with_covariance_msg.pose.covariance = pose_covariance;
+      return true;
+    };
 
-  rclcpp::Subscription<geometry_msgs::msg::PoseStamped>::SharedPtr gnss_pose_subscription_;
-  rclcpp::Publisher<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr gnss_pose_with_covariance_publisher_;
-  rclcpp::Publisher<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr lidar_pose_with_covariance_publisher_;
-  rclcpp::Publisher<geometry_msgs::msg::TwistWithCovarianceStamped>::SharedPtr fix_twist_publisher_;
+  latency_monitor_->recordAge(*gnss_pose_statistics_, msg->header.stamp);
 
-  double last_yaw_;
-  rclcpp::Time last_time_;
-  bool first_yaw_received_;
-};
+  gnss_pose_with_covariance_publisher_.publish(fill_pose);
 
-int main(int argc, char * argv[])
-{
-  rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<PoseCovariancePublisher>());
-  rclcpp::shutdown();
-  return 0;
+  // LiDAR 공분산 메시지 발행
+  lidar_pose_with_covariance_publisher_.publish(fill_pose);
+
+  if (!twist_valid) {
+    return;
+  }
+
+  // TwistWithCovarianceStamped 메시지 채우기 및 발행
+  fix_twist_publisher_.publish([&](geometry_msgs::msg::TwistWithCovarianceStamped & twist_msg) {
+      twist_msg.header.stamp = msg->header.stamp;
+
+      twist_msg.twist.twist.linear.x = twist[0];
+      twist_msg.twist.twist.linear.y = twist[1];
+      twist_msg.twist.twist.linear.z = twist[2];
+      twist_msg.twist.twist.angular.x = twist[3];
+      twist_msg.twist.twist.angular.y = twist[4];
+      twist_msg.twist.twist.angular.z = twist[5];
+      twist_msg.twist.covariance = twist_covariance;
+      return true;
+    });
 }
+
+RCLCPP_COMPONENTS_REGISTER_NODE(PoseCovariancePublisher)
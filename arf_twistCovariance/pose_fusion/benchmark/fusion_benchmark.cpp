@@ -0,0 +1,251 @@
+#include "pose_fusion/ekf.hpp"
+#include "pose_fusion/fusion_kernels.hpp"
+#include "pose_fusion/mahalanobis_gate.hpp"
+#include "pose_fusion/source_watchdog.hpp"
+#include "pose_fusion/spsc_queue.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Kernel benchmarks for the pose and twist fusion paths of PoseFusionNode.
+// Streams are filled like the node sees them: every source at 10 Hz, the sources offset
+// evenly within a period, so interpolation always has a bracketing pair.
+
+namespace
+{
+
+constexpr std::size_t kCapacity = 64;
+constexpr int64_t kPeriodNs = 100000000;
+
+PoseSample makePose(double x, double variance)
+{
+    PoseSample sample;
+    sample.pose.position.x = x;
+    sample.pose.position.y = 2.0 * x;
+    sample.pose.position.z = 0.1 * x;
+    sample.pose.orientation.z = 0.38268343236508978;
+    sample.pose.orientation.w = 0.92387953251128674;
+    for (std::size_t i = 0; i < 36; i += 7)
+    {
+        sample.covariance[i] = variance;
+    }
+    // Position/yaw correlation, as a scan matcher would report it
+    sample.covariance[5] = sample.covariance[30] = 0.1 * variance;
+    return sample;
+}
+
+TwistSample makeTwist(double yaw_rate, double variance)
+{
+    TwistSample sample;
+    sample.twist.linear.x = 5.0;
+    sample.twist.angular.z = yaw_rate;
+    for (std::size_t i = 0; i < 36; i += 7)
+    {
+        sample.covariance[i] = variance;
+    }
+    return sample;
+}
+
+template <typename T, typename MakeFn>
+void fill(StampedRingBuffer<T, kCapacity> &buffer, int64_t offset_ns, double variance, MakeFn make)
+{
+    for (std::size_t i = 0; i < kCapacity; ++i)
+    {
+        buffer.push(static_cast<int64_t>(i) * kPeriodNs + offset_ns, make(static_cast<double>(i), variance));
+    }
+}
+
+// Walks through the buffered range so the bracket search is not always the same
+int64_t nextStamp(int64_t stamp_ns)
+{
+    const int64_t next_ns = stamp_ns + kPeriodNs / 3;
+    return next_ns < static_cast<int64_t>(kCapacity - 1) * kPeriodNs ? next_ns : kPeriodNs;
+}
+
+PlainTwistSample makePlainTwist(double yaw_rate, double /*variance*/)
+{
+    return makeTwist(yaw_rate, 0.0).twist;
+}
+
+FusionSettings settings(bool interpolate)
+{
+    FusionSettings result;
+    result.sync_window_ns = kPeriodNs;
+    result.interpolate = interpolate;
+    return result;
+}
+
+// count sources of one kind, evenly staggered within a period and with growing variance
+template <typename T, typename MakeFn>
+std::vector<FusionSource<T, kCapacity>> makeSources(std::size_t count, double variance, MakeFn make)
+{
+    std::vector<FusionSource<T, kCapacity>> sources(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        fill(sources[i].buffer, static_cast<int64_t>(i) * kPeriodNs / static_cast<int64_t>(count),
+             variance * static_cast<double>(i + 1), make);
+    }
+    return sources;
+}
+
+// Strategy: WeightedFusion or InformationFusion, range(0): interpolate, range(1): sources
+template <typename Strategy>
+void BM_FusePoseSources(benchmark::State &state)
+{
+    auto sources = makeSources<PoseSample>(static_cast<std::size_t>(state.range(1)), 0.05, makePose);
+    const FusionSettings fusion_settings = settings(state.range(0) != 0);
+
+    InformationAccumulator information;
+    PoseSample fused;
+    int64_t stamp_ns = kPeriodNs;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fusePoseSources<Strategy>(sources, stamp_ns, fusion_settings, information, fused));
+        benchmark::DoNotOptimize(fused);
+        stamp_ns = nextStamp(stamp_ns);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_FusePoseSources, WeightedFusion)->ArgsProduct({{0, 1}, {2, 4, 8}})->ArgNames({"interpolate", "sources"});
+BENCHMARK_TEMPLATE(BM_FusePoseSources, InformationFusion)->ArgsProduct({{0, 1}, {2, 4, 8}})->ArgNames({"interpolate", "sources"});
+
+// TwistT: TwistSample or PlainTwistSample (always weighted)
+template <typename Strategy, typename TwistT, TwistT (*Make)(double, double)>
+void BM_FuseTwistSources(benchmark::State &state)
+{
+    auto sources = makeSources<TwistT>(static_cast<std::size_t>(state.range(1)), 0.01, Make);
+    const FusionSettings fusion_settings = settings(state.range(0) != 0);
+
+    InformationAccumulator information;
+    TwistSample fused;
+    int64_t stamp_ns = kPeriodNs;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fuseTwistSources<Strategy>(sources, stamp_ns, fusion_settings, information, fused));
+        benchmark::DoNotOptimize(fused);
+        stamp_ns = nextStamp(stamp_ns);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_FuseTwistSources, WeightedFusion, TwistSample, makeTwist)
+    ->ArgsProduct({{0, 1}, {2, 4, 8}})->ArgNames({"interpolate", "sources"});
+BENCHMARK_TEMPLATE(BM_FuseTwistSources, InformationFusion, TwistSample, makeTwist)
+    ->ArgsProduct({{0, 1}, {2, 4, 8}})->ArgNames({"interpolate", "sources"});
+BENCHMARK_TEMPLATE(BM_FuseTwistSources, InformationFusion, PlainTwistSample, makePlainTwist)
+    ->ArgsProduct({{0, 1}, {2, 4, 8}})->ArgNames({"interpolate", "sources"});
+
+void BM_SampleAt(benchmark::State &state)
+{
+    StampedRingBuffer<PoseSample, kCapacity> buffer;
+    fill(buffer, 0, 0.05, makePose);
+    const bool interpolate = state.range(0) != 0;
+
+    PoseSample sample;
+    int64_t stamp_ns = kPeriodNs;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(sampleAt(buffer, stamp_ns, kPeriodNs, interpolate, sample));
+        benchmark::DoNotOptimize(sample);
+        stamp_ns = nextStamp(stamp_ns);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SampleAt)->Arg(0)->Arg(1)->ArgName("interpolate");
+
+void BM_EkfPredictUpdate(benchmark::State &state)
+{
+    ExtendedKalmanFilter<PoseTwistModel::kStateDim> ekf;
+    ekf.initialize(PoseTwistModel::StateVector::Zero(), PoseTwistModel::StateMatrix::Identity());
+
+    PoseTwistModel::StateVector twist;
+    twist << 5.0, 0.0, 0.0, 0.0, 0.0, 0.1;
+    const PoseTwistModel::StateMatrix noise = PoseTwistModel::StateMatrix::Identity() * 0.01;
+    const double dt = 0.01;
+
+    for (auto _ : state)
+    {
+        PoseTwistModel::StateMatrix jacobian;
+        const PoseTwistModel::StateVector predicted = PoseTwistModel::predict(ekf.state(), twist, dt, jacobian);
+        ekf.predict(predicted, jacobian, noise);
+
+        const PoseTwistModel::StateVector measurement = ekf.state();
+        benchmark::DoNotOptimize(ekf.update<6>(PoseTwistModel::poseInnovation(measurement, ekf.state()),
+                                               PoseTwistModel::StateMatrix::Identity(), noise));
+        PoseTwistModel::normalize(ekf.state());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EkfPredictUpdate);
+
+// One gate check: factorization of P + R and a triangular solve
+void BM_MahalanobisGate(benchmark::State &state)
+{
+    const PoseSample measurement = makePose(1.0, 0.5);
+    const PoseSample reference = makePose(0.0, 0.05);
+    const RowMajorMatrix6d reference_covariance = covarianceMap(reference.covariance);
+    Vector6d residual;
+    residual << 1.0, 2.0, 0.1, 0.0, 0.0, 0.01;
+
+    for (auto _ : state)
+    {
+        double distance_squared = 0.0;
+        benchmark::DoNotOptimize(mahalanobisDistanceSquared(residual, reference_covariance, measurement.covariance, distance_squared));
+        benchmark::DoNotOptimize(distance_squared);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MahalanobisGate);
+
+// Cost per message of the receipt timeouts: one receipt and one check on a 10 ms message
+// grid, range(0) sources all alive with 200 ms timeouts
+void BM_SourceWatchdog(benchmark::State &state)
+{
+    const std::size_t sources = static_cast<std::size_t>(state.range(0));
+    SourceWatchdog watchdog;
+    watchdog.configure(std::vector<int64_t>(sources, 200000000));
+
+    int64_t now_ns = 0;
+    std::size_t source = 0;
+    uint64_t transitions = 0;
+    for (auto _ : state)
+    {
+        now_ns += 10000000 / static_cast<int64_t>(sources);
+        watchdog.receive(source, now_ns);
+        watchdog.check(now_ns, [&transitions](std::size_t, bool) { ++transitions; });
+        source = source + 1 < sources ? source + 1 : 0;
+    }
+    benchmark::DoNotOptimize(transitions);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SourceWatchdog)->Arg(2)->Arg(4)->Arg(8)->ArgName("sources");
+
+// Callback -> fusion thread handoff of a message handle, single-threaded: the cost of
+// the queue itself without the cross-core cache traffic
+void BM_SpscQueueHandoff(benchmark::State &state)
+{
+    const std::size_t burst = static_cast<std::size_t>(state.range(0));
+    SpscQueue<std::shared_ptr<const PoseSample>> queue(16);
+    const auto message = std::make_shared<const PoseSample>(makePose(0.0, 0.05));
+    std::shared_ptr<const PoseSample> popped;
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < burst; ++i)
+        {
+            std::shared_ptr<const PoseSample> handle = message;
+            queue.tryPush(std::move(handle));
+        }
+        while (queue.tryPop(popped))
+        {
+            benchmark::DoNotOptimize(popped.get());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(burst));
+}
+BENCHMARK(BM_SpscQueueHandoff)->Arg(1)->Arg(8)->ArgName("burst");
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+#include "pose_fusion/pose_fusion_node.hpp"
+
+#include <benchmark/benchmark.h>
+#include <rclcpp/rclcpp.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// End-to-end throughput of PoseFusionNode: synthetic LiDAR and GNSS publishers feed the
+// node over intra-process communication and a subscriber counts the fused poses on
+// /final/pose_with_covariance, all on one SingleThreadedExecutor. Includes message
+// allocation, executor dispatch, buffering, fusion, the TF broadcast and delivery.
+
+namespace
+{
+
+using PoseMsg = geometry_msgs::msg::PoseWithCovarianceStamped;
+
+constexpr int64_t kPeriodNs = 10000000;
+// spin_some() calls without output before an iteration is counted as dropped
+constexpr int kMaxIdleSpins = 100;
+
+std::unique_ptr<PoseMsg> makePose(int64_t stamp_ns, double x, double variance)
+{
+    auto msg = std::make_unique<PoseMsg>();
+    msg->header.stamp = rclcpp::Time(stamp_ns);
+    msg->header.frame_id = "map";
+    msg->pose.pose.position.x = x;
+    msg->pose.pose.position.y = 2.0 * x;
+    msg->pose.pose.orientation.w = 1.0;
+    for (std::size_t i = 0; i < 36; i += 7)
+    {
+        msg->pose.covariance[i] = variance;
+    }
+    return msg;
+}
+
+// range(0): information form (1) or fixed weights (0)
+void BM_IntraProcessPoseFusion(benchmark::State &state)
+{
+    rclcpp::NodeOptions options;
+    options.use_intra_process_comms(true);
+    options.parameter_overrides({
+        rclcpp::Parameter("fusion_mode", std::string(state.range(0) != 0 ? "information" : "weighted")),
+        // Publish per fused pose instead of on the output timer, so every iteration produces one
+        rclcpp::Parameter("output_rate_hz", 0.0),
+    });
+
+    auto fusion_node = std::make_shared<PoseFusionNode>(options);
+    auto source_node = std::make_shared<rclcpp::Node>("pose_fusion_benchmark_source", rclcpp::NodeOptions().use_intra_process_comms(true));
+
+    auto lidar_pub = source_node->create_publisher<PoseMsg>("/localization/pose_with_covariance", 10);
+    auto gnss_pub = source_node->create_publisher<PoseMsg>("/fix_pose", 10);
+
+    uint64_t received = 0;
+    auto fused_sub = source_node->create_subscription<PoseMsg>(
+        "/final/pose_with_covariance", 10, [&received](const PoseMsg::ConstSharedPtr) { ++received; });
+
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(fusion_node->get_node_base_interface());
+    executor.add_node(source_node);
+
+    int64_t stamp_ns = 1000000000;
+    uint64_t dropped = 0;
+    for (auto _ : state)
+    {
+        const double x = static_cast<double>(stamp_ns) * 1e-9;
+        lidar_pub->publish(makePose(stamp_ns, x, 0.05));
+        gnss_pub->publish(makePose(stamp_ns + kPeriodNs / 10, x + 0.1, 0.5));
+
+        const uint64_t before = received;
+        int idle_spins = 0;
+        while (received == before && idle_spins < kMaxIdleSpins)
+        {
+            executor.spin_some();
+            ++idle_spins;
+        }
+        if (received == before)
+        {
+            ++dropped;
+        }
+        stamp_ns += kPeriodNs;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(received));
+    state.counters["dropped"] = static_cast<double>(dropped);
+}
+BENCHMARK(BM_IntraProcessPoseFusion)->Arg(0)->Arg(1)->ArgName("information")->UseRealTime();
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    rclcpp::init(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    rclcpp::shutdown();
+    return 0;
+}
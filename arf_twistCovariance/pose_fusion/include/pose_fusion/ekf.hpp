@@ -0,0 +1,178 @@
+#ifndef POSE_FUSION__EKF_HPP_
+#define POSE_FUSION__EKF_HPP_
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+
+// Generic extended Kalman filter over a fixed-size state. Every matrix is a
+// fixed-size Eigen type, so nothing is allocated after construction and the
+// products are unrolled by the compiler for the given dimensions.
+template <int StateDim>
+class ExtendedKalmanFilter
+{
+public:
+    using StateVector = Eigen::Matrix<double, StateDim, 1>;
+    using StateMatrix = Eigen::Matrix<double, StateDim, StateDim>;
+
+    void initialize(const StateVector &state, const StateMatrix &covariance)
+    {
+        x_ = state;
+        P_ = covariance;
+        initialized_ = true;
+    }
+
+    void reset() { initialized_ = false; }
+    bool initialized() const { return initialized_; }
+
+    // predicted_state = f(x, u), jacobian = df/dx evaluated at the current state
+    void predict(const StateVector &predicted_state, const StateMatrix &jacobian, const StateMatrix &process_noise)
+    {
+        x_ = predicted_state;
+        P_ = jacobian * P_ * jacobian.transpose() + process_noise;
+    }
+
+    // innovation = z - h(x). Uses the Joseph form so P stays symmetric positive
+    // semi-definite. Returns false if the innovation covariance is singular.
+    template <int MeasDim>
+    bool update(const Eigen::Matrix<double, MeasDim, 1> &innovation,
+                const Eigen::Matrix<double, MeasDim, StateDim> &jacobian,
+                const Eigen::Matrix<double, MeasDim, MeasDim> &measurement_noise)
+    {
+        using MeasMatrix = Eigen::Matrix<double, MeasDim, MeasDim>;
+
+        const MeasMatrix innovation_covariance =
+            jacobian * P_ * jacobian.transpose() + measurement_noise;
+        const Eigen::LDLT<MeasMatrix> ldlt(innovation_covariance);
+        if (ldlt.info() != Eigen::Success || ldlt.vectorD().minCoeff() <= 0.0)
+        {
+            return false;
+        }
+
+        // K = P H^T S^-1, computed as (S^-1 H P)^T since S and P are symmetric
+        const Eigen::Matrix<double, StateDim, MeasDim> gain = ldlt.solve(jacobian * P_).transpose();
+
+        x_.noalias() += gain * innovation;
+        const StateMatrix i_kh = StateMatrix::Identity() - gain * jacobian;
+        P_ = i_kh * P_ * i_kh.transpose() + gain * measurement_noise * gain.transpose();
+        return true;
+    }
+
+    const StateVector &state() const { return x_; }
+    StateVector &state() { return x_; }
+    const StateMatrix &covariance() const { return P_; }
+
+private:
+    StateVector x_ = StateVector::Zero();
+    StateMatrix P_ = StateMatrix::Identity();
+    bool initialized_ = false;
+};
+
+// 6-DoF constant-twist motion model for ExtendedKalmanFilter<6>.
+// State: [x, y, z, roll, pitch, yaw] in the map frame, control: body-frame twist
+// [vx, vy, vz, wx, wy, wz] as published on /fused_twist.
+struct PoseTwistModel
+{
+    static constexpr int kStateDim = 6;
+
+    using StateVector = Eigen::Matrix<double, 6, 1>;
+    using StateMatrix = Eigen::Matrix<double, 6, 6>;
+
+    static double normalizeAngle(double angle)
+    {
+        return std::atan2(std::sin(angle), std::cos(angle));
+    }
+
+    static Eigen::Matrix3d rotation(double roll, double pitch, double yaw)
+    {
+        return (Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ()) *
+                Eigen::AngleAxisd(pitch, Eigen::Vector3d::UnitY()) *
+                Eigen::AngleAxisd(roll, Eigen::Vector3d::UnitX())).toRotationMatrix();
+    }
+
+    static Eigen::Vector3d rollPitchYaw(const Eigen::Quaterniond &q)
+    {
+        const double sinr_cosp = 2.0 * (q.w() * q.x() + q.y() * q.z());
+        const double cosr_cosp = 1.0 - 2.0 * (q.x() * q.x() + q.y() * q.y());
+        const double sinp = std::max(-1.0, std::min(1.0, 2.0 * (q.w() * q.y() - q.z() * q.x())));
+        const double siny_cosp = 2.0 * (q.w() * q.z() + q.x() * q.y());
+        const double cosy_cosp = 1.0 - 2.0 * (q.y() * q.y() + q.z() * q.z());
+        return Eigen::Vector3d(std::atan2(sinr_cosp, cosr_cosp), std::asin(sinp), std::atan2(siny_cosp, cosy_cosp));
+    }
+
+    static Eigen::Quaterniond quaternion(const StateVector &x)
+    {
+        return Eigen::Quaterniond(
+            Eigen::AngleAxisd(x(5), Eigen::Vector3d::UnitZ()) *
+            Eigen::AngleAxisd(x(4), Eigen::Vector3d::UnitY()) *
+            Eigen::AngleAxisd(x(3), Eigen::Vector3d::UnitX()));
+    }
+
+    // Propagates x by the body twist u over dt and returns df/dx. The orientation
+    // block of the Jacobian uses the small-angle approximation d(rpy')/d(rpy) = I.
+    static StateVector predict(const StateVector &x, const StateVector &u, double dt, StateMatrix &jacobian)
+    {
+        const double cr = std::cos(x(3)), sr = std::sin(x(3));
+        const double cp = std::cos(x(4)), sp = std::sin(x(4));
+        const double cy = std::cos(x(5)), sy = std::sin(x(5));
+
+        Eigen::Matrix3d rx, ry, rz, drx, dry, drz;
+        rx << 1, 0, 0, 0, cr, -sr, 0, sr, cr;
+        ry << cp, 0, sp, 0, 1, 0, -sp, 0, cp;
+        rz << cy, -sy, 0, sy, cy, 0, 0, 0, 1;
+        drx << 0, 0, 0, 0, -sr, -cr, 0, cr, -sr;
+        dry << -sp, 0, cp, 0, 0, 0, -cp, 0, -sp;
+        drz << -sy, -cy, 0, cy, -sy, 0, 0, 0, 0;
+
+        const Eigen::Vector3d v = u.head<3>() * dt;
+        const Eigen::Matrix3d r = rz * ry * rx;
+
+        StateVector predicted;
+        predicted.head<3>() = x.head<3>() + r * v;
+
+        // Body-frame rotation increment
+        const Eigen::Vector3d w = u.tail<3>() * dt;
+        const double angle = w.norm();
+        const Eigen::Quaterniond dq = angle > 1e-12 ? Eigen::Quaterniond(Eigen::AngleAxisd(angle, w / angle))
+                                                    : Eigen::Quaterniond::Identity();
+        predicted.tail<3>() = rollPitchYaw((Eigen::Quaterniond(r) * dq).normalized());
+
+        jacobian.setIdentity();
+        jacobian.block<3, 1>(0, 3) = rz * ry * drx * v;
+        jacobian.block<3, 1>(0, 4) = rz * dry * rx * v;
+        jacobian.block<3, 1>(0, 5) = drz * ry * rx * v;
+        return predicted;
+    }
+
+    // d(x')/du for propagating the twist covariance into the process noise
+    static StateMatrix controlJacobian(const StateVector &x, double dt)
+    {
+        StateMatrix g = StateMatrix::Zero();
+        g.block<3, 3>(0, 0) = rotation(x(3), x(4), x(5)) * dt;
+        g.block<3, 3>(3, 3) = Eigen::Matrix3d::Identity() * dt;
+        return g;
+    }
+
+    // Wraps the orientation part of the state back into [-pi, pi]
+    static void normalize(StateVector &x)
+    {
+        for (int i = 3; i < 6; ++i)
+        {
+            x(i) = normalizeAngle(x(i));
+        }
+    }
+
+    // z - h(x) for a direct pose measurement [x, y, z, roll, pitch, yaw]
+    static StateVector poseInnovation(const StateVector &measurement, const StateVector &x)
+    {
+        StateVector innovation = measurement - x;
+        for (int i = 3; i < 6; ++i)
+        {
+            innovation(i) = normalizeAngle(innovation(i));
+        }
+        return innovation;
+    }
+};
+
+#endif  // POSE_FUSION__EKF_HPP_
@@ -0,0 +1,509 @@
+#ifndef POSE_FUSION__FUSION_KERNELS_HPP_
+#define POSE_FUSION__FUSION_KERNELS_HPP_
+
+#include <geometry_msgs/msg/pose_with_covariance.hpp>
+#include <geometry_msgs/msg/twist.hpp>
+#include <geometry_msgs/msg/twist_with_covariance.hpp>
+
+#include "pose_fusion/information_fusion.hpp"
+#include "pose_fusion/so3.hpp"
+#include "pose_fusion/stamped_ring_buffer.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+// Fusion kernels of PoseFusionNode as pure functions of their inputs: no node state,
+// clock or logging, so they can be benchmarked and replayed outside of a node.
+
+using PoseSample = geometry_msgs::msg::PoseWithCovariance;
+using TwistSample = geometry_msgs::msg::TwistWithCovariance;
+// Twist inputs without covariance (TwistStamped topics)
+using PlainTwistSample = geometry_msgs::msg::Twist;
+
+// Fusion strategies, selected at compile time so every configuration is its own inlined
+// kernel. kInformation: inverse-covariance fusion of samples that carry a covariance,
+// kEkf: poses update an EKF instead of being fused with each other (twists are fused in
+// information form and drive its prediction).
+struct WeightedFusion
+{
+    static constexpr bool kInformation = false;
+    static constexpr bool kEkf = false;
+};
+
+struct InformationFusion
+{
+    static constexpr bool kInformation = true;
+    static constexpr bool kEkf = false;
+};
+
+struct EkfFusion
+{
+    static constexpr bool kInformation = true;
+    static constexpr bool kEkf = true;
+};
+
+template <typename T>
+struct SampleTraits;
+
+template <>
+struct SampleTraits<PoseSample>
+{
+    static constexpr bool kHasCovariance = true;
+};
+
+template <>
+struct SampleTraits<TwistSample>
+{
+    static constexpr bool kHasCovariance = true;
+};
+
+// Always fused with the fixed weights; the fused covariance is all zeros, which ROS
+// reads as "unknown"
+template <>
+struct SampleTraits<PlainTwistSample>
+{
+    static constexpr bool kHasCovariance = false;
+};
+
+inline void interpolateSample(const PoseSample &a, const PoseSample &b, double alpha, PoseSample &out)
+{
+    out.pose.position.x = a.pose.position.x + alpha * (b.pose.position.x - a.pose.position.x);
+    out.pose.position.y = a.pose.position.y + alpha * (b.pose.position.y - a.pose.position.y);
+    out.pose.position.z = a.pose.position.z + alpha * (b.pose.position.z - a.pose.position.z);
+
+    const Eigen::Quaterniond qa = normalizedQuaternion(toQuaternion(a.pose.orientation));
+    const Eigen::Quaterniond qb = toQuaternion(b.pose.orientation);
+    setQuaternion(quaternionExp(alpha * rotationResidual(qb, qa)) * qa, out.pose.orientation);
+
+    for (size_t i = 0; i < 36; ++i)
+    {
+        out.covariance[i] = a.covariance[i] + alpha * (b.covariance[i] - a.covariance[i]);
+    }
+}
+
+inline void interpolateSample(const PlainTwistSample &a, const PlainTwistSample &b, double alpha, PlainTwistSample &out)
+{
+    out.linear.x = a.linear.x + alpha * (b.linear.x - a.linear.x);
+    out.linear.y = a.linear.y + alpha * (b.linear.y - a.linear.y);
+    out.linear.z = a.linear.z + alpha * (b.linear.z - a.linear.z);
+    out.angular.x = a.angular.x + alpha * (b.angular.x - a.angular.x);
+    out.angular.y = a.angular.y + alpha * (b.angular.y - a.angular.y);
+    out.angular.z = a.angular.z + alpha * (b.angular.z - a.angular.z);
+}
+
+inline void interpolateSample(const TwistSample &a, const TwistSample &b, double alpha, TwistSample &out)
+{
+    interpolateSample(a.twist, b.twist, alpha, out.twist);
+
+    for (size_t i = 0; i < 36; ++i)
+    {
+        out.covariance[i] = a.covariance[i] + alpha * (b.covariance[i] - a.covariance[i]);
+    }
+}
+
+inline Vector6d toVector(const PlainTwistSample &twist)
+{
+    Vector6d v;
+    v << twist.linear.x, twist.linear.y, twist.linear.z, twist.angular.x, twist.angular.y, twist.angular.z;
+    return v;
+}
+
+inline Vector6d toVector(const TwistSample &sample)
+{
+    return toVector(sample.twist);
+}
+
+// Entry stamp reported by sampleAt for a sample interpolated between two entries
+constexpr int64_t kInterpolatedSample = std::numeric_limits<int64_t>::min();
+
+// Evaluates a buffered stream at stamp_ns. When interpolating, both bracketing samples
+// must lie inside the sync window; otherwise the nearest sample inside the window is used.
+// entry_stamp_ns (optional) receives the stamp of the buffered entry that was returned
+// as is, or kInterpolatedSample.
+template <typename T, std::size_t N>
+bool sampleAt(const StampedRingBuffer<T, N> &buffer, int64_t stamp_ns, int64_t window_ns, bool interpolate, T &out,
+              int64_t *entry_stamp_ns = nullptr)
+{
+    if (interpolate)
+    {
+        const typename StampedRingBuffer<T, N>::Entry *before = nullptr;
+        const typename StampedRingBuffer<T, N>::Entry *after = nullptr;
+        if (buffer.bracket(stamp_ns, before, after) &&
+            stamp_ns - before->stamp_ns <= window_ns && after->stamp_ns - stamp_ns <= window_ns)
+        {
+            if (before == after)
+            {
+                out = before->value;
+                if (entry_stamp_ns)
+                {
+                    *entry_stamp_ns = before->stamp_ns;
+                }
+            }
+            else
+            {
+                const double alpha = static_cast<double>(stamp_ns - before->stamp_ns) /
+                                     static_cast<double>(after->stamp_ns - before->stamp_ns);
+                interpolateSample(before->value, after->value, alpha, out);
+                if (entry_stamp_ns)
+                {
+                    *entry_stamp_ns = kInterpolatedSample;
+                }
+            }
+            return true;
+        }
+    }
+
+    const auto *entry = buffer.nearest(stamp_ns, window_ns);
+    if (!entry)
+    {
+        return false;
+    }
+    out = entry->value;
+    if (entry_stamp_ns)
+    {
+        *entry_stamp_ns = entry->stamp_ns;
+    }
+    return true;
+}
+
+// One input stream of the N-way fusion. Sources of one kind live in a contiguous array
+// and are addressed by index, so a message reaches its slot without a lookup.
+template <typename T, std::size_t N>
+struct FusionSource
+{
+    StampedRingBuffer<T, N> buffer;
+    // Fixed weight of the weighted kernels, normalised over the contributing sources
+    double weight = 1.0;
+    // False: dropped from fusion (timed out), contributes nothing
+    bool enabled = true;
+
+    // Scratch of fuseSources: the source's value at the fusion stamp, if it has one, and
+    // the stamp of the buffered entry it is (kInterpolatedSample when interpolated)
+    T sample;
+    bool present = false;
+    int64_t sample_stamp_ns = kInterpolatedSample;
+
+    // Information contribution (P^-1, P^-1 x) of the entry at contribution_stamp_ns. A
+    // source without new data contributes the same entry again and reuses P^-1, so only
+    // the sources that changed are inverted.
+    Matrix6d information = Matrix6d::Zero();
+    Vector6d information_vector = Vector6d::Zero();
+    int64_t contribution_stamp_ns = kInterpolatedSample;
+    bool contribution_valid = false;
+};
+
+// Adds the information contribution of source.sample with the given mean. P^-1 is only
+// recomputed when the sample is not the entry it was computed for; P^-1 x is formed on
+// every call, since a pose's rotational residual depends on the reference orientation of
+// the fusion. False if the covariance is not positive definite.
+template <typename Source>
+bool addContribution(InformationAccumulator &information, Source &source, const Vector6d &mean)
+{
+    if (source.sample_stamp_ns == kInterpolatedSample || source.sample_stamp_ns != source.contribution_stamp_ns)
+    {
+        source.contribution_valid = information.contribution(mean, covarianceMap(source.sample.covariance), source.information,
+                                                             source.information_vector);
+        source.contribution_stamp_ns = source.sample_stamp_ns;
+    }
+    else if (source.contribution_valid)
+    {
+        source.information_vector.noalias() = source.information * mean;
+    }
+    if (!source.contribution_valid)
+    {
+        return false;
+    }
+    information.add(source.information, source.information_vector);
+    return true;
+}
+
+// A pose as [position, rotation vector about reference], the tangent-space mean of the
+// pose kernels
+inline Vector6d poseTangent(const PoseSample &sample, const Eigen::Quaterniond &reference)
+{
+    const auto &pose = sample.pose;
+    Vector6d tangent;
+    tangent.head<3>() << pose.position.x, pose.position.y, pose.position.z;
+    tangent.tail<3>() = rotationResidual(toQuaternion(pose.orientation), reference);
+    return tangent;
+}
+
+// Weight of a contributing source; all-zero weights fall back to equal weights
+template <typename Source>
+double normalizedWeight(const Source &source, double weight_sum, std::size_t present)
+{
+    return weight_sum > 0.0 ? source.weight / weight_sum : 1.0 / static_cast<double>(present);
+}
+
+// Fixed-weight pose fusion over the present sources. Orientation is averaged in the
+// tangent space of the first present source (LiDAR first in the default configuration):
+// per axis with the fixed weights over the rotational variances, so a source without
+// attitude (a GNSS fix, huge roll/pitch/yaw variance) leaves it alone while a
+// dual-antenna yaw contributes. An axis no source has a positive variance for falls back
+// to the fixed weights.
+template <typename Sources>
+void weightedFusePoses(const Sources &sources, double weight_sum, std::size_t present, PoseSample &fused)
+{
+    Eigen::Vector3d position = Eigen::Vector3d::Zero();
+    RowMajorMatrix6d covariance = RowMajorMatrix6d::Zero();
+    Eigen::Quaterniond reference = Eigen::Quaterniond::Identity();
+    bool reference_set = false;
+    Eigen::Vector3d rotation = Eigen::Vector3d::Zero();
+    Eigen::Vector3d precision_sum = Eigen::Vector3d::Zero();
+    Eigen::Vector3d fixed_rotation = Eigen::Vector3d::Zero();
+    for (const auto &source : sources)
+    {
+        if (!source.present)
+        {
+            continue;
+        }
+        const double weight = normalizedWeight(source, weight_sum, present);
+        const auto &pose = source.sample.pose;
+        const ConstCovarianceMap source_covariance = covarianceMap(source.sample.covariance);
+        position += weight * Eigen::Vector3d(pose.position.x, pose.position.y, pose.position.z);
+        covariance += weight * source_covariance;
+
+        if (!reference_set)
+        {
+            reference = normalizedQuaternion(toQuaternion(pose.orientation));
+            reference_set = true;
+        }
+        const Eigen::Vector3d residual = rotationResidual(toQuaternion(pose.orientation), reference);
+        const Eigen::Array3d variance = source_covariance.diagonal().tail<3>().array();
+        const Eigen::Vector3d precision = (variance > 0.0).select(weight * variance.max(kMinPivot).inverse(), 0.0).matrix();
+        rotation += precision.cwiseProduct(residual);
+        precision_sum += precision;
+        fixed_rotation += weight * residual;
+    }
+
+    const Eigen::Vector3d delta =
+        (precision_sum.array() > 0.0).select(rotation.array() / precision_sum.array().max(kMinPivot), fixed_rotation.array()).matrix();
+    fused.pose.position.x = position.x();
+    fused.pose.position.y = position.y();
+    fused.pose.position.z = position.z();
+    setQuaternion(quaternionExp(delta) * reference, fused.pose.orientation);
+    covarianceMap(fused.covariance) = covariance;
+}
+
+// All six twist components are fused with the same weights. Plain twists carry no
+// covariance, so their fused covariance is all zeros ("unknown").
+template <typename Sources>
+void weightedFuseTwists(const Sources &sources, double weight_sum, std::size_t present, TwistSample &fused)
+{
+    Vector6d twist = Vector6d::Zero();
+    RowMajorMatrix6d covariance = RowMajorMatrix6d::Zero();
+    for (const auto &source : sources)
+    {
+        if (!source.present)
+        {
+            continue;
+        }
+        const double weight = normalizedWeight(source, weight_sum, present);
+        twist += weight * toVector(source.sample);
+        if constexpr (SampleTraits<std::decay_t<decltype(source.sample)>>::kHasCovariance)
+        {
+            covariance += weight * covarianceMap(source.sample.covariance);
+        }
+    }
+
+    fused.twist.linear.x = twist(0);
+    fused.twist.linear.y = twist(1);
+    fused.twist.linear.z = twist(2);
+    fused.twist.angular.x = twist(3);
+    fused.twist.angular.y = twist(4);
+    fused.twist.angular.z = twist(5);
+    covarianceMap(fused.covariance) = covariance;
+}
+
+// Relinearisations of the orientation fusion, done while the correction exceeds
+// kRelinearizeAngleSquared [rad^2]
+constexpr int kMaxRelinearizations = 3;
+constexpr double kRelinearizeAngleSquared = 1e-12;
+
+// Information-form pose fusion on SE(3) linearised per fusion: every sample enters as
+// [position, rotation vector relative to a reference orientation], with its full 6x6
+// covariance (rotation block about the fixed axes, cross terms included), and the fused
+// rotation vector is applied back onto the reference. The reference starts at the first
+// present source and moves to the fused orientation while the correction is not
+// negligible; those passes reuse P^-1 of every source and the factorisation of the sum,
+// so they cost one 6x6 product per source. The fused covariance is expressed about the
+// fused orientation.
+template <typename Sources>
+bool informationFusePoses(InformationAccumulator &information, Sources &sources, PoseSample &fused)
+{
+    information.reset();
+
+    Eigen::Quaterniond reference = Eigen::Quaterniond::Identity();
+    bool reference_set = false;
+    for (auto &source : sources)
+    {
+        if (!source.present)
+        {
+            continue;
+        }
+        if (!reference_set)
+        {
+            reference = normalizedQuaternion(toQuaternion(source.sample.pose.orientation));
+            reference_set = true;
+        }
+        if (!addContribution(information, source, poseTangent(source.sample, reference)))
+        {
+            return false;
+        }
+    }
+
+    Vector6d mean;
+    if (!information.solve(mean, covarianceMap(fused.covariance)))
+    {
+        return false;
+    }
+
+    for (int pass = 0; pass < kMaxRelinearizations && mean.tail<3>().squaredNorm() > kRelinearizeAngleSquared; ++pass)
+    {
+        reference = quaternionExp(mean.tail<3>()) * reference;
+        Vector6d information_vector = Vector6d::Zero();
+        for (const auto &source : sources)
+        {
+            if (source.present)
+            {
+                information_vector.noalias() += source.information * poseTangent(source.sample, reference);
+            }
+        }
+        information.solveMean(information_vector, mean);
+    }
+
+    fused.pose.position.x = mean(0);
+    fused.pose.position.y = mean(1);
+    fused.pose.position.z = mean(2);
+    setQuaternion(normalizedQuaternion(quaternionExp(mean.tail<3>()) * reference), fused.pose.orientation);
+    return true;
+}
+
+template <typename Sources>
+bool informationFuseTwists(InformationAccumulator &information, Sources &sources, TwistSample &fused)
+{
+    information.reset();
+
+    for (auto &source : sources)
+    {
+        if (source.present && !addContribution(information, source, toVector(source.sample)))
+        {
+            return false;
+        }
+    }
+
+    Vector6d mean;
+    if (!information.solve(mean, covarianceMap(fused.covariance)))
+    {
+        return false;
+    }
+
+    fused.twist.linear.x = mean(0);
+    fused.twist.linear.y = mean(1);
+    fused.twist.linear.z = mean(2);
+    fused.twist.angular.x = mean(3);
+    fused.twist.angular.y = mean(4);
+    fused.twist.angular.z = mean(5);
+    return true;
+}
+
+// Settings shared by the pose and twist paths
+struct FusionSettings
+{
+    int64_t sync_window_ns = 0;
+    bool interpolate = true;
+    // Sources that must have a sample at the fusion stamp (0: all of them)
+    std::size_t min_sources = 0;
+};
+
+enum class FusionResult
+{
+    kNoSamples,         // fewer than min_sources sources have a sample inside the sync window, nothing written
+    kInformation,       // inverse-covariance fusion
+    kWeighted,          // fixed weights
+    kWeightedFallback   // information fusion requested but a covariance was not positive definite
+};
+
+// Fuses the sources that have a sample at stamp_ns into fused (pose and covariance
+// only; the caller fills the header). One pass over the contiguous source array; the
+// strategy and sample type decide at compile time whether the information form is
+// tried, the weighted kernel is the fallback.
+template <typename Strategy, typename Sources, typename FusedT, typename InformationFn, typename WeightedFn>
+FusionResult fuseSources(Sources &sources, int64_t stamp_ns, const FusionSettings &settings, InformationAccumulator &information,
+                         InformationFn information_fuse, WeightedFn weighted_fuse, FusedT &fused)
+{
+    using Sample = std::decay_t<decltype(std::begin(sources)->sample)>;
+
+    std::size_t count = 0;
+    std::size_t present = 0;
+    double weight_sum = 0.0;
+    for (auto &source : sources)
+    {
+        ++count;
+        source.present = source.enabled && sampleAt(source.buffer, stamp_ns, settings.sync_window_ns, settings.interpolate,
+                                                    source.sample, &source.sample_stamp_ns);
+        if (source.present)
+        {
+            ++present;
+            weight_sum += source.weight;
+        }
+    }
+
+    const std::size_t required = settings.min_sources > 0 ? std::min(settings.min_sources, count) : count;
+    if (present == 0 || present < required)
+    {
+        return FusionResult::kNoSamples;
+    }
+
+    if constexpr (Strategy::kInformation && SampleTraits<Sample>::kHasCovariance)
+    {
+        if (information_fuse(information, sources, fused))
+        {
+            return FusionResult::kInformation;
+        }
+        weighted_fuse(sources, weight_sum, present, fused);
+        return FusionResult::kWeightedFallback;
+    }
+    else
+    {
+        static_cast<void>(information_fuse);
+        weighted_fuse(sources, weight_sum, present, fused);
+        return FusionResult::kWeighted;
+    }
+}
+
+// Sources: contiguous container of FusionSource<PoseSample, N>
+template <typename Strategy, typename Sources>
+FusionResult fusePoseSources(Sources &sources, int64_t stamp_ns, const FusionSettings &settings, InformationAccumulator &information,
+                             PoseSample &fused)
+{
+    return fuseSources<Strategy>(sources, stamp_ns, settings, information,
+                                 [](InformationAccumulator &accumulator, Sources &in, PoseSample &out)
+                                 { return informationFusePoses(accumulator, in, out); },
+                                 [](const Sources &in, double weight_sum, std::size_t present, PoseSample &out)
+                                 { weightedFusePoses(in, weight_sum, present, out); },
+                                 fused);
+}
+
+// Sources: contiguous container of FusionSource<TwistSample or PlainTwistSample, N>; the
+// fused twist always carries a covariance
+template <typename Strategy, typename Sources>
+FusionResult fuseTwistSources(Sources &sources, int64_t stamp_ns, const FusionSettings &settings, InformationAccumulator &information,
+                              TwistSample &fused)
+{
+    return fuseSources<Strategy>(sources, stamp_ns, settings, information,
+                                 // Generic, so it is only instantiated for twists that carry a covariance
+                                 [](InformationAccumulator &accumulator, auto &in, TwistSample &out)
+                                 { return informationFuseTwists(accumulator, in, out); },
+                                 [](const Sources &in, double weight_sum, std::size_t present, TwistSample &out)
+                                 { weightedFuseTwists(in, weight_sum, present, out); },
+                                 fused);
+}
+
+#endif  // POSE_FUSION__FUSION_KERNELS_HPP_
@@ -0,0 +1,97 @@
+#ifndef POSE_FUSION__FUSION_THREAD_HPP_
+#define POSE_FUSION__FUSION_THREAD_HPP_
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Wakes the fusion thread when work was queued. notify() is a fence and a load while the
+// thread is busy and only takes the mutex when it is (about to be) asleep: the sleeper
+// announces itself before its last look at the queues and a producer looks for a sleeper
+// after publishing, with a seq_cst fence in between on both sides, so at least one of
+// them sees the other.
+class ThreadWakeup
+{
+public:
+    // Producers, after publishing the work
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed))
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                signalled_ = true;
+            }
+            condition_.notify_one();
+        }
+    }
+
+    // Consumer: sleeps until notified or timeout unless has_work() is already true
+    template <typename HasWorkFn>
+    void wait(std::chrono::nanoseconds timeout, HasWorkFn &&has_work)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!has_work())
+        {
+            condition_.wait_for(lock, timeout, [this]() { return signalled_; });
+        }
+        signalled_ = false;
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<bool> sleeping_{false};
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool signalled_ = false;
+};
+
+// CPU and scheduling policy of a dedicated thread
+struct ThreadPolicy
+{
+    int cpu = -1;      // pin to this core (-1: any)
+    int priority = 0;  // SCHED_FIFO priority (0: SCHED_OTHER)
+};
+
+// Applies policy to thread. Both steps are attempted; false with the reasons in error when
+// one failed (typically SCHED_FIFO without CAP_SYS_NICE / rtprio limits), the thread keeps
+// running with what could be applied.
+inline bool applyThreadPolicy(std::thread &thread, const ThreadPolicy &policy, std::string &error)
+{
+    error.clear();
+    if (policy.cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(policy.cpu, &cpus);
+        const int result = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+        if (result != 0)
+        {
+            error = "cannot pin to CPU " + std::to_string(policy.cpu) + ": " + std::strerror(result);
+        }
+    }
+    if (policy.priority > 0)
+    {
+        sched_param parameters{};
+        parameters.sched_priority = policy.priority;
+        const int result = pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &parameters);
+        if (result != 0)
+        {
+            error += (error.empty() ? "" : "; ") + std::string("cannot set SCHED_FIFO priority ") + std::to_string(policy.priority) + ": " +
+                     std::strerror(result);
+        }
+    }
+    return error.empty();
+}
+
+#endif  // POSE_FUSION__FUSION_THREAD_HPP_
@@ -0,0 +1,118 @@
+#ifndef POSE_FUSION__INFORMATION_FUSION_HPP_
+#define POSE_FUSION__INFORMATION_FUSION_HPP_
+
+#include <Eigen/Dense>
+
+#include <array>
+
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+// ROS stores 6x6 covariances as row-major double[36]; these maps view the message
+// arrays in place so the kernel reads and writes them without an intermediate copy.
+using RowMajorMatrix6d = Eigen::Matrix<double, 6, 6, Eigen::RowMajor>;
+using CovarianceMap = Eigen::Map<RowMajorMatrix6d>;
+using ConstCovarianceMap = Eigen::Map<const RowMajorMatrix6d>;
+
+inline ConstCovarianceMap covarianceMap(const std::array<double, 36> &covariance)
+{
+    return ConstCovarianceMap(covariance.data());
+}
+
+inline CovarianceMap covarianceMap(std::array<double, 36> &covariance)
+{
+    return CovarianceMap(covariance.data());
+}
+
+// Smallest LDLT pivot accepted as a valid covariance; anything below is treated as
+// a missing or degenerate covariance (e.g. an all-zero array) rather than as certainty.
+constexpr double kMinPivot = 1e-12;
+
+// Information-form fusion of independent Gaussian estimates:
+//   Lambda = sum_i P_i^-1,  eta = sum_i P_i^-1 x_i,  x = Lambda^-1 eta,  P = Lambda^-1
+// All matrices are fixed-size so Eigen unrolls the 6x6 arithmetic at compile time.
+class InformationAccumulator
+{
+public:
+    void reset()
+    {
+        information_.setZero();
+        information_vector_.setZero();
+        count_ = 0;
+    }
+
+    // Information form (P^-1, P^-1 x) of one estimate, for callers that keep it across
+    // fusions. Returns false if the covariance is not positive definite.
+    template <typename Derived>
+    bool contribution(const Vector6d &mean, const Eigen::MatrixBase<Derived> &covariance, Matrix6d &information,
+                      Vector6d &information_vector)
+    {
+        ldlt_.compute(covariance);
+        if (ldlt_.info() != Eigen::Success || ldlt_.vectorD().minCoeff() <= kMinPivot)
+        {
+            return false;
+        }
+
+        information = ldlt_.solve(Matrix6d::Identity());
+        information_vector.noalias() = information * mean;
+        return true;
+    }
+
+    // Adds a contribution computed by contribution()
+    void add(const Matrix6d &information, const Vector6d &information_vector)
+    {
+        information_ += information;
+        information_vector_ += information_vector;
+        ++count_;
+    }
+
+    // Adds one estimate. Returns false (and adds nothing) if the covariance is not
+    // positive definite.
+    template <typename Derived>
+    bool add(const Vector6d &mean, const Eigen::MatrixBase<Derived> &covariance)
+    {
+        Matrix6d information;
+        Vector6d information_vector;
+        if (!contribution(mean, covariance, information, information_vector))
+        {
+            return false;
+        }
+        add(information, information_vector);
+        return true;
+    }
+
+    // Writes the fused mean and covariance. covariance may be a CovarianceMap onto
+    // the outgoing message.
+    template <typename Derived>
+    bool solve(Vector6d &mean, const Eigen::MatrixBase<Derived> &covariance)
+    {
+        if (count_ == 0)
+        {
+            return false;
+        }
+
+        ldlt_.compute(information_);
+        if (ldlt_.info() != Eigen::Success || ldlt_.vectorD().minCoeff() <= kMinPivot)
+        {
+            return false;
+        }
+
+        mean = ldlt_.solve(information_vector_);
+        const_cast<Eigen::MatrixBase<Derived> &>(covariance) = ldlt_.solve(Matrix6d::Identity());
+        return true;
+    }
+
+    // Mean for another information vector over the information matrix of the last
+    // successful solve(), reusing its factorisation
+    void solveMean(const Vector6d &information_vector, Vector6d &mean) const { mean = ldlt_.solve(information_vector); }
+
+    int count() const { return count_; }
+
+private:
+    Matrix6d information_ = Matrix6d::Zero();
+    Vector6d information_vector_ = Vector6d::Zero();
+    Eigen::LDLT<Matrix6d> ldlt_;
+    int count_ = 0;
+};
+
+#endif  // POSE_FUSION__INFORMATION_FUSION_HPP_
@@ -0,0 +1,34 @@
+#ifndef POSE_FUSION__MAHALANOBIS_GATE_HPP_
+#define POSE_FUSION__MAHALANOBIS_GATE_HPP_
+
+#include "pose_fusion/information_fusion.hpp"
+
+#include <Eigen/Cholesky>
+
+#include <array>
+
+// Squared Mahalanobis distance d^2 = r^T (P + R)^-1 r of a 6-DoF residual r between a
+// measurement (covariance R) and a reference estimate (covariance P). Under a correct
+// model d^2 is chi-square distributed with 6 degrees of freedom, so comparing it with a
+// chi-square quantile gates outliers.
+//
+// P + R is factored on every call: the reference changes with every fusion, EKF update and
+// prediction, so there is nothing to reuse, and a 6x6 Cholesky factorization on fixed-size
+// types is cheap and does not allocate. False when P + R is not positive definite, i.e. the
+// measurement cannot be gated.
+template <typename Derived>
+bool mahalanobisDistanceSquared(const Vector6d &residual, const Eigen::MatrixBase<Derived> &reference_covariance,
+                                const std::array<double, 36> &measurement_covariance, double &distance_squared)
+{
+    const Eigen::LLT<Matrix6d> llt(reference_covariance + covarianceMap(measurement_covariance));
+    if (llt.info() != Eigen::Success || llt.matrixLLT().diagonal().minCoeff() <= kMinPivot)
+    {
+        return false;
+    }
+
+    // r^T (L L^T)^-1 r = |L^-1 r|^2
+    distance_squared = llt.matrixL().solve(residual).squaredNorm();
+    return true;
+}
+
+#endif  // POSE_FUSION__MAHALANOBIS_GATE_HPP_
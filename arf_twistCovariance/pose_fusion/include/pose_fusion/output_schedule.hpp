@@ -0,0 +1,71 @@
+#ifndef POSE_FUSION__OUTPUT_SCHEDULE_HPP_
+#define POSE_FUSION__OUTPUT_SCHEDULE_HPP_
+
+#include <cstdint>
+
+// Fixed-rate output grid t_k = t_0 + k * period anchored at the first tick. Every output
+// is stamped with a grid time, so downstream sees a constant stamp interval regardless of
+// timer wake-up jitter. Wake-ups up to a quarter period early still count for their grid
+// time (the anchor tick itself carries jitter). A tick more than the deadline after its
+// grid time is late; grid times that passed without a tick are skipped and the grid
+// resumes at the newest due grid time.
+class OutputSchedule
+{
+public:
+    struct Tick
+    {
+        bool due = false;          // false: woke up before the next grid time, nothing to publish
+        int64_t stamp_ns = 0;      // grid time to publish at (at most period / 4 after now)
+        int64_t lateness_ns = 0;   // now - stamp_ns, negative for an early wake-up
+        uint64_t skipped = 0;      // grid times without output since the previous tick
+        bool late = false;         // lateness_ns > deadline
+    };
+
+    // deadline_ns <= 0: half a period
+    void configure(int64_t period_ns, int64_t deadline_ns)
+    {
+        period_ns_ = period_ns > 0 ? period_ns : 1;
+        deadline_ns_ = deadline_ns > 0 ? deadline_ns : period_ns_ / 2;
+        reset();
+    }
+
+    void reset() { anchored_ = false; }
+
+    int64_t period() const { return period_ns_; }
+
+    Tick next(int64_t now_ns)
+    {
+        Tick tick;
+        // First tick, or the clock jumped back (e.g. a replayed bag restarted): new grid
+        if (!anchored_ || now_ns < last_stamp_ns_ - period_ns_)
+        {
+            anchored_ = true;
+            last_stamp_ns_ = now_ns;
+            tick.due = true;
+            tick.stamp_ns = now_ns;
+            return tick;
+        }
+
+        const int64_t steps = (now_ns - last_stamp_ns_ + period_ns_ / 4) / period_ns_;
+        if (steps < 1)
+        {
+            return tick;
+        }
+
+        tick.due = true;
+        tick.stamp_ns = last_stamp_ns_ + steps * period_ns_;
+        tick.lateness_ns = now_ns - tick.stamp_ns;
+        tick.skipped = static_cast<uint64_t>(steps - 1);
+        tick.late = tick.lateness_ns > deadline_ns_;
+        last_stamp_ns_ = tick.stamp_ns;
+        return tick;
+    }
+
+private:
+    int64_t period_ns_ = 1;
+    int64_t deadline_ns_ = 0;
+    bool anchored_ = false;
+    int64_t last_stamp_ns_ = 0;
+};
+
+#endif  // POSE_FUSION__OUTPUT_SCHEDULE_HPP_
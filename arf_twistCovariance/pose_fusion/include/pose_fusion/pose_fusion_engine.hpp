@@ -0,0 +1,812 @@
+#ifndef POSE_FUSION__POSE_FUSION_ENGINE_HPP_
+#define POSE_FUSION__POSE_FUSION_ENGINE_HPP_
+
+#include <geometry_msgs/msg/pose.hpp>
+
+#include "pose_fusion/ekf.hpp"
+#include "pose_fusion/fusion_kernels.hpp"
+#include "pose_fusion/information_fusion.hpp"
+#include "pose_fusion/mahalanobis_gate.hpp"
+#include "pose_fusion/output_schedule.hpp"
+#include "pose_fusion/seqlock.hpp"
+#include "pose_fusion/source_watchdog.hpp"
+#include "pose_fusion/stamped_ring_buffer.hpp"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+struct PoseFusionConfig
+{
+    // Samples further than this from the fusion stamp are not used
+    int64_t sync_window_ns = 100000000;
+    // true: interpolate between bracketing samples, false: take the nearest sample
+    bool interpolate = true;
+
+    // One entry per pose / twist source, in slot order; the size sets the number of
+    // sources. Weights of the weighted kernels, normalised over the sources that
+    // contribute to a fusion. The defaults are LiDAR, GNSS and EKF, filter twist.
+    std::vector<double> pose_source_weights = {0.5, 0.5};
+    std::vector<double> twist_source_weights = {0.5, 0.5};
+    // Sources that must have a sample at the fusion stamp (0: all of them)
+    std::size_t min_pose_sources = 0;
+    std::size_t min_twist_sources = 0;
+    // Receipt timeout per source, in slot order (missing or <= 0: never times out). A
+    // source that received nothing for this long is stale: it drops out of fusion and is
+    // not waited for until it sends again.
+    std::vector<int64_t> pose_source_timeouts_ns;
+    std::vector<int64_t> twist_source_timeouts_ns;
+
+    // > 0: poses are output on a fixed grid by output(), 0: every fused pose is an output.
+    // The EKF always needs a grid.
+    int64_t output_period_ns = 10000000;
+    // A tick more than this after its grid time counts as late (0: half a period)
+    int64_t output_deadline_ns = 0;
+    bool output_extrapolate = true;
+    // The fused pose is not output once it is older than this
+    int64_t output_max_extrapolation_ns = 500000000;
+
+    double ekf_process_noise_position = 0.1;     // [m^2/s]
+    double ekf_process_noise_orientation = 0.01; // [rad^2/s]
+
+    // Poses whose squared Mahalanobis distance to the current estimate exceeds this
+    // chi-square threshold (6 DoF) are gated (0: no gating). Downweighting inflates the
+    // covariance by d^2 / threshold instead; the fixed weights of WeightedFusion ignore
+    // covariances, so there it rejects as well.
+    double gate_chi_square = 0.0;
+    bool gate_downweight = false;
+
+    // A fused pose / twist is marked changed only when a position or quaternion component
+    // [m, -] / a twist component [m/s, rad/s] moved more than this since the last changed
+    // one (0: every fusion is a change). Covariances are not compared.
+    double change_epsilon = 0.0;
+};
+
+struct PoseUpdate
+{
+    bool fused = false;         // fusedPose() holds a new pose at stamp_ns
+    bool fallback = false;      // covariance not positive definite, weighted fusion used
+    bool ekf_rejected = false;  // EKF innovation covariance singular, measurement skipped
+    bool ekf_late = false;      // EKF older than the filter state by more than sync_window, dropped
+    bool gated = false;         // outside the chi-square gate, measurement dropped
+    bool downweighted = false;  // outside the chi-square gate, covariance inflated
+    bool changed = false;       // fused, and moved more than change_epsilon: worth publishing
+    int64_t stamp_ns = 0;
+};
+
+struct TwistUpdate
+{
+    bool fused = false;         // fusedTwist() holds a new twist at stamp_ns
+    bool fallback = false;
+    bool changed = false;       // fused, and moved more than change_epsilon
+    int64_t stamp_ns = 0;
+};
+
+struct OutputResult
+{
+    OutputSchedule::Tick tick;
+    bool valid = false;  // state and covariance hold the output at tick.stamp_ns
+    bool stale = false;  // due, but no fused pose within output_max_extrapolation
+    int64_t age_ns = 0;  // tick stamp - stamp of the fused pose it was extrapolated from
+};
+
+// Degraded mode: some inputs timed out and the fusion runs on the others
+struct SourceHealth
+{
+    std::size_t stale_pose_sources = 0;
+    std::size_t stale_twist_sources = 0;
+    bool degraded() const { return stale_pose_sources > 0 || stale_twist_sources > 0; }
+};
+
+// [x, y, z, roll, pitch, yaw] of a pose, the PoseTwistModel state layout
+inline PoseTwistModel::StateVector poseState(const geometry_msgs::msg::Pose &pose)
+{
+    const Eigen::Quaterniond orientation(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+
+    PoseTwistModel::StateVector state;
+    state.head<3>() << pose.position.x, pose.position.y, pose.position.z;
+    state.tail<3>() = PoseTwistModel::rollPitchYaw(orientation.normalized());
+    return state;
+}
+
+inline void statePose(const PoseTwistModel::StateVector &state, geometry_msgs::msg::Pose &pose)
+{
+    pose.position.x = state(0);
+    pose.position.y = state(1);
+    pose.position.z = state(2);
+
+    const Eigen::Quaterniond q = PoseTwistModel::quaternion(state);
+    pose.orientation.x = q.x();
+    pose.orientation.y = q.y();
+    pose.orientation.z = q.z();
+    pose.orientation.w = q.w();
+}
+
+// map -> odom of the batch TF output: map -> base_link * (odom -> base_link)^-1
+inline Eigen::Isometry3d mapToOdom(const geometry_msgs::msg::Pose &pose, const PoseTwistModel::StateVector &odom_state)
+{
+    Eigen::Isometry3d map_to_base = Eigen::Isometry3d::Identity();
+    map_to_base.translation() << pose.position.x, pose.position.y, pose.position.z;
+    map_to_base.linear() = Eigen::Quaterniond(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z)
+                               .normalized().toRotationMatrix();
+
+    Eigen::Isometry3d odom_to_base = Eigen::Isometry3d::Identity();
+    odom_to_base.translation() = odom_state.head<3>();
+    odom_to_base.linear() = PoseTwistModel::rotation(odom_state(3), odom_state(4), odom_state(5));
+
+    return map_to_base * odom_to_base.inverse();
+}
+
+// Fusion state of PoseFusionNode without the node: per-source sample buffers, fusion kernels, EKF,
+// output grid with extrapolation and odom dead reckoning. Time is passed in as nanoseconds,
+// so the same engine runs on the node clock or on bag stamps (localization_tools replay).
+// Nothing is logged; the results tell the caller what happened.
+//
+// Threading: the pose side (add*Pose, output, advanceOdometry) and the twist side
+// (add*Twist) may run on two threads; the only shared state is the fused twist, which
+// is handed over through a SeqLock. Each side on its own is not thread-safe. Receipt
+// times of both sides go to one SourceWatchdog, which the pose side checks (addPose,
+// output, checkSources); its stale flags are atomics.
+//
+// Strategy (WeightedFusion, InformationFusion, EkfFusion) and the twist input type
+// (TwistSample, or PlainTwistSample for topics without covariance) are template
+// parameters, so each configuration compiles to its own kernels without runtime mode
+// checks on the message path.
+template <typename Strategy, typename TwistT = TwistSample>
+class PoseFusionEngine
+{
+public:
+    using StrategyType = Strategy;
+    using TwistInput = TwistT;
+    using StateVector = PoseTwistModel::StateVector;
+    using StateMatrix = PoseTwistModel::StateMatrix;
+
+    explicit PoseFusionEngine(const PoseFusionConfig &config = PoseFusionConfig())
+    {
+        configure(config);
+    }
+
+    void configure(const PoseFusionConfig &config)
+    {
+        config_ = config;
+        if (Strategy::kEkf && config_.output_period_ns <= 0)
+        {
+            config_.output_period_ns = 10000000;
+        }
+
+        pose_settings_.sync_window_ns = config_.sync_window_ns;
+        pose_settings_.interpolate = config_.interpolate;
+        pose_settings_.min_sources = config_.min_pose_sources;
+        twist_settings_ = pose_settings_;
+        twist_settings_.min_sources = config_.min_twist_sources;
+
+        // One slot per source, allocated here so that buffering a message never allocates
+        pose_sources_.assign(config_.pose_source_weights.size(), PoseSource());
+        for (std::size_t i = 0; i < pose_sources_.size(); ++i)
+        {
+            pose_sources_[i].weight = std::max(config_.pose_source_weights[i], 0.0);
+        }
+        pose_gates_.assign(pose_sources_.size(), PoseGate());
+        pose_changed_once_ = false;
+        twist_changed_once_ = false;
+        twist_sources_.assign(config_.twist_source_weights.size(), TwistSource());
+        for (std::size_t i = 0; i < twist_sources_.size(); ++i)
+        {
+            twist_sources_[i].weight = std::max(config_.twist_source_weights[i], 0.0);
+        }
+
+        // One watchdog for all inputs: pose sources first, then twist sources
+        std::vector<int64_t> timeouts_ns(pose_sources_.size() + twist_sources_.size(), 0);
+        for (std::size_t i = 0; i < pose_sources_.size() && i < config_.pose_source_timeouts_ns.size(); ++i)
+        {
+            timeouts_ns[i] = config_.pose_source_timeouts_ns[i];
+        }
+        for (std::size_t i = 0; i < twist_sources_.size() && i < config_.twist_source_timeouts_ns.size(); ++i)
+        {
+            timeouts_ns[pose_sources_.size() + i] = config_.twist_source_timeouts_ns[i];
+        }
+        watchdog_.configure(timeouts_ns);
+
+        if (scheduledOutput())
+        {
+            output_schedule_.configure(config_.output_period_ns, config_.output_deadline_ns);
+        }
+    }
+
+    const PoseFusionConfig &config() const { return config_; }
+    bool scheduledOutput() const { return config_.output_period_ns > 0; }
+    static constexpr bool usesEkf() { return Strategy::kEkf; }
+    std::size_t poseSourceCount() const { return pose_sources_.size(); }
+    std::size_t twistSourceCount() const { return twist_sources_.size(); }
+
+    // Receipt timeouts; pose source i is watchdog source i, twist source i is
+    // poseSourceCount() + i. May be read from any thread.
+    const SourceWatchdog &watchdog() const { return watchdog_; }
+    SourceHealth health() const
+    {
+        SourceHealth health;
+        for (std::size_t i = 0; i < watchdog_.size(); ++i)
+        {
+            if (watchdog_.stale(i))
+            {
+                ++(i < pose_sources_.size() ? health.stale_pose_sources : health.stale_twist_sources);
+            }
+        }
+        return health;
+    }
+
+    // Pose side: runs the receipt timeouts due at now_ns. addPose and output() call it, the
+    // caller only needs to when neither runs regularly (unscheduled output).
+    void checkSources(int64_t now_ns)
+    {
+        watchdog_.check(now_ns, [this](std::size_t i, bool stale)
+        {
+            if (i < pose_sources_.size())
+            {
+                pose_sources_[i].enabled = !stale;
+                pose_gates_[i].gated = false;
+            }
+        });
+    }
+
+    // Runtime reconfiguration of the fixed weights, one per source (missing ones keep
+    // theirs), each from its own side; config() keeps the configured weights
+    void setPoseSourceWeights(const std::vector<double> &weights)
+    {
+        for (std::size_t i = 0; i < pose_sources_.size() && i < weights.size(); ++i)
+        {
+            pose_sources_[i].weight = std::max(weights[i], 0.0);
+        }
+    }
+    void setTwistSourceWeights(const std::vector<double> &weights)
+    {
+        for (std::size_t i = 0; i < twist_sources_.size() && i < weights.size(); ++i)
+        {
+            twist_sources_[i].weight = std::max(weights[i], 0.0);
+        }
+    }
+
+    // Pose side. source < poseSourceCount() is the slot of the sending source; now_ns is
+    // the current time, used for the source timeouts.
+    PoseUpdate addPose(std::size_t source, int64_t stamp_ns, const PoseSample &pose, int64_t now_ns)
+    {
+        PoseUpdate update;
+        watchdog_.receive(source, now_ns);
+        checkSources(now_ns);
+
+        // EKF: the state is at the stamp of the newest measurement, so bring it to this one
+        // before gating and updating. A measurement older than the state (another source with
+        // more latency) is applied to it within sync_window and dropped beyond.
+        if constexpr (Strategy::kEkf)
+        {
+            if (ekf_.initialized() && !restored_)
+            {
+                if (stamp_ns < last_predict_ns_ - config_.sync_window_ns)
+                {
+                    update.ekf_late = true;
+                    return update;
+                }
+                ekfPredict(stamp_ns);
+            }
+        }
+
+        // Outlier gate against the current estimate; a downweighted pose continues as a
+        // copy with the inflated covariance
+        const PoseSample *measurement = &pose;
+        PoseSample inflated;
+        if (config_.gate_chi_square > 0.0)
+        {
+            PoseGate &gate = pose_gates_[source];
+            double distance_squared;
+            gate.gated = false;
+            if (gateDistance(stamp_ns, pose, distance_squared) && distance_squared > config_.gate_chi_square)
+            {
+                if (!Strategy::kInformation || !config_.gate_downweight)
+                {
+                    gate.gated = true;
+                    update.gated = true;
+                    return update;
+                }
+                inflated = pose;
+                covarianceMap(inflated.covariance) *= distance_squared / config_.gate_chi_square;
+                measurement = &inflated;
+                update.downweighted = true;
+            }
+        }
+
+        if constexpr (Strategy::kEkf)
+        {
+            // Every source updates the filter on its own
+            update.ekf_rejected = !ekfUpdate(*measurement, stamp_ns);
+            return update;
+        }
+        else
+        {
+            if (!pose_sources_[source].buffer.push(stamp_ns, *measurement))
+            {
+                return update;
+            }
+
+            FusionSettings settings = pose_settings_;
+            settings.min_sources = requiredSources(settings.min_sources, pose_sources_, pose_gates_.data());
+
+            int64_t fusion_stamp_ns;
+            if (!fusionStamp(pose_sources_, pose_gates_.data(), stamp_ns, settings.min_sources, fusion_stamp_ns) ||
+                (!restored_ && fusion_stamp_ns <= last_fused_pose_stamp_ns_))
+            {
+                return update;
+            }
+
+            const FusionResult result = fusePoseSources<Strategy>(pose_sources_, fusion_stamp_ns, settings, pose_information_, fused_pose_);
+            if (result == FusionResult::kNoSamples)
+            {
+                return update;
+            }
+            last_fused_pose_stamp_ns_ = fusion_stamp_ns;
+            restored_ = false;
+            ++estimate_revision_;
+            if (config_.gate_chi_square > 0.0)
+            {
+                gate_reference_ = poseState(fused_pose_.pose);
+            }
+            update.fused = true;
+            update.changed = markChanged(poseVector(fused_pose_.pose), changed_pose_, pose_changed_once_);
+            update.fallback = result == FusionResult::kWeightedFallback;
+            update.stamp_ns = fusion_stamp_ns;
+            return update;
+        }
+    }
+
+    // Latest fused pose (strategies other than EkfFusion), valid after a PoseUpdate with fused set
+    const PoseSample &fusedPose() const { return fused_pose_; }
+
+    // Warm start from a persisted estimate, before any input. The pose is the estimate at
+    // now_ns and is output, held without extrapolation and without the
+    // output_max_extrapolation limit, until the first real fusion or EKF measurement
+    // replaces it outright; it is never gated against.
+    void restore(const PoseSample &pose, int64_t now_ns)
+    {
+        if constexpr (Strategy::kEkf)
+        {
+            ekf_.initialize(poseState(pose.pose), covarianceMap(pose.covariance));
+            last_predict_ns_ = now_ns;
+        }
+        else
+        {
+            fused_pose_ = pose;
+            last_fused_pose_stamp_ns_ = now_ns;
+        }
+        restored_ = true;
+        ++estimate_revision_;
+    }
+
+    // True while the estimate is the restored one
+    bool restored() const { return restored_; }
+    // Bumped whenever the estimate changes
+    uint64_t estimateRevision() const { return estimate_revision_; }
+
+    // Pose side: current estimate (EKF state or latest fused pose); false before the first one
+    bool estimate(PoseSample &pose) const
+    {
+        if constexpr (Strategy::kEkf)
+        {
+            if (!ekf_.initialized())
+            {
+                return false;
+            }
+            statePose(ekf_.state(), pose.pose);
+            covarianceMap(pose.covariance) = ekf_.covariance();
+        }
+        else
+        {
+            if (last_fused_pose_stamp_ns_ == std::numeric_limits<int64_t>::min())
+            {
+                return false;
+            }
+            pose = fused_pose_;
+        }
+        return true;
+    }
+
+    // Fixed-rate output at the grid time due at now_ns: the EKF state predicted to the grid
+    // time (the filter itself stays at its last measurement), or the latest fused pose
+    // extrapolated with the fused twist
+    OutputResult output(int64_t now_ns, StateVector &state, StateMatrix &covariance)
+    {
+        OutputResult result;
+        checkSources(now_ns);
+        result.tick = output_schedule_.next(now_ns);
+        if (!result.tick.due)
+        {
+            return result;
+        }
+
+        if constexpr (Strategy::kEkf)
+        {
+            if (!ekf_.initialized())
+            {
+                return result;
+            }
+            state = ekf_.state();
+            covariance = ekf_.covariance();
+            // A restored state is held as it is, as the fused strategies hold a restored pose
+            StateVector predicted;
+            StateMatrix jacobian;
+            StateMatrix process_noise;
+            if (!restored_ && ekfPrediction(result.tick.stamp_ns, predicted, jacobian, process_noise))
+            {
+                state = predicted;
+                covariance = jacobian * covariance * jacobian.transpose() + process_noise;
+            }
+            result.valid = true;
+            return result;
+        }
+        else
+        {
+            if (!extrapolateFusedPose(result.tick.stamp_ns, state, covariance))
+            {
+                result.stale = true;
+                return result;
+            }
+            result.valid = true;
+            result.age_ns = result.tick.stamp_ns - last_fused_pose_stamp_ns_;
+            return result;
+        }
+    }
+
+    // Dead-reckons the odom -> base_link state with the fused twist up to stamp_ns. The
+    // result is smooth and continuous; corrections of the fused pose only move map -> odom.
+    const StateVector &advanceOdometry(int64_t stamp_ns)
+    {
+        // The odom frame starts at the first output and again after the clock jumped back by
+        // more than a second (replay restart); smaller backward steps leave it where it is
+        if (last_odom_stamp_ns_ == std::numeric_limits<int64_t>::min() || stamp_ns < last_odom_stamp_ns_ - 1000000000)
+        {
+            odom_state_.setZero();
+            last_odom_stamp_ns_ = stamp_ns;
+            return odom_state_;
+        }
+        const double dt = static_cast<double>(stamp_ns - last_odom_stamp_ns_) * 1e-9;
+        if (dt <= 0.0)
+        {
+            return odom_state_;
+        }
+        last_odom_stamp_ns_ = stamp_ns;
+
+        const TwistEstimate twist_estimate = controlTwist();
+        const Eigen::Map<const Vector6d> twist(twist_estimate.twist.data());
+        StateMatrix jacobian;
+        odom_state_ = PoseTwistModel::predict(odom_state_, twist, dt, jacobian);
+        return odom_state_;
+    }
+
+    // Twist side, source < twistSourceCount(); now_ns is the receipt time for the watchdog
+    TwistUpdate addTwist(std::size_t source, int64_t stamp_ns, const TwistT &twist, int64_t now_ns)
+    {
+        TwistUpdate update;
+        watchdog_.receive(pose_sources_.size() + source, now_ns);
+        if (!twist_sources_[source].buffer.push(stamp_ns, twist))
+        {
+            return update;
+        }
+
+        // Stale flags are set by the pose side
+        for (std::size_t i = 0; i < twist_sources_.size(); ++i)
+        {
+            twist_sources_[i].enabled = !watchdog_.stale(pose_sources_.size() + i);
+        }
+        FusionSettings settings = twist_settings_;
+        settings.min_sources = requiredSources(settings.min_sources, twist_sources_, static_cast<const PoseGate *>(nullptr));
+
+        int64_t fusion_stamp_ns;
+        if (!fusionStamp(twist_sources_, static_cast<const PoseGate *>(nullptr), stamp_ns, settings.min_sources, fusion_stamp_ns) ||
+            fusion_stamp_ns <= last_fused_twist_stamp_ns_)
+        {
+            return update;
+        }
+
+        const FusionResult result = fuseTwistSources<Strategy>(twist_sources_, fusion_stamp_ns, settings, twist_information_, fused_twist_);
+        if (result == FusionResult::kNoSamples)
+        {
+            return update;
+        }
+        last_fused_twist_stamp_ns_ = fusion_stamp_ns;
+
+        // The fused twist is the EKF control input, extrapolates the scheduled output and
+        // dead-reckons the odom frame
+        TwistEstimate estimate;
+        Eigen::Map<Vector6d>(estimate.twist.data()) = toVector(fused_twist_);
+        estimate.covariance = fused_twist_.covariance;
+        fused_twist_estimate_.store(estimate);
+
+        update.fused = true;
+        update.fallback = result == FusionResult::kWeightedFallback;
+        update.changed = markChanged(toVector(fused_twist_), changed_twist_, twist_changed_once_);
+        update.stamp_ns = fusion_stamp_ns;
+        return update;
+    }
+
+    // Latest fused twist, valid after a TwistUpdate with fused set (twist side only). Fused
+    // plain twists carry an all-zero ("unknown") covariance.
+    const TwistSample &fusedTwist() const { return fused_twist_; }
+
+
+private:
+    // Per-sensor history, pre-allocated so that buffering a message never allocates
+    static constexpr std::size_t kSampleBufferCapacity = 64;
+    using PoseSource = FusionSource<PoseSample, kSampleBufferCapacity>;
+    using TwistSource = FusionSource<TwistT, kSampleBufferCapacity>;
+
+    // Per pose source: whether its latest pose was gated
+    struct PoseGate
+    {
+        bool gated = false;
+    };
+
+    // Latest fused twist (EKF control input, output extrapolation and odometry), written by
+    // the twist side and read by the pose side.
+    // Trivially copyable so it can be shared through a SeqLock without locking.
+    struct TwistEstimate
+    {
+        std::array<double, 6> twist;
+        std::array<double, 36> covariance;
+    };
+
+    // Sources a fusion waits for: min_sources (0: all), at most the sources that are
+    // neither stale nor had their latest pose gated (gates, one per source, or null), so
+    // a dead or outlying source cannot stall the others; at least one
+    template <typename Sources>
+    static std::size_t requiredSources(std::size_t min_sources, const Sources &sources, const PoseGate *gates)
+    {
+        std::size_t usable = 0;
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            usable += sources[i].enabled && !(gates && gates[i].gated) ? 1 : 0;
+        }
+        const std::size_t required = min_sources > 0 ? std::min(min_sources, sources.size()) : sources.size();
+        return std::max<std::size_t>(std::min(required, usable), 1);
+    }
+
+    // Interpolation needs samples on both sides, so fuse at the oldest of the newest
+    // stamps of the live sources (newest sample inside the sync window of the trigger);
+    // the other live sources then bracket it. Nearest mode fuses at the new message.
+    // Stale sources and those whose latest pose was gated are not live. False when fewer
+    // sources than required are live.
+    template <typename Sources>
+    bool fusionStamp(const Sources &sources, const PoseGate *gates, int64_t trigger_stamp_ns, std::size_t min_sources,
+                     int64_t &fusion_stamp_ns) const
+    {
+        std::size_t live = 0;
+        int64_t oldest_newest_ns = trigger_stamp_ns;
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            const auto &source = sources[i];
+            if (!source.enabled || source.buffer.empty() ||
+                source.buffer.newest().stamp_ns < trigger_stamp_ns - config_.sync_window_ns || (gates && gates[i].gated))
+            {
+                continue;
+            }
+            ++live;
+            oldest_newest_ns = std::min(oldest_newest_ns, source.buffer.newest().stamp_ns);
+        }
+
+        fusion_stamp_ns = config_.interpolate ? oldest_newest_ns : trigger_stamp_ns;
+        const std::size_t required = min_sources > 0 ? std::min(min_sources, sources.size()) : sources.size();
+        return live >= required;
+    }
+
+    // Position and quaternion components of a pose, compared by markChanged
+    static Eigen::Matrix<double, 7, 1> poseVector(const geometry_msgs::msg::Pose &pose)
+    {
+        Eigen::Matrix<double, 7, 1> v;
+        v << pose.position.x, pose.position.y, pose.position.z, pose.orientation.x, pose.orientation.y, pose.orientation.z,
+            pose.orientation.w;
+        return v;
+    }
+
+    // Dirty flag of the output: true when value moved more than change_epsilon in any
+    // component since the last value that was marked changed (which becomes the new
+    // reference), so slow drift is still reported once it adds up
+    template <int Dim>
+    bool markChanged(const Eigen::Matrix<double, Dim, 1> &value, Eigen::Matrix<double, Dim, 1> &reference, bool &has_reference) const
+    {
+        if (config_.change_epsilon > 0.0 && has_reference && ((value - reference).cwiseAbs().array() <= config_.change_epsilon).all())
+        {
+            return false;
+        }
+        reference = value;
+        has_reference = true;
+        return true;
+    }
+
+    // Squared Mahalanobis distance of a pose to the EKF state or to the latest fused pose.
+    // False when there is no estimate to gate against: no EKF state yet, a restored
+    // estimate, or the fused pose is older than output_max_extrapolation (so a consistent
+    // jump of every source is eventually accepted).
+    bool gateDistance(int64_t stamp_ns, const PoseSample &pose, double &distance_squared) const
+    {
+        if (restored_)
+        {
+            return false;
+        }
+        const StateVector z = poseState(pose.pose);
+        if constexpr (Strategy::kEkf)
+        {
+            // addPose predicted the state to stamp_ns
+            if (!ekf_.initialized())
+            {
+                return false;
+            }
+            return mahalanobisDistanceSquared(PoseTwistModel::poseInnovation(z, ekf_.state()), ekf_.covariance(), pose.covariance,
+                                              distance_squared);
+        }
+        else
+        {
+            if (last_fused_pose_stamp_ns_ == std::numeric_limits<int64_t>::min() ||
+                std::abs(stamp_ns - last_fused_pose_stamp_ns_) > config_.output_max_extrapolation_ns)
+            {
+                return false;
+            }
+            return mahalanobisDistanceSquared(PoseTwistModel::poseInnovation(z, gate_reference_), covarianceMap(fused_pose_.covariance),
+                                              pose.covariance, distance_squared);
+        }
+    }
+
+    // EKF mode: measurements update the filter at their stamp, output() predicts a copy to
+    // the grid time. False when the measurement was skipped.
+    bool ekfUpdate(const PoseSample &measurement, int64_t stamp_ns)
+    {
+        const StateVector z = poseState(measurement.pose);
+        const StateMatrix noise = covarianceMap(measurement.covariance);
+
+        // A restored state only bridges the start; the first measurement replaces it
+        if (!ekf_.initialized() || restored_)
+        {
+            ekf_.initialize(z, noise);
+            last_predict_ns_ = stamp_ns;
+            restored_ = false;
+            ++estimate_revision_;
+            return true;
+        }
+
+        if (!ekf_.update<6>(PoseTwistModel::poseInnovation(z, ekf_.state()), StateMatrix::Identity(), noise))
+        {
+            return false;
+        }
+        PoseTwistModel::normalize(ekf_.state());
+        ++estimate_revision_;
+        return true;
+    }
+
+    // Advances the filter to stamp_ns; a stamp that is not after the state leaves it as is
+    void ekfPredict(int64_t stamp_ns)
+    {
+        StateVector predicted;
+        StateMatrix jacobian;
+        StateMatrix process_noise;
+        if (!ekfPrediction(stamp_ns, predicted, jacobian, process_noise))
+        {
+            return;
+        }
+        last_predict_ns_ = stamp_ns;
+        ekf_.predict(predicted, jacobian, process_noise);
+        ++estimate_revision_;
+    }
+
+    // One prediction step of the filter state from last_predict_ns_ to stamp_ns; false when
+    // stamp_ns is not after it
+    bool ekfPrediction(int64_t stamp_ns, StateVector &predicted, StateMatrix &jacobian, StateMatrix &process_noise) const
+    {
+        const double dt = static_cast<double>(stamp_ns - last_predict_ns_) * 1e-9;
+        if (dt <= 0.0)
+        {
+            return false;
+        }
+
+        // Control input published by the twist side
+        const TwistEstimate control = controlTwist();
+        const Eigen::Map<const Vector6d> twist(control.twist.data());
+        predicted = PoseTwistModel::predict(ekf_.state(), twist, dt, jacobian);
+
+        // Process noise: twist uncertainty propagated over dt plus a random-walk floor
+        const StateMatrix control_jacobian = PoseTwistModel::controlJacobian(ekf_.state(), dt);
+        process_noise = control_jacobian * covarianceMap(control.covariance) * control_jacobian.transpose();
+        process_noise.diagonal().head<3>().array() += config_.ekf_process_noise_position * dt;
+        process_noise.diagonal().tail<3>().array() += config_.ekf_process_noise_orientation * dt;
+        return true;
+    }
+
+    // Fused twist for prediction; once every twist source is stale it is no longer
+    // current, so the pose is held (zero twist) instead of extrapolated with it
+    TwistEstimate controlTwist() const
+    {
+        TwistEstimate estimate = fused_twist_estimate_.load();
+        bool live = twist_sources_.empty();
+        for (std::size_t i = 0; i < twist_sources_.size(); ++i)
+        {
+            live = live || !watchdog_.stale(pose_sources_.size() + i);
+        }
+        if (!live)
+        {
+            estimate.twist.fill(0.0);
+        }
+        return estimate;
+    }
+
+    bool extrapolateFusedPose(int64_t stamp_ns, StateVector &state, StateMatrix &covariance) const
+    {
+        if (restored_)
+        {
+            state = poseState(fused_pose_.pose);
+            covariance = covarianceMap(fused_pose_.covariance);
+            return true;
+        }
+        if (last_fused_pose_stamp_ns_ == std::numeric_limits<int64_t>::min() ||
+            std::abs(stamp_ns - last_fused_pose_stamp_ns_) > config_.output_max_extrapolation_ns)
+        {
+            return false;
+        }
+
+        state = poseState(fused_pose_.pose);
+        covariance = covarianceMap(fused_pose_.covariance);
+        const double dt = static_cast<double>(stamp_ns - last_fused_pose_stamp_ns_) * 1e-9;
+        if (!config_.output_extrapolate || dt == 0.0)
+        {
+            return true;
+        }
+
+        // One constant-twist prediction step from the fusion stamp to the grid time; the
+        // twist covariance grows the pose covariance by G Q G^T
+        const TwistEstimate twist_estimate = controlTwist();
+        const Eigen::Map<const Vector6d> twist(twist_estimate.twist.data());
+        StateMatrix jacobian;
+        const StateVector predicted = PoseTwistModel::predict(state, twist, dt, jacobian);
+        const StateMatrix control_jacobian = PoseTwistModel::controlJacobian(state, dt);
+        covariance = jacobian * covariance * jacobian.transpose() +
+                     control_jacobian * covarianceMap(twist_estimate.covariance) * control_jacobian.transpose();
+        state = predicted;
+        return true;
+    }
+
+    PoseFusionConfig config_;
+    // Config above as passed to the fusion kernels
+    FusionSettings pose_settings_;
+    FusionSettings twist_settings_;
+
+    // Pose side
+    std::vector<PoseSource> pose_sources_;
+    std::vector<PoseGate> pose_gates_;
+    // Bumped whenever the pose estimate (fused pose or EKF state) changes
+    uint64_t estimate_revision_ = 0;
+    bool restored_ = false;  // the estimate is the one passed to restore()
+    Eigen::Matrix<double, 7, 1> changed_pose_ = Eigen::Matrix<double, 7, 1>::Zero();  // last pose marked changed
+    bool pose_changed_once_ = false;
+    StateVector gate_reference_ = StateVector::Zero();  // fused pose as a state, for gating
+    InformationAccumulator pose_information_;
+    PoseSample fused_pose_;
+    int64_t last_fused_pose_stamp_ns_ = std::numeric_limits<int64_t>::min();
+    OutputSchedule output_schedule_;
+    ExtendedKalmanFilter<PoseTwistModel::kStateDim> ekf_;
+    int64_t last_predict_ns_ = 0;  // stamp of the EKF state
+    StateVector odom_state_ = StateVector::Zero();
+    int64_t last_odom_stamp_ns_ = std::numeric_limits<int64_t>::min();
+
+    // Twist side
+    std::vector<TwistSource> twist_sources_;
+    Vector6d changed_twist_ = Vector6d::Zero();  // last twist marked changed
+    bool twist_changed_once_ = false;
+    InformationAccumulator twist_information_;
+    TwistSample fused_twist_;
+    int64_t last_fused_twist_stamp_ns_ = std::numeric_limits<int64_t>::min();
+
+    // Shared
+    SeqLock<TwistEstimate> fused_twist_estimate_;
+    SourceWatchdog watchdog_;
+};
+
+#endif  // POSE_FUSION__POSE_FUSION_ENGINE_HPP_
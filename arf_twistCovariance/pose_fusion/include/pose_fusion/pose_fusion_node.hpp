@@ -0,0 +1,283 @@
+#ifndef POSE_FUSION__POSE_FUSION_NODE_HPP_
+#define POSE_FUSION__POSE_FUSION_NODE_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_lifecycle/lifecycle_node.hpp>
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
+#include <geometry_msgs/msg/twist_stamped.hpp>
+#include <geometry_msgs/msg/twist_with_covariance_stamped.hpp>
+#include <tf2_msgs/msg/tf_message.hpp>
+
+#include "pose_fusion/fusion_thread.hpp"
+#include "pose_fusion/pose_fusion_engine.hpp"
+#include "pose_fusion/spsc_queue.hpp"
+
+#include <localization_common/allocation_guard.hpp>
+#include <localization_common/config_buffer.hpp>
+#include <localization_common/latency_monitor.hpp>
+#include <localization_common/lifecycle.hpp>
+#include <localization_common/message_publisher.hpp>
+#include <localization_common/qos_profiles.hpp>
+#include <localization_common/state_file.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+// Stamped message carrying each twist input type of PoseFusionEngine
+template <typename TwistT>
+struct StampedTwist;
+
+template <>
+struct StampedTwist<TwistSample>
+{
+    using Message = geometry_msgs::msg::TwistWithCovarianceStamped;
+};
+
+template <>
+struct StampedTwist<PlainTwistSample>
+{
+    using Message = geometry_msgs::msg::TwistStamped;
+};
+
+// Message handle handed from a subscription callback to the fusion thread
+template <typename MessageT>
+struct QueuedMessage
+{
+    typename MessageT::ConstSharedPtr message;
+    int64_t receipt_ns = 0;  // node clock when the callback ran
+};
+
+// One queue per source; its subscription is the only producer, the fusion thread the consumer
+template <typename TwistMessageT>
+struct FusionInbox
+{
+    std::deque<SpscQueue<QueuedMessage<geometry_msgs::msg::PoseWithCovarianceStamped>>> pose;
+    std::deque<SpscQueue<QueuedMessage<TwistMessageT>>> twist;
+};
+
+// Lifecycle node: on_configure reads the parameters, emplaces the engine with its buffers and
+// creates publishers, subscriptions, timers and the fusion thread; the callbacks only fuse
+// while active, and the engine work of the active state does not allocate (AllocationGuard).
+// With autostart (default) the constructor runs configure and activate itself.
+class PoseFusionNode : public rclcpp_lifecycle::LifecycleNode
+{
+public:
+    explicit PoseFusionNode(const rclcpp::NodeOptions &options = rclcpp::NodeOptions());
+    // Writes the latest estimate to the state file
+    ~PoseFusionNode() override;
+
+    LifecycleCallbackReturn on_configure(const rclcpp_lifecycle::State &state) override;
+    LifecycleCallbackReturn on_activate(const rclcpp_lifecycle::State &state) override;
+    LifecycleCallbackReturn on_deactivate(const rclcpp_lifecycle::State &state) override;
+    LifecycleCallbackReturn on_cleanup(const rclcpp_lifecycle::State &state) override;
+    LifecycleCallbackReturn on_shutdown(const rclcpp_lifecycle::State &state) override;
+
+private:
+    using StateVector = PoseTwistModel::StateVector;
+    using StateMatrix = PoseTwistModel::StateMatrix;
+
+    // Every (fusion_mode, twist_input_type) combination; one is emplaced on configure
+    using FusionEngine = std::variant<std::monostate,
+                                      PoseFusionEngine<InformationFusion>,
+                                      PoseFusionEngine<WeightedFusion>,
+                                      PoseFusionEngine<EkfFusion>,
+                                      PoseFusionEngine<InformationFusion, PlainTwistSample>,
+                                      PoseFusionEngine<WeightedFusion, PlainTwistSample>,
+                                      PoseFusionEngine<EkfFusion, PlainTwistSample>>;
+
+    // One pose or twist input; the index in pose_sources_ / twist_sources_ is its engine slot
+    struct Source
+    {
+        std::string name;
+        std::string topic;
+        // Owned by latency_monitor_; the gate counters only exist for pose sources, unchanged
+        // (fusions not published, see change_epsilon) only with change_epsilon > 0, dropped
+        // (queue full) only with the fusion thread
+        CallbackStatistics *statistics = nullptr;
+        EventCounter *gated = nullptr;
+        EventCounter *downweighted = nullptr;
+        EventCounter *unchanged = nullptr;
+        EventCounter *dropped = nullptr;
+    };
+
+    // Warm-start record of the state file: the last estimate in map_frame
+    struct PersistedState
+    {
+        int64_t wall_time_ns;            // system clock when written
+        std::array<double, 7> pose;      // x, y, z, qx, qy, qz, qw
+        std::array<double, 36> covariance;
+    };
+    static constexpr uint32_t kStateVersion = 1;
+
+    // Reads the <kind>_sources name list and the sources.<name>.* parameters
+    std::vector<Source> declareSources(const std::string &kind, const std::vector<std::string> &default_names,
+                                       const std::vector<std::string> &default_topics, double default_timeout,
+                                       std::vector<double> &weights, std::vector<int64_t> &timeouts_ns);
+
+    // Validates runtime changes of sources.<name>.weight and hands each side its new set as a
+    // whole; every other parameter is only read on configure
+    rcl_interfaces::msg::SetParametersResult onSetParameters(const std::vector<rclcpp::Parameter> &parameters);
+
+    template <typename Strategy>
+    void startStrategy(bool plain_twist, const PoseFusionConfig &config, const rclcpp::Duration &output_period);
+
+    // Emplaces the engine and binds the subscriptions and the output timer to its
+    // instantiation, so no callback looks the engine type up again
+    template <typename EngineT>
+    void start(const PoseFusionConfig &config, const rclcpp::Duration &output_period);
+
+    // Each subscription is bound to its engine slot and source
+    template <typename EngineT>
+    void poseCallback(EngineT &engine, std::size_t slot, const Source &source,
+                      const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr pose_msg);
+    template <typename EngineT>
+    void twistCallback(EngineT &engine, std::size_t slot, const Source &source,
+                       const typename StampedTwist<typename EngineT::TwistInput>::Message::ConstSharedPtr twist_msg);
+    // Engine work of one message, in the callback or on the fusion thread
+    template <typename EngineT>
+    void processPose(EngineT &engine, std::size_t slot, const Source &source,
+                     const geometry_msgs::msg::PoseWithCovarianceStamped &pose_msg, int64_t receipt_ns);
+    template <typename EngineT>
+    void processTwist(EngineT &engine, std::size_t slot, const Source &source,
+                      const typename StampedTwist<typename EngineT::TwistInput>::Message &twist_msg, int64_t receipt_ns);
+
+    // Fusion thread (fusion_thread.enabled): the subscriptions only queue the message
+    // handle, the timers only post a request, and runFusionThread does the engine work
+    template <typename MessageT>
+    void queueMessage(SpscQueue<QueuedMessage<MessageT>> &queue, const Source &source, const typename MessageT::ConstSharedPtr message);
+    void requestFusion(uint32_t request);
+    template <typename EngineT, typename InboxT>
+    void runFusionThread(EngineT &engine, InboxT &inbox);
+    void stopFusionThread();
+
+    // Logs what the engine reported and, with unscheduled output, publishes the fused
+    // pose if it changed; the output age is accounted to the triggering source
+    template <typename EngineT>
+    void handlePoseUpdate(EngineT &engine, const PoseUpdate &update, const Source &trigger);
+    template <typename EngineT>
+    void handleTwistUpdate(EngineT &engine, const TwistUpdate &update, const Source &trigger);
+
+    // Stops the fusion thread, writes the state and drops everything on_configure created
+    void release();
+    // Output, watchdog and state timers run only while active
+    void setTimersRunning(bool running);
+
+    // Fixed-rate output: publishes the EKF state or the latest fused pose extrapolated
+    // with the fused twist at the grid times of the engine's output schedule
+    template <typename EngineT>
+    void publishOutput(EngineT &engine);
+    template <typename EngineT>
+    void publishPoseState(EngineT &engine, int64_t stamp_ns, const StateVector &state, const StateMatrix &covariance);
+
+    // Seeds the engine from the state file if it holds a recent enough estimate and, with
+    // unscheduled output, publishes it once; the output timer publishes it otherwise
+    template <typename EngineT>
+    void restoreState(EngineT &engine);
+    // Stores the estimate if it changed since the last write and is not the restored one
+    template <typename EngineT>
+    void writeState(EngineT &engine);
+
+    // Degraded-mode status of the inputs on /diagnostics (reporter thread): WARN while some
+    // sources are stale and the fusion runs on the others, ERROR while every pose source is
+    // stale. Logs each timeout and recovery.
+    template <typename EngineT>
+    void reportSources(const EngineT &engine, diagnostic_msgs::msg::DiagnosticStatus &status);
+
+    // map -> base_link (tf_mode "single"), map -> odom and odom -> base_link in one message
+    // ("batch") or nothing ("none")
+    template <typename EngineT>
+    void broadcastTransform(EngineT &engine, const geometry_msgs::msg::PoseWithCovarianceStamped &fused_pose);
+
+    // Set by on_activate, cleared by on_deactivate; the subscriptions drop messages without it
+    std::atomic<bool> active_{false};
+
+    // Pose path (pose sources, output timer) and twist path run in separate mutually exclusive
+    // groups, so a multi-threaded executor keeps the twist output going under pose load
+    rclcpp::CallbackGroup::SharedPtr pose_callback_group_;
+    rclcpp::CallbackGroup::SharedPtr twist_callback_group_;
+
+    // Fusion thread: runs both engine sides, so the groups only deserialise and queue.
+    // Declared before the subscriptions, so the queues outlive their producers.
+    enum FusionRequest : uint32_t
+    {
+        kOutputDue = 1u << 0,
+        kCheckSources = 1u << 1,
+        kWriteState = 1u << 2
+    };
+    bool fusion_thread_enabled_ = false;
+    std::size_t fusion_queue_depth_ = 16;
+    ThreadPolicy fusion_thread_policy_;
+    std::variant<std::monostate, FusionInbox<geometry_msgs::msg::TwistWithCovarianceStamped>, FusionInbox<geometry_msgs::msg::TwistStamped>>
+        fusion_inbox_;
+    ThreadWakeup fusion_wakeup_;
+    std::atomic<uint32_t> fusion_requests_{0};
+    std::atomic<bool> fusion_stop_{false};
+    std::thread fusion_thread_;
+
+    std::vector<Source> pose_sources_;
+    std::vector<Source> twist_sources_;
+
+    // Runtime weights, one per source: the parameter callback publishes complete sets, the
+    // pose and twist sides take the latest one before their next message. requested_* is
+    // the parameter callback's copy of the last published set.
+    ConfigBuffer<std::vector<double>> pose_weights_;
+    ConfigBuffer<std::vector<double>> twist_weights_;
+    std::vector<double> requested_pose_weights_;
+    std::vector<double> requested_twist_weights_;
+    rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr parameter_callback_;
+    std::vector<rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr> pose_subs_;
+    // TwistWithCovarianceStamped or TwistStamped (twist_input_type)
+    std::vector<rclcpp::SubscriptionBase::SharedPtr> twist_subs_;
+
+    // Publish paths without per-message allocation where the transport allows it.
+    // final_pose_pub_ and tf_pub_ are only used by the pose group, fused_twist_pub_ by the twist group.
+    MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped> final_pose_pub_;
+    MessagePublisher<geometry_msgs::msg::TwistWithCovarianceStamped> fused_twist_pub_;
+    // Transforms on /tf, published directly so the frame ids are set once and the batch
+    // goes out as one TFMessage
+    MessagePublisher<tf2_msgs::msg::TFMessage> tf_pub_;
+
+    enum class TfMode
+    {
+        kSingle,
+        kBatch,
+        kNone
+    };
+    TfMode tf_mode_ = TfMode::kSingle;
+
+    rclcpp::TimerBase::SharedPtr output_timer_;
+    // Runs the source timeouts when there is no output timer to do it
+    rclcpp::TimerBase::SharedPtr watchdog_timer_;
+    // Stale flags last reported, per watchdog source (reporter thread only)
+    std::vector<bool> reported_stale_;
+
+    // Warm start (state_file): restored on configure, written at state_write_period by the
+    // pose group and once more on cleanup or destruction
+    MappedStateFile<PersistedState> state_file_;
+    double state_max_age_ = 0.0;
+    uint64_t written_revision_ = 0;
+    rclcpp::TimerBase::SharedPtr state_timer_;
+    std::function<void()> write_state_;
+
+    // Per-callback timing published on /diagnostics; the pointers are owned by the monitor
+    std::unique_ptr<LatencyMonitor> latency_monitor_;
+    CallbackStatistics *output_statistics_ = nullptr;
+    EventCounter *output_late_ = nullptr;
+    EventCounter *output_skipped_ = nullptr;
+    EventCounter *output_stale_ = nullptr;
+
+    // Buffers, fusion, EKF, output grid and odometry. The pose group runs the pose side,
+    // the twist group the twist side (see PoseFusionEngine), or the fusion thread both.
+    FusionEngine engine_;
+};
+
+#endif  // POSE_FUSION__POSE_FUSION_NODE_HPP_
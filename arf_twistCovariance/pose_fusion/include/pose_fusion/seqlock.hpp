@@ -0,0 +1,52 @@
+#ifndef POSE_FUSION__SEQLOCK_HPP_
+#define POSE_FUSION__SEQLOCK_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer / multi-reader sequence lock for small trivially copyable state.
+// Neither side ever blocks: the writer bumps the sequence to an odd value while it
+// copies, and readers retry if the sequence was odd or changed during their copy.
+// Used to hand state between callback groups running on different executor threads.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    SeqLock() = default;
+    explicit SeqLock(const T &initial) : data_(initial) {}
+
+    // Must only be called from one thread at a time
+    void store(const T &value)
+    {
+        const uint32_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data_, &value, sizeof(T));
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        T value;
+        uint32_t before = 0;
+        uint32_t after = 0;
+        do
+        {
+            before = sequence_.load(std::memory_order_acquire);
+            std::memcpy(&value, &data_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1u) != 0 || before != after);
+        return value;
+    }
+
+private:
+    std::atomic<uint32_t> sequence_{0};
+    T data_{};
+};
+
+#endif  // POSE_FUSION__SEQLOCK_HPP_
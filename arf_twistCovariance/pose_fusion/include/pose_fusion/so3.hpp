@@ -0,0 +1,89 @@
+#ifndef POSE_FUSION__SO3_HPP_
+#define POSE_FUSION__SO3_HPP_
+
+#include <geometry_msgs/msg/quaternion.hpp>
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+
+// Orientation arithmetic of the pose kernels. Rotations are perturbed on the left,
+// q = Exp(delta) * q_ref, with delta a rotation vector about the fixed map axes, which is
+// how ROS reads the rotational block of a pose covariance. Log and Exp switch to their
+// Taylor series below kSmallAngleSquared, where the inputs of one fusion usually are,
+// and need no trigonometry there.
+
+// Squared half-angle tangent (Log) or squared angle (Exp) below which the series are
+// used; their truncation error is below 1e-10 rad there
+constexpr double kSmallAngleSquared = 1e-4;
+
+inline Eigen::Quaterniond toQuaternion(const geometry_msgs::msg::Quaternion &q)
+{
+    return Eigen::Quaterniond(q.w, q.x, q.y, q.z);
+}
+
+inline void setQuaternion(const Eigen::Quaterniond &q, geometry_msgs::msg::Quaternion &out)
+{
+    out.x = q.x();
+    out.y = q.y();
+    out.z = q.z();
+    out.w = q.w();
+}
+
+// Unit quaternion with w >= 0 representing the same rotation, without branches: the
+// sign is folded into the scale. An all-zero input stays all zero (treated as identity
+// by quaternionLog) instead of turning into NaN.
+inline Eigen::Quaterniond normalizedQuaternion(const Eigen::Quaterniond &q)
+{
+    const double scale = std::copysign(1.0 / std::sqrt(std::max(q.coeffs().squaredNorm(), 1e-300)), q.w());
+    return Eigen::Quaterniond(Eigen::Vector4d(q.coeffs() * scale));
+}
+
+// Rotation vector (|result| <= pi, the shorter rotation) of a quaternion of any norm and
+// either sign. Only the ratio of vector part and w matters, so the inputs of a residual
+// need no normalisation.
+inline Eigen::Vector3d quaternionLog(const Eigen::Quaterniond &q)
+{
+    const double vec_squared = q.vec().squaredNorm();
+    const double w_squared = q.w() * q.w();
+    if (vec_squared < kSmallAngleSquared * w_squared)
+    {
+        // With t = v / w = tan(theta/2) n: theta n = 2 atan(|t|) / |t| t = 2 (1 - |t|^2 / 3 + ...) t
+        return (2.0 / q.w() * (1.0 - vec_squared / (3.0 * w_squared))) * q.vec();
+    }
+    // An all-zero quaternion ends up here and yields zero
+    const double vec_norm = std::sqrt(std::max(vec_squared, 1e-300));
+    return (std::copysign(2.0, q.w()) * std::atan2(vec_norm, std::abs(q.w())) / vec_norm) * q.vec();
+}
+
+// Unit quaternion (w >= 0 for |delta| <= pi) of a rotation vector
+inline Eigen::Quaterniond quaternionExp(const Eigen::Vector3d &delta)
+{
+    const double angle_squared = delta.squaredNorm();
+    double cos_half;
+    double sin_half_over_angle;
+    if (angle_squared < kSmallAngleSquared)
+    {
+        cos_half = 1.0 - angle_squared / 8.0;
+        sin_half_over_angle = 0.5 - angle_squared / 48.0;
+    }
+    else
+    {
+        const double angle = std::sqrt(angle_squared);
+        cos_half = std::cos(0.5 * angle);
+        sin_half_over_angle = std::sin(0.5 * angle) / angle;
+    }
+    // Unit to within the series' truncation, no normalisation needed
+    const Eigen::Vector3d vec = sin_half_over_angle * delta;
+    return Eigen::Quaterniond(cos_half, vec.x(), vec.y(), vec.z());
+}
+
+// delta with q = Exp(delta) * reference, the shorter of the two rotations; reference
+// must be a unit quaternion, q may have any norm
+inline Eigen::Vector3d rotationResidual(const Eigen::Quaterniond &q, const Eigen::Quaterniond &reference)
+{
+    return quaternionLog(q * reference.conjugate());
+}
+
+#endif  // POSE_FUSION__SO3_HPP_
@@ -0,0 +1,120 @@
+#ifndef POSE_FUSION__SOURCE_WATCHDOG_HPP_
+#define POSE_FUSION__SOURCE_WATCHDOG_HPP_
+
+#include "pose_fusion/timer_wheel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Receipt timeouts of the fusion inputs, all on one TimerWheel. Recording a receipt is a
+// single relaxed store and may happen on any thread; one owning thread runs check(),
+// which re-arms the timer of a source that received since it was armed (so the wheel is
+// not touched per message) and marks the others stale. A stale source is re-checked
+// every tick until it receives again. stale() may be read from any thread.
+class SourceWatchdog
+{
+public:
+    static constexpr int64_t kNever = std::numeric_limits<int64_t>::min();
+
+    // One timeout per source, <= 0: the source never goes stale. The tick is an eighth of
+    // the shortest timeout, at least 1 ms.
+    void configure(const std::vector<int64_t> &timeouts_ns)
+    {
+        sources_ = std::vector<Source>(timeouts_ns.size());
+        int64_t shortest_ns = std::numeric_limits<int64_t>::max();
+        for (std::size_t i = 0; i < timeouts_ns.size(); ++i)
+        {
+            sources_[i].timeout_ns = std::max<int64_t>(timeouts_ns[i], 0);
+            if (sources_[i].timeout_ns > 0)
+            {
+                shortest_ns = std::min(shortest_ns, sources_[i].timeout_ns);
+            }
+        }
+        enabled_ = shortest_ns != std::numeric_limits<int64_t>::max();
+        wheel_.configure(sources_.size(), enabled_ ? std::max<int64_t>(shortest_ns / 8, 1000000) : 1000000, kSlots);
+    }
+
+    bool enabled() const { return enabled_; }
+    std::size_t size() const { return sources_.size(); }
+    int64_t tick() const { return wheel_.tick(); }
+    int64_t timeout(std::size_t source) const { return sources_[source].timeout_ns; }
+
+    // Any thread
+    void receive(std::size_t source, int64_t now_ns) { sources_[source].receipt_ns.store(now_ns, std::memory_order_relaxed); }
+    bool stale(std::size_t source) const { return sources_[source].stale.load(std::memory_order_relaxed); }
+    // Receipt time of the latest message, kNever before the first one
+    int64_t receipt(std::size_t source) const { return sources_[source].receipt_ns.load(std::memory_order_relaxed); }
+    // Times the source went stale
+    uint64_t timeouts(std::size_t source) const { return sources_[source].timeouts.load(std::memory_order_relaxed); }
+
+    // Owning thread. The first call starts every timeout (a source that never sends goes
+    // stale one timeout later); transition(source, stale) is called on every change.
+    template <typename TransitionFn>
+    void check(int64_t now_ns, TransitionFn &&transition)
+    {
+        if (!enabled_)
+        {
+            return;
+        }
+        if (!wheel_.started())
+        {
+            wheel_.reset(now_ns);
+            for (std::size_t i = 0; i < sources_.size(); ++i)
+            {
+                if (sources_[i].timeout_ns > 0)
+                {
+                    wheel_.arm(i, now_ns + sources_[i].timeout_ns);
+                }
+            }
+            return;
+        }
+
+        wheel_.advance(now_ns, [&](std::size_t i)
+        {
+            Source &source = sources_[i];
+            // A receipt ahead of now (the clock jumped back) counts as received now
+            const int64_t receipt_ns = std::min(source.receipt_ns.load(std::memory_order_relaxed), now_ns);
+            const bool alive = receipt_ns != kNever && receipt_ns > now_ns - source.timeout_ns;
+            if (alive)
+            {
+                wheel_.arm(i, receipt_ns + source.timeout_ns);
+            }
+            else
+            {
+                wheel_.arm(i, now_ns + wheel_.tick());
+            }
+
+            if (alive == !source.stale.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            source.stale.store(!alive, std::memory_order_relaxed);
+            if (!alive)
+            {
+                source.timeouts.fetch_add(1, std::memory_order_relaxed);
+            }
+            transition(i, !alive);
+        });
+    }
+
+private:
+    static constexpr std::size_t kSlots = 64;
+
+    struct Source
+    {
+        int64_t timeout_ns = 0;
+        std::atomic<int64_t> receipt_ns{kNever};
+        std::atomic<bool> stale{false};
+        std::atomic<uint64_t> timeouts{0};
+    };
+
+    bool enabled_ = false;
+    std::vector<Source> sources_;
+    TimerWheel wheel_;
+};
+
+#endif  // POSE_FUSION__SOURCE_WATCHDOG_HPP_
@@ -0,0 +1,87 @@
+#ifndef POSE_FUSION__SPSC_QUEUE_HPP_
+#define POSE_FUSION__SPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free single-producer / single-consumer queue. The slots are allocated once
+// in the constructor; push and pop move an element in or out and publish it with one
+// release store, so neither side blocks or allocates. Each side keeps a cached copy of
+// the other side's index and only reloads it when the queue looks full or empty, so the
+// index cache lines are not shared per element. The producer (and the consumer) may
+// change threads as long as their calls are ordered, e.g. by an executor callback group.
+template <typename T>
+class SpscQueue
+{
+public:
+    // capacity is rounded up to a power of two, at least 2
+    explicit SpscQueue(std::size_t capacity = 2)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size *= 2;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    std::size_t capacity() const { return slots_.size(); }
+
+    // Producer. False (value untouched) when the queue is full.
+    bool tryPush(T &&value)
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size())
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size())
+            {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer. False when the queue is empty.
+    bool tryPop(T &value)
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_)
+        {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_)
+            {
+                return false;
+            }
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side; only a hint while the other side is running
+    bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    std::vector<T> slots_;
+    std::size_t mask_ = 1;
+
+    // Consumer side
+    alignas(kCacheLine) std::atomic<std::size_t> head_{0};
+    std::size_t cached_tail_ = 0;
+    // Producer side
+    alignas(kCacheLine) std::atomic<std::size_t> tail_{0};
+    std::size_t cached_head_ = 0;
+};
+
+#endif  // POSE_FUSION__SPSC_QUEUE_HPP_
@@ -0,0 +1,123 @@
+#ifndef POSE_FUSION__STAMPED_RING_BUFFER_HPP_
+#define POSE_FUSION__STAMPED_RING_BUFFER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-capacity history of time-stamped samples, ordered by stamp.
+// Storage is allocated once with the owning object; push() only copies into
+// an existing slot, so no heap allocation happens per message as long as T
+// itself does not allocate on copy (the geometry_msgs pose/twist types do not).
+template <typename T, std::size_t Capacity>
+class StampedRingBuffer
+{
+    static_assert(Capacity >= 2, "StampedRingBuffer needs room for at least two samples");
+
+public:
+    struct Entry
+    {
+        int64_t stamp_ns = 0;
+        T value{};
+    };
+
+    // Samples that are not newer than the current newest one are dropped so the
+    // buffer stays sorted; the oldest sample is overwritten once it is full.
+    bool push(int64_t stamp_ns, const T &value)
+    {
+        if (size_ > 0 && stamp_ns <= newest().stamp_ns)
+        {
+            return false;
+        }
+
+        Entry &slot = entries_[(head_ + size_) % Capacity];
+        slot.stamp_ns = stamp_ns;
+        slot.value = value;
+
+        if (size_ < Capacity)
+        {
+            ++size_;
+        }
+        else
+        {
+            head_ = (head_ + 1) % Capacity;
+        }
+        return true;
+    }
+
+    void clear()
+    {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    // 0 is the oldest sample, size() - 1 the newest.
+    const Entry &at(std::size_t i) const { return entries_[(head_ + i) % Capacity]; }
+    const Entry &newest() const { return at(size_ - 1); }
+    const Entry &oldest() const { return at(0); }
+
+    // Finds the pair of samples with before.stamp_ns <= stamp_ns <= after.stamp_ns.
+    // Both point to the same entry on an exact match.
+    bool bracket(int64_t stamp_ns, const Entry *&before, const Entry *&after) const
+    {
+        if (size_ == 0 || stamp_ns < oldest().stamp_ns || stamp_ns > newest().stamp_ns)
+        {
+            return false;
+        }
+
+        // Binary search for the first sample not older than stamp_ns
+        std::size_t lo = 0;
+        std::size_t hi = size_ - 1;
+        while (lo < hi)
+        {
+            const std::size_t mid = (lo + hi) / 2;
+            if (at(mid).stamp_ns < stamp_ns)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        after = &at(lo);
+        before = (after->stamp_ns == stamp_ns || lo == 0) ? after : &at(lo - 1);
+        return true;
+    }
+
+    // Sample closest to stamp_ns, or nullptr if none lies within max_offset_ns.
+    const Entry *nearest(int64_t stamp_ns, int64_t max_offset_ns) const
+    {
+        if (size_ == 0)
+        {
+            return nullptr;
+        }
+
+        const Entry *best = nullptr;
+        const Entry *before = nullptr;
+        const Entry *after = nullptr;
+        if (bracket(stamp_ns, before, after))
+        {
+            best = (stamp_ns - before->stamp_ns <= after->stamp_ns - stamp_ns) ? before : after;
+        }
+        else
+        {
+            best = stamp_ns < oldest().stamp_ns ? &oldest() : &newest();
+        }
+
+        const int64_t offset = best->stamp_ns > stamp_ns ? best->stamp_ns - stamp_ns : stamp_ns - best->stamp_ns;
+        return offset <= max_offset_ns ? best : nullptr;
+    }
+
+private:
+    std::array<Entry, Capacity> entries_{};
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+};
+
+#endif  // POSE_FUSION__STAMPED_RING_BUFFER_HPP_
@@ -0,0 +1,141 @@
+#ifndef POSE_FUSION__TIMER_WHEEL_HPP_
+#define POSE_FUSION__TIMER_WHEEL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Hashed timing wheel over a fixed set of timers addressed by index. A deadline hashes
+// into the slot of the first tick at or after it; each slot is an intrusive doubly linked list, so arm and
+// cancel are O(1) and advance only visits the slots whose tick passed. Deadlines more than
+// one revolution ahead stay in their slot until it comes round with the deadline due.
+// Times are non-negative nanoseconds; everything is allocated in configure. Not
+// thread-safe.
+class TimerWheel
+{
+public:
+    // slots is rounded up to a power of two, at least 2
+    void configure(std::size_t timers, int64_t tick_ns, std::size_t slots)
+    {
+        tick_ns_ = std::max<int64_t>(tick_ns, 1);
+        std::size_t size = 2;
+        while (size < slots)
+        {
+            size *= 2;
+        }
+        heads_.assign(size, kNone);
+        timers_.assign(timers, Timer());
+        started_ = false;
+    }
+
+    int64_t tick() const { return tick_ns_; }
+    bool started() const { return started_; }
+    bool armed(std::size_t id) const { return timers_[id].slot != kNone; }
+
+    // Cancels every timer; ticks up to now_ns count as visited
+    void reset(int64_t now_ns)
+    {
+        std::fill(heads_.begin(), heads_.end(), kNone);
+        for (Timer &timer : timers_)
+        {
+            timer.slot = kNone;
+        }
+        current_tick_ = now_ns / tick_ns_;
+        started_ = true;
+    }
+
+    // (Re)arms timer id. It goes into the slot of the first tick starting at or after the
+    // deadline, so it fires on the first visit after it is due; a deadline in a tick that
+    // was already visited fires on the next advance.
+    void arm(std::size_t id, int64_t deadline_ns)
+    {
+        cancel(id);
+        const int64_t tick = std::max((deadline_ns + tick_ns_ - 1) / tick_ns_, current_tick_ + 1);
+        const std::size_t slot = static_cast<std::size_t>(tick) & (heads_.size() - 1);
+
+        Timer &timer = timers_[id];
+        timer.deadline_ns = deadline_ns;
+        timer.slot = slot;
+        timer.previous = kNone;
+        timer.next = heads_[slot];
+        if (timer.next != kNone)
+        {
+            timers_[timer.next].previous = id;
+        }
+        heads_[slot] = id;
+    }
+
+    void cancel(std::size_t id)
+    {
+        Timer &timer = timers_[id];
+        if (timer.slot == kNone)
+        {
+            return;
+        }
+        if (timer.previous != kNone)
+        {
+            timers_[timer.previous].next = timer.next;
+        }
+        else
+        {
+            heads_[timer.slot] = timer.next;
+        }
+        if (timer.next != kNone)
+        {
+            timers_[timer.next].previous = timer.previous;
+        }
+        timer.slot = kNone;
+    }
+
+    // Calls expired(id) for every timer whose deadline is at or before now_ns; the timer is
+    // disarmed first, so expired may arm it again
+    template <typename ExpiredFn>
+    void advance(int64_t now_ns, ExpiredFn &&expired)
+    {
+        const int64_t target_tick = now_ns / tick_ns_;
+        if (target_tick <= current_tick_)
+        {
+            return;
+        }
+        // After a gap of more than one revolution every slot is visited once
+        const int64_t revolution = static_cast<int64_t>(heads_.size());
+        const int64_t first_tick = std::max(current_tick_ + 1, target_tick - revolution + 1);
+        current_tick_ = target_tick;
+
+        for (int64_t tick = first_tick; tick <= target_tick; ++tick)
+        {
+            std::size_t id = heads_[static_cast<std::size_t>(tick) & (heads_.size() - 1)];
+            while (id != kNone)
+            {
+                const std::size_t next = timers_[id].next;
+                if (timers_[id].deadline_ns <= now_ns)
+                {
+                    cancel(id);
+                    expired(id);
+                }
+                id = next;
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t kNone = std::numeric_limits<std::size_t>::max();
+
+    struct Timer
+    {
+        int64_t deadline_ns = 0;
+        std::size_t slot = kNone;  // kNone: not armed
+        std::size_t previous = kNone;
+        std::size_t next = kNone;
+    };
+
+    int64_t tick_ns_ = 1;
+    int64_t current_tick_ = 0;  // last tick whose slot was visited
+    bool started_ = false;
+    std::vector<std::size_t> heads_;
+    std::vector<Timer> timers_;
+};
+
+#endif  // POSE_FUSION__TIMER_WHEEL_HPP_
@@ -0,0 +1,23 @@
+#include "pose_fusion/pose_fusion_node.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <memory>
+
+// Standalone executable. The pose and twist callback groups only run in parallel on a
+// multi-threaded executor; the thread count comes from the executor_threads parameter.
+// The node configures and activates itself unless autostart is false.
+int main(int argc, char *argv[])
+{
+    rclcpp::init(argc, argv);
+
+    auto node = std::make_shared<PoseFusionNode>();
+    const int64_t threads = node->get_parameter("executor_threads").as_int();
+
+    rclcpp::executors::MultiThreadedExecutor executor(rclcpp::ExecutorOptions(), threads > 0 ? static_cast<size_t>(threads) : 0);
+    executor.add_node(node->get_node_base_interface());
+    executor.spin();
+
+    rclcpp::shutdown();
+    return 0;
+}
@@ -1,186 +1,1074 @@
-#include <rclcpp/rclcpp.hpp>
-#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
-#include <geometry_msgs/msg/twist_with_covariance_stamped.hpp>  // Updated to include TwistWithCovarianceStamped
-#include <tf2_ros/transform_broadcaster.h>
+#include "pose_fusion/pose_fusion_node.hpp"
+
+#include <rclcpp_components/register_node_macro.hpp>
 #include <tf2/LinearMath/Quaternion.h>
+#include <tf2_ros/qos.hpp>
 #include <Eigen/Dense>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <vector>
+
+namespace
+{
+
+int64_t toNanoseconds(const builtin_interfaces::msg::Time &stamp)
+{
+    return rclcpp::Time(stamp).nanoseconds();
+}
+
+}  // namespace
 
-class PoseFusionNode : public rclcpp::Node
+PoseFusionNode::PoseFusionNode(const rclcpp::NodeOptions &options)
+    : LifecycleNode("pose_fusion_node", options)
 {
-public:
-    PoseFusionNode()
-        : Node("pose_fusion_node")
+    // Thread count for the standalone executable's MultiThreadedExecutor (0: one per core)
+    this->declare_parameter<int>("executor_threads", 2);
+    // Configure and activate right away; false leaves the node unconfigured for a lifecycle
+    // manager or `ros2 lifecycle set` (staged bring-up)
+    const bool start_active = this->declare_parameter<bool>("autostart", true);
+    if (start_active)
     {
-        // Subscribers for LiDAR and GNSS pose
-        lidar_pose_sub_ = this->create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>(
-            "/localization/pose_with_covariance", 10,
-            std::bind(&PoseFusionNode::lidarPoseCallback, this, std::placeholders::_1));
+        autostart(*this);
+    }
+}
 
-        gnss_pose_sub_ = this->create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>(
-            "/fix_pose", 10,
-            std::bind(&PoseFusionNode::gnssPoseCallback, this, std::placeholders::_1));
+PoseFusionNode::~PoseFusionNode()
+{
+    // The estimate only stops changing once the fusion thread is gone
+    stopFusionThread();
+    if (write_state_)
+    {
+        write_state_();
+    }
+}
+
+LifecycleCallbackReturn PoseFusionNode::on_configure(const rclcpp_lifecycle::State &)
+{
+    PoseFusionConfig config;
 
-        // Subscribers for EKF and Filter twist (now TwistWithCovarianceStamped)
-        ekf_twist_sub_ = this->create_subscription<geometry_msgs::msg::TwistWithCovarianceStamped>(
-            "/localization/pose_twist_fusion_filter/twist_with_covariance", 10,
-            std::bind(&PoseFusionNode::ekfTwistCallback, this, std::placeholders::_1));
+    // Time synchronization of the input streams
+    const double sync_window = configuredParameter<double>(*this, "sync_window", 0.1);
+    const std::string sync_mode = configuredParameter<std::string>(*this, "sync_mode", "interpolate");
+    config.sync_window_ns = static_cast<int64_t>(sync_window * 1e9);
+    config.interpolate = sync_mode != "nearest";
+    if (sync_mode != "nearest" && sync_mode != "interpolate")
+    {
+        RCLCPP_WARN(this->get_logger(), "Unknown sync_mode '%s', using 'interpolate'", sync_mode.c_str());
+    }
+
+    // "information": inverse-covariance fusion, "weighted": fixed per-source weights,
+    // "ekf": poses feed an EKF driven by the fused twist (twists are fused in information form)
+    std::string fusion_mode = configuredParameter<std::string>(*this, "fusion_mode", "information");
+    if (fusion_mode != "weighted" && fusion_mode != "information" && fusion_mode != "ekf")
+    {
+        RCLCPP_WARN(this->get_logger(), "Unknown fusion_mode '%s', using 'information'", fusion_mode.c_str());
+        fusion_mode = "information";
+    }
 
-        filter_twist_sub_ = this->create_subscription<geometry_msgs::msg::TwistWithCovarianceStamped>(
-            "/fix_twist", 10,
-            std::bind(&PoseFusionNode::filterTwistCallback, this, std::placeholders::_1));
+    // Message type of both twist inputs: "twist_with_covariance" (TwistWithCovarianceStamped)
+    // or "twist" (TwistStamped, always fused with the fixed weights)
+    const std::string twist_input_type = configuredParameter<std::string>(*this, "twist_input_type", "twist_with_covariance");
+    if (twist_input_type != "twist_with_covariance" && twist_input_type != "twist")
+    {
+        RCLCPP_WARN(this->get_logger(), "Unknown twist_input_type '%s', using 'twist_with_covariance'", twist_input_type.c_str());
+    }
 
-        // Publisher for final fused pose and fused twist (now TwistWithCovarianceStamped)
-        final_pose_pub_ = this->create_publisher<geometry_msgs::msg::PoseWithCovarianceStamped>("/final/pose_with_covariance", 10);
-        fused_twist_pub_ = this->create_publisher<geometry_msgs::msg::TwistWithCovarianceStamped>("/fused_twist", 10);
+    // Fixed output rate of the fused pose and TF (0: publish whenever a pose is fused; the
+    // EKF always needs a rate). Replaces ekf_rate, which is still honoured when set.
+    double output_rate = configuredParameter<double>(*this, "output_rate_hz", 100.0);
+    const double ekf_rate = configuredParameter<double>(*this, "ekf_rate", 0.0);
+    if (ekf_rate > 0.0)
+    {
+        RCLCPP_WARN(this->get_logger(), "ekf_rate is deprecated, use output_rate_hz");
+        output_rate = ekf_rate;
+    }
+    if (fusion_mode == "ekf" && output_rate <= 0.0)
+    {
+        RCLCPP_WARN(this->get_logger(), "fusion_mode 'ekf' needs output_rate_hz > 0, using 100 Hz");
+        output_rate = 100.0;
+    }
+    const rclcpp::Duration output_period = rclcpp::Duration::from_seconds(output_rate > 0.0 ? 1.0 / output_rate : 0.0);
+    config.output_period_ns = output_period.nanoseconds();
+    // A tick more than output_deadline [s] after its grid time counts as late (0: half a period)
+    config.output_deadline_ns = static_cast<int64_t>(configuredParameter<double>(*this, "output_deadline", 0.0) * 1e9);
+    config.output_extrapolate = configuredParameter<bool>(*this, "output_extrapolate", true);
+    config.output_max_extrapolation_ns = static_cast<int64_t>(configuredParameter<double>(*this, "output_max_extrapolation", 0.5) * 1e9);
+    config.ekf_process_noise_position = configuredParameter<double>(*this, "ekf_process_noise_position", config.ekf_process_noise_position);
+    config.ekf_process_noise_orientation = configuredParameter<double>(*this, "ekf_process_noise_orientation", config.ekf_process_noise_orientation);
 
-        // Initialize the transform broadcaster
-        tf_broadcaster_ = std::make_shared<tf2_ros::TransformBroadcaster>(this);
+    // Chi-square gate of every pose against the current estimate (0: off). "reject" drops
+    // outliers, "downweight" inflates their covariance (rejects with fusion_mode "weighted").
+    config.gate_chi_square = configuredParameter<double>(*this, "gate_chi_square", 0.0);
+    const std::string gate_mode = configuredParameter<std::string>(*this, "gate_mode", "reject");
+    // Fused poses (unscheduled output) and twists are only published when they moved more
+    // than this in any component since the last published one (0: publish every fusion)
+    config.change_epsilon = configuredParameter<double>(*this, "change_epsilon", 0.0);
+    config.gate_downweight = gate_mode == "downweight";
+    if (gate_mode != "reject" && gate_mode != "downweight")
+    {
+        RCLCPP_WARN(this->get_logger(), "Unknown gate_mode '%s', using 'reject'", gate_mode.c_str());
     }
 
-private:
-    void lidarPoseCallback(const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr lidar_msg)
+    // Inputs: <kind>_sources lists the source names, sources.<name>.topic, .weight and
+    // .timeout configure each one. The defaults are the LiDAR/GNSS pair and the EKF/filter twists.
+    // A source without a message for its timeout [s] (default source_timeout, 0: never)
+    // drops out of fusion until it sends again.
+    const bool plain_twist = twist_input_type == "twist";
+    const double source_timeout = configuredParameter<double>(*this, "source_timeout", 1.0);
+    pose_sources_ = declareSources("pose", {"lidar", "gnss"}, {"/localization/pose_with_covariance", "/fix_pose"}, source_timeout,
+                                   config.pose_source_weights, config.pose_source_timeouts_ns);
+    twist_sources_ = declareSources("twist", {"ekf", "filter"},
+                                    {plain_twist ? "/localization/pose_twist_fusion_filter/twist"
+                                                 : "/localization/pose_twist_fusion_filter/twist_with_covariance",
+                                     "/fix_twist"},
+                                    source_timeout, config.twist_source_weights, config.twist_source_timeouts_ns);
+    requested_pose_weights_ = config.pose_source_weights;
+    requested_twist_weights_ = config.twist_source_weights;
+    pose_weights_.reset(requested_pose_weights_);
+    twist_weights_.reset(requested_twist_weights_);
+    // Sources that must have a sample at the fusion stamp (0: all)
+    config.min_pose_sources = static_cast<std::size_t>(std::max<int64_t>(configuredParameter<int64_t>(*this, "min_pose_sources", 0), 0));
+    config.min_twist_sources = static_cast<std::size_t>(std::max<int64_t>(configuredParameter<int64_t>(*this, "min_twist_sources", 0), 0));
+
+    // Fusion thread: the callbacks only queue the messages (queue_depth per source; a full
+    // queue drops the new message) for one dedicated thread that runs the engine, pinned to
+    // fusion_thread.cpu (-1: any) with SCHED_FIFO at fusion_thread.priority (0: SCHED_OTHER)
+    fusion_thread_enabled_ = configuredParameter<bool>(*this, "fusion_thread.enabled", false);
+    fusion_queue_depth_ = static_cast<std::size_t>(std::max<int64_t>(configuredParameter<int64_t>(*this, "fusion_thread.queue_depth", 16), 1));
+    fusion_thread_policy_.cpu = static_cast<int>(configuredParameter<int64_t>(*this, "fusion_thread.cpu", -1));
+    fusion_thread_policy_.priority = static_cast<int>(configuredParameter<int64_t>(*this, "fusion_thread.priority", 0));
+
+    pose_callback_group_ = this->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    twist_callback_group_ = this->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+
+    // Frames of the outputs; /fused_twist is a body twist, stamped with base_frame
+    const std::string map_frame = configuredParameter<std::string>(*this, "map_frame", "map");
+    const std::string odom_frame = configuredParameter<std::string>(*this, "odom_frame", "odom");
+    const std::string base_frame = configuredParameter<std::string>(*this, "base_frame", "base_link");
+
+    // Publishers of the fused pose and twist. The frame ids are set once here and never
+    // reassigned on the publish path.
+    geometry_msgs::msg::PoseWithCovarianceStamped pose_prototype;
+    pose_prototype.header.frame_id = map_frame;
+    final_pose_pub_ = MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped>(
+        *this, "/final/pose_with_covariance", declareQos(*this, "final_pose", rclcpp::QoS(10)), pose_prototype);
+
+    geometry_msgs::msg::TwistWithCovarianceStamped twist_prototype;
+    twist_prototype.header.frame_id = base_frame;
+    fused_twist_pub_ = MessagePublisher<geometry_msgs::msg::TwistWithCovarianceStamped>(
+        *this, "/fused_twist", declareQos(*this, "fused_twist", rclcpp::QoS(10)), twist_prototype);
+
+    // "single": map -> base_link, "batch": map -> odom + odom -> base_link in one /tf
+    // message, "none": no TF output (consumers only use /final/pose_with_covariance)
+    const std::string tf_mode = configuredParameter<std::string>(*this, "tf_mode", "single");
+    tf_mode_ = TfMode::kSingle;
+    if (tf_mode == "batch")
     {
-        last_lidar_msg_ = lidar_msg;
+        tf_mode_ = TfMode::kBatch;
+    }
+    else if (tf_mode == "none")
+    {
+        tf_mode_ = TfMode::kNone;
+    }
+    else if (tf_mode != "single")
+    {
+        RCLCPP_WARN(this->get_logger(), "Unknown tf_mode '%s', using 'single'", tf_mode.c_str());
+    }
 
-        if (last_gnss_msg_)
+    // Same topic and QoS as tf2_ros::TransformBroadcaster
+    if (tf_mode_ != TfMode::kNone)
+    {
+        tf2_msgs::msg::TFMessage tf_prototype;
+        if (tf_mode_ == TfMode::kBatch)
+        {
+            tf_prototype.transforms.resize(2);
+            tf_prototype.transforms[0].header.frame_id = map_frame;
+            tf_prototype.transforms[0].child_frame_id = odom_frame;
+            tf_prototype.transforms[1].header.frame_id = odom_frame;
+            tf_prototype.transforms[1].child_frame_id = base_frame;
+        }
+        else
         {
-            fusePoses();
+            tf_prototype.transforms.resize(1);
+            tf_prototype.transforms[0].header.frame_id = map_frame;
+            tf_prototype.transforms[0].child_frame_id = base_frame;
         }
+        tf_pub_ = MessagePublisher<tf2_msgs::msg::TFMessage>(*this, "/tf", tf2_ros::DynamicBroadcasterQoS(), tf_prototype);
     }
 
-    void gnssPoseCallback(const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr gnss_msg)
+    // Warm start: the last estimate is kept in a memory-mapped file ("": off) and restored
+    // unless it is older than state_max_age [s] of wall time (0: any age)
+    const std::string state_file = configuredParameter<std::string>(*this, "state_file", "");
+    const double state_write_period = configuredParameter<double>(*this, "state_write_period", 1.0);
+    state_max_age_ = configuredParameter<double>(*this, "state_max_age", 0.0);
+    if (!state_file.empty())
     {
-        last_gnss_msg_ = gnss_msg;
+        std::string error;
+        if (!state_file_.open(state_file, kStateVersion, error))
+        {
+            RCLCPP_WARN(this->get_logger(), "State file disabled: %s", error.c_str());
+        }
+    }
 
-        if (last_lidar_msg_)
+    latency_monitor_ = std::make_unique<LatencyMonitor>(*this);
+    for (Source &source : pose_sources_)
+    {
+        source.statistics = &latency_monitor_->addCallback(source.name + "_pose");
+        if (config.gate_chi_square > 0.0)
         {
-            fusePoses();
+            source.gated = &source.statistics->addCounter("gated");
+            source.downweighted = &source.statistics->addCounter("downweighted");
         }
+        if (config.change_epsilon > 0.0 && config.output_period_ns <= 0)
+        {
+            source.unchanged = &source.statistics->addCounter("unchanged");
+        }
+        if (fusion_thread_enabled_)
+        {
+            source.dropped = &source.statistics->addCounter("dropped");
+        }
+    }
+    for (Source &source : twist_sources_)
+    {
+        source.statistics = &latency_monitor_->addCallback(source.name + "_twist");
+        if (config.change_epsilon > 0.0)
+        {
+            source.unchanged = &source.statistics->addCounter("unchanged");
+        }
+        if (fusion_thread_enabled_)
+        {
+            source.dropped = &source.statistics->addCounter("dropped");
+        }
+    }
+
+    // The subscriptions and the output timer are bound to the selected engine instantiation
+    if (fusion_mode == "weighted")
+    {
+        startStrategy<WeightedFusion>(plain_twist, config, output_period);
+    }
+    else if (fusion_mode == "ekf")
+    {
+        startStrategy<EkfFusion>(plain_twist, config, output_period);
+    }
+    else
+    {
+        startStrategy<InformationFusion>(plain_twist, config, output_period);
     }
 
-    void ekfTwistCallback(const geometry_msgs::msg::TwistWithCovarianceStamped::SharedPtr ekf_twist_msg)
+    if (state_file_.isOpen() && state_write_period > 0.0)
     {
-        last_ekf_twist_msg_ = ekf_twist_msg;
+        state_timer_ = this->create_wall_timer(std::chrono::duration<double>(state_write_period),
+                                               fusion_thread_enabled_ ? std::function<void()>([this]() { requestFusion(kWriteState); })
+                                                                      : write_state_,
+                                               pose_callback_group_);
+    }
+    // Created running; they start with on_activate
+    setTimersRunning(false);
+
+    // Registered last, so the declarations above are not passed through it
+    parameter_callback_ = this->add_on_set_parameters_callback(
+        std::bind(&PoseFusionNode::onSetParameters, this, std::placeholders::_1));
+    return LifecycleCallbackReturn::SUCCESS;
+}
 
-        if (last_filter_twist_msg_)
+LifecycleCallbackReturn PoseFusionNode::on_activate(const rclcpp_lifecycle::State &)
+{
+    active_.store(true, std::memory_order_relaxed);
+    setTimersRunning(true);
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+LifecycleCallbackReturn PoseFusionNode::on_deactivate(const rclcpp_lifecycle::State &)
+{
+    active_.store(false, std::memory_order_relaxed);
+    setTimersRunning(false);
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+LifecycleCallbackReturn PoseFusionNode::on_cleanup(const rclcpp_lifecycle::State &)
+{
+    release();
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+LifecycleCallbackReturn PoseFusionNode::on_shutdown(const rclcpp_lifecycle::State &)
+{
+    active_.store(false, std::memory_order_relaxed);
+    release();
+    return LifecycleCallbackReturn::SUCCESS;
+}
+
+void PoseFusionNode::release()
+{
+    if (parameter_callback_)
+    {
+        this->remove_on_set_parameters_callback(parameter_callback_.get());
+        parameter_callback_.reset();
+    }
+
+    // As in the destructor: the estimate only stops changing once the fusion thread is gone
+    stopFusionThread();
+    fusion_stop_.store(false, std::memory_order_relaxed);
+    fusion_requests_.store(0, std::memory_order_relaxed);
+    if (write_state_)
+    {
+        write_state_();
+        write_state_ = nullptr;
+    }
+
+    state_timer_.reset();
+    output_timer_.reset();
+    watchdog_timer_.reset();
+    pose_subs_.clear();
+    twist_subs_.clear();
+    // The queues outlive their producers
+    fusion_inbox_.emplace<std::monostate>();
+    final_pose_pub_ = MessagePublisher<geometry_msgs::msg::PoseWithCovarianceStamped>();
+    fused_twist_pub_ = MessagePublisher<geometry_msgs::msg::TwistWithCovarianceStamped>();
+    tf_pub_ = MessagePublisher<tf2_msgs::msg::TFMessage>();
+
+    // The reporter reads the engine and the sources
+    latency_monitor_.reset();
+    output_statistics_ = nullptr;
+    output_late_ = nullptr;
+    output_skipped_ = nullptr;
+    output_stale_ = nullptr;
+    reported_stale_.clear();
+
+    engine_.emplace<std::monostate>();
+    state_file_.close();
+    written_revision_ = 0;
+    pose_sources_.clear();
+    twist_sources_.clear();
+    requested_pose_weights_.clear();
+    requested_twist_weights_.clear();
+    pose_callback_group_.reset();
+    twist_callback_group_.reset();
+}
+
+void PoseFusionNode::setTimersRunning(bool running)
+{
+    for (const rclcpp::TimerBase::SharedPtr &timer : {output_timer_, watchdog_timer_, state_timer_})
+    {
+        if (!timer)
         {
-            fuseTwists();
+            continue;
+        }
+        if (running)
+        {
+            timer->reset();
+        }
+        else
+        {
+            timer->cancel();
         }
     }
+}
 
-    void filterTwistCallback(const geometry_msgs::msg::TwistWithCovarianceStamped::SharedPtr filter_twist_msg)
+std::vector<PoseFusionNode::Source> PoseFusionNode::declareSources(const std::string &kind, const std::vector<std::string> &default_names,
+                                                                   const std::vector<std::string> &default_topics, double default_timeout,
+                                                                   std::vector<double> &weights, std::vector<int64_t> &timeouts_ns)
+{
+    const std::vector<std::string> names = configuredParameter<std::vector<std::string>>(*this, kind + "_sources", default_names);
+
+    std::vector<Source> sources;
+    weights.clear();
+    timeouts_ns.clear();
+    for (const std::string &name : names)
     {
-        last_filter_twist_msg_ = filter_twist_msg;
+        // Names are shared by pose and twist sources (sources.<name>.*); the pose sources are
+        // already read when the twist sources are
+        const auto same_name = [&name](const Source &source) { return source.name == name; };
+        if (std::any_of(sources.begin(), sources.end(), same_name) || std::any_of(pose_sources_.begin(), pose_sources_.end(), same_name))
+        {
+            RCLCPP_WARN(this->get_logger(), "Source name '%s' is used twice, ignoring %s source", name.c_str(), kind.c_str());
+            continue;
+        }
+        const std::string prefix = "sources." + name + ".";
 
-        if (last_ekf_twist_msg_)
+        const auto known = std::find(default_names.begin(), default_names.end(), name);
+        const std::string default_topic = known != default_names.end() ? default_topics[known - default_names.begin()] : "";
+        const std::string topic = configuredParameter<std::string>(*this, prefix + "topic", default_topic);
+        // Equal weights by default; normalised over the sources of each fusion
+        const double weight = configuredParameter<double>(*this, prefix + "weight", 1.0);
+        const double timeout = configuredParameter<double>(*this, prefix + "timeout", default_timeout);
+        if (topic.empty())
         {
-            fuseTwists();
+            RCLCPP_WARN(this->get_logger(), "%s source '%s' has no %stopic, ignoring it", kind.c_str(), name.c_str(), prefix.c_str());
+            continue;
         }
+        sources.push_back({name, topic, nullptr});
+        weights.push_back(weight);
+        timeouts_ns.push_back(static_cast<int64_t>(timeout * 1e9));
     }
 
-    void fusePoses()
+    if (sources.empty())
     {
-        Eigen::Vector3d lidar_pos(last_lidar_msg_->pose.pose.position.x, last_lidar_msg_->pose.pose.position.y, last_lidar_msg_->pose.pose.position.z);
-        Eigen::Vector3d gnss_pos(last_gnss_msg_->pose.pose.position.x, last_gnss_msg_->pose.pose.position.y, last_gnss_msg_->pose.pose.position.z);
+        RCLCPP_WARN(this->get_logger(), "No %s sources configured", kind.c_str());
+    }
+    return sources;
+}
 
-        geometry_msgs::msg::PoseWithCovarianceStamped fused_pose;
-        fused_pose.header.stamp = this->now();
-        fused_pose.header.frame_id = "map";
+rcl_interfaces::msg::SetParametersResult PoseFusionNode::onSetParameters(const std::vector<rclcpp::Parameter> &parameters)
+{
+    const std::string prefix = "sources.";
+    const std::string suffix = ".weight";
+    const auto slot = [](const std::vector<Source> &sources, const std::string &name)
+    {
+        return std::find_if(sources.begin(), sources.end(), [&name](const Source &source) { return source.name == name; }) - sources.begin();
+    };
 
-        fused_pose.pose.pose.position.x = lidar_weight_ * lidar_pos.x() + gnss_weight_ * gnss_pos.x();
-        fused_pose.pose.pose.position.y = lidar_weight_ * lidar_pos.y() + gnss_weight_ * gnss_pos.y();
-        fused_pose.pose.pose.position.z = lidar_weight_ * lidar_pos.z() + gnss_weight_ * gnss_pos.z();
+    rcl_interfaces::msg::SetParametersResult result;
+    result.successful = true;
+    std::vector<double> pose_weights = requested_pose_weights_;
+    std::vector<double> twist_weights = requested_twist_weights_;
+    bool pose_changed = false;
+    bool twist_changed = false;
+    for (const rclcpp::Parameter &parameter : parameters)
+    {
+        const std::string &name = parameter.get_name();
+        if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+        {
+            continue;
+        }
+        const std::string source = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+        if (parameter.get_type() != rclcpp::ParameterType::PARAMETER_DOUBLE || !std::isfinite(parameter.as_double()) ||
+            parameter.as_double() < 0.0)
+        {
+            result.successful = false;
+            result.reason = name + " must be a finite number >= 0";
+            return result;
+        }
 
-        fused_pose.pose.pose.orientation = last_lidar_msg_->pose.pose.orientation;
+        // A name belongs to at most one pose or one twist source (see declareSources)
+        const double weight = parameter.as_double();
+        const auto pose_slot = slot(pose_sources_, source);
+        const auto twist_slot = slot(twist_sources_, source);
+        if (pose_slot < static_cast<std::ptrdiff_t>(pose_sources_.size()))
+        {
+            pose_weights[pose_slot] = weight;
+            pose_changed = true;
+        }
+        else if (twist_slot < static_cast<std::ptrdiff_t>(twist_sources_.size()))
+        {
+            twist_weights[twist_slot] = weight;
+            twist_changed = true;
+        }
+    }
 
-        for (size_t i = 0; i < 36; ++i)
+    // All changes of one request reach each side together, and only once all of them are valid
+    if (pose_changed)
+    {
+        requested_pose_weights_ = pose_weights;
+        pose_weights_.publish(requested_pose_weights_);
+        RCLCPP_INFO(this->get_logger(), "Updated the pose source weights");
+    }
+    if (twist_changed)
+    {
+        requested_twist_weights_ = twist_weights;
+        twist_weights_.publish(requested_twist_weights_);
+        RCLCPP_INFO(this->get_logger(), "Updated the twist source weights");
+    }
+    return result;
+}
+
+template <typename Strategy>
+void PoseFusionNode::startStrategy(bool plain_twist, const PoseFusionConfig &config, const rclcpp::Duration &output_period)
+{
+    if (plain_twist)
+    {
+        start<PoseFusionEngine<Strategy, PlainTwistSample>>(config, output_period);
+    }
+    else
+    {
+        start<PoseFusionEngine<Strategy>>(config, output_period);
+    }
+}
+
+template <typename EngineT>
+void PoseFusionNode::start(const PoseFusionConfig &config, const rclcpp::Duration &output_period)
+{
+    using PoseMessage = geometry_msgs::msg::PoseWithCovarianceStamped;
+    using TwistMessage = typename StampedTwist<typename EngineT::TwistInput>::Message;
+    using Inbox = FusionInbox<TwistMessage>;
+
+    EngineT &engine = engine_.emplace<EngineT>(config);
+    if (state_file_.isOpen())
+    {
+        restoreState(engine);
+        write_state_ = [this, &engine]() { writeState(engine); };
+    }
+
+    // With the fusion thread the subscriptions push into the inbox instead of calling the engine
+    Inbox *inbox = fusion_thread_enabled_ ? &fusion_inbox_.emplace<Inbox>() : nullptr;
+
+    rclcpp::SubscriptionOptions pose_options;
+    pose_options.callback_group = pose_callback_group_;
+    rclcpp::SubscriptionOptions twist_options;
+    twist_options.callback_group = twist_callback_group_;
+
+    // QoS of every topic can be overridden through the qos.<topic key>.* parameters, the
+    // key of a source is <name>_pose / <name>_twist
+    pose_subs_.clear();
+    for (std::size_t i = 0; i < pose_sources_.size(); ++i)
+    {
+        const Source &source = pose_sources_[i];
+        const rclcpp::QoS qos = declareQos(*this, source.name + "_pose", rclcpp::QoS(10));
+        if (inbox)
         {
-            fused_pose.pose.covariance[i] = lidar_weight_ * last_lidar_msg_->pose.covariance[i] +
-                                            gnss_weight_ * last_gnss_msg_->pose.covariance[i];
+            auto &queue = inbox->pose.emplace_back(fusion_queue_depth_);
+            pose_subs_.push_back(this->create_subscription<PoseMessage>(
+                source.topic, qos,
+                std::bind(&PoseFusionNode::queueMessage<PoseMessage>, this, std::ref(queue), std::cref(source), std::placeholders::_1),
+                pose_options));
+            continue;
         }
+        pose_subs_.push_back(this->create_subscription<PoseMessage>(
+            source.topic, qos,
+            std::bind(&PoseFusionNode::poseCallback<EngineT>, this, std::ref(engine), i, std::cref(source), std::placeholders::_1),
+            pose_options));
+    }
 
-        final_pose_pub_->publish(fused_pose);
+    // Twist sources (TwistWithCovarianceStamped or TwistStamped)
+    twist_subs_.clear();
+    for (std::size_t i = 0; i < twist_sources_.size(); ++i)
+    {
+        const Source &source = twist_sources_[i];
+        const rclcpp::QoS qos = declareQos(*this, source.name + "_twist", rclcpp::QoS(10));
+        if (inbox)
+        {
+            auto &queue = inbox->twist.emplace_back(fusion_queue_depth_);
+            twist_subs_.push_back(this->create_subscription<TwistMessage>(
+                source.topic, qos,
+                std::bind(&PoseFusionNode::queueMessage<TwistMessage>, this, std::ref(queue), std::cref(source), std::placeholders::_1),
+                twist_options));
+            continue;
+        }
+        twist_subs_.push_back(this->create_subscription<TwistMessage>(
+            source.topic, qos,
+            std::bind(&PoseFusionNode::twistCallback<EngineT>, this, std::ref(engine), i, std::cref(source), std::placeholders::_1),
+            twist_options));
+    }
+
+    // Output comes from a fixed-rate timer on the node clock, decoupled from sensor arrival
+    if (engine.scheduledOutput())
+    {
+        output_statistics_ = &latency_monitor_->addCallback("output");
+        output_late_ = &output_statistics_->addCounter("deadline_missed");
+        output_skipped_ = &output_statistics_->addCounter("skipped");
+        output_stale_ = &output_statistics_->addCounter("stale");
 
-        // Broadcast the transform
-        broadcastTransform(fused_pose);
+        output_timer_ = rclcpp::create_timer(this, this->get_clock(), output_period,
+                                             inbox ? std::function<void()>([this]() { requestFusion(kOutputDue); })
+                                                   : std::function<void()>(std::bind(&PoseFusionNode::publishOutput<EngineT>, this, std::ref(engine))),
+                                             pose_callback_group_);
     }
 
-    void fuseTwists()
+    // Source timeouts: one timer wheel in the engine, run by the pose group (pose callbacks,
+    // output timer, or a timer at the wheel tick when the output is unscheduled)
+    if (engine.watchdog().enabled())
     {
-        geometry_msgs::msg::TwistWithCovarianceStamped fused_twist;
-        fused_twist.header.stamp = this->now();
-        fused_twist.header.frame_id = "map";  // Adjust frame_id as needed
+        reported_stale_.assign(engine.watchdog().size(), false);
+        latency_monitor_->addStatus("sources", [this, &engine](diagnostic_msgs::msg::DiagnosticStatus &status)
+                                    { reportSources(engine, status); });
+        if (!engine.scheduledOutput())
+        {
+            watchdog_timer_ = rclcpp::create_timer(this, this->get_clock(), rclcpp::Duration(std::chrono::nanoseconds(engine.watchdog().tick())),
+                                                   [this, &engine, inbox]()
+                                                   {
+                                                       if (inbox)
+                                                       {
+                                                           requestFusion(kCheckSources);
+                                                           return;
+                                                       }
+                                                       engine.checkSources(this->now().nanoseconds());
+                                                   },
+                                                   pose_callback_group_);
+        }
+    }
 
-        // Linear twist values (assuming no linear motion in this context)
-        fused_twist.twist.twist.linear.x = 0.0;
-        fused_twist.twist.twist.linear.y = 0.0;
-        fused_twist.twist.twist.linear.z = 0.0;
+    if (inbox)
+    {
+        fusion_thread_ = std::thread(&PoseFusionNode::runFusionThread<EngineT, Inbox>, this, std::ref(engine), std::ref(*inbox));
+        // Shows up under this name in top / perf and the stress harness CPU report
+        pthread_setname_np(fusion_thread_.native_handle(), "pose_fusion_rt");
+        std::string error;
+        if (!applyThreadPolicy(fusion_thread_, fusion_thread_policy_, error))
+        {
+            RCLCPP_WARN(this->get_logger(), "Fusion thread runs without its policy: %s", error.c_str());
+        }
+        RCLCPP_INFO(this->get_logger(), "Fusing on a dedicated thread (queue depth %zu, cpu %d, priority %d)", fusion_queue_depth_,
+                    fusion_thread_policy_.cpu, fusion_thread_policy_.priority);
+    }
+}
 
-        // Angular twist: Z component
-        fused_twist.twist.twist.angular.x = 0.0;
-        fused_twist.twist.twist.angular.y = 0.0;
-        fused_twist.twist.twist.angular.z = ekf_twist_weight_ * last_ekf_twist_msg_->twist.twist.angular.z + 
-                                            filter_twist_weight_ * last_filter_twist_msg_->twist.twist.angular.z;
+template <typename EngineT>
+void PoseFusionNode::poseCallback(EngineT &engine, std::size_t slot, const Source &source,
+                                  const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr pose_msg)
+{
+    if (!active_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    processPose(engine, slot, source, *pose_msg, this->now().nanoseconds());
+}
+
+template <typename EngineT>
+void PoseFusionNode::twistCallback(EngineT &engine, std::size_t slot, const Source &source,
+                                   const typename StampedTwist<typename EngineT::TwistInput>::Message::ConstSharedPtr twist_msg)
+{
+    if (!active_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    processTwist(engine, slot, source, *twist_msg, this->now().nanoseconds());
+}
 
-        // Covariance fusion (simple weighted sum of covariances)
-        for (size_t i = 0; i < 36; ++i)
+template <typename EngineT>
+void PoseFusionNode::processPose(EngineT &engine, std::size_t slot, const Source &source,
+                                 const geometry_msgs::msg::PoseWithCovarianceStamped &pose_msg, int64_t receipt_ns)
+{
+    ScopedCallbackTimer timer(*source.statistics);
+    PoseUpdate update;
+    {
+        AllocationGuard no_allocation;
+        if (pose_weights_.update())
+        {
+            engine.setPoseSourceWeights(pose_weights_.current());
+        }
+        update = engine.addPose(slot, toNanoseconds(pose_msg.header.stamp), pose_msg.pose, receipt_ns);
+    }
+    if (update.gated)
+    {
+        source.gated->add();
+    }
+    if (update.downweighted)
+    {
+        source.downweighted->add();
+    }
+    handlePoseUpdate(engine, update, source);
+}
+
+template <typename EngineT>
+void PoseFusionNode::processTwist(EngineT &engine, std::size_t slot, const Source &source,
+                                  const typename StampedTwist<typename EngineT::TwistInput>::Message &twist_msg, int64_t receipt_ns)
+{
+    ScopedCallbackTimer timer(*source.statistics);
+    TwistUpdate update;
+    {
+        AllocationGuard no_allocation;
+        if (twist_weights_.update())
         {
-            fused_twist.twist.covariance[i] = ekf_twist_weight_ * last_ekf_twist_msg_->twist.covariance[i] + 
-                                              filter_twist_weight_ * last_filter_twist_msg_->twist.covariance[i];
+            engine.setTwistSourceWeights(twist_weights_.current());
         }
+        update = engine.addTwist(slot, toNanoseconds(twist_msg.header.stamp), twist_msg.twist, receipt_ns);
+    }
+    handleTwistUpdate(engine, update, source);
+}
+
+template <typename MessageT>
+void PoseFusionNode::queueMessage(SpscQueue<QueuedMessage<MessageT>> &queue, const Source &source,
+                                  const typename MessageT::ConstSharedPtr message)
+{
+    if (!active_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    AllocationGuard no_allocation;
+    if (!queue.tryPush(QueuedMessage<MessageT>{message, this->now().nanoseconds()}))
+    {
+        source.dropped->add();
+        return;
+    }
+    fusion_wakeup_.notify();
+}
+
+void PoseFusionNode::requestFusion(uint32_t request)
+{
+    fusion_requests_.fetch_or(request, std::memory_order_release);
+    fusion_wakeup_.notify();
+}
+
+template <typename EngineT, typename InboxT>
+void PoseFusionNode::runFusionThread(EngineT &engine, InboxT &inbox)
+{
+    // Without a timer request the thread still looks at the queues this often
+    constexpr std::chrono::milliseconds kIdleTimeout(100);
+
+    const auto has_work = [this, &inbox]()
+    {
+        const auto nonempty = [](const auto &queue) { return !queue.empty(); };
+        return fusion_stop_.load(std::memory_order_acquire) || fusion_requests_.load(std::memory_order_acquire) != 0 ||
+               std::any_of(inbox.pose.begin(), inbox.pose.end(), nonempty) || std::any_of(inbox.twist.begin(), inbox.twist.end(), nonempty);
+    };
+
+    QueuedMessage<geometry_msgs::msg::PoseWithCovarianceStamped> pose;
+    QueuedMessage<typename StampedTwist<typename EngineT::TwistInput>::Message> twist;
+    while (!fusion_stop_.load(std::memory_order_acquire))
+    {
+        // At most one queue length per source and pass, so one busy source cannot starve the
+        // others. Twists first: a pose fused in the same pass extrapolates with the newest twist.
+        for (std::size_t i = 0; i < inbox.twist.size(); ++i)
+        {
+            for (std::size_t n = inbox.twist[i].capacity(); n > 0 && inbox.twist[i].tryPop(twist); --n)
+            {
+                processTwist(engine, i, twist_sources_[i], *twist.message, twist.receipt_ns);
+                twist.message.reset();
+            }
+        }
+        for (std::size_t i = 0; i < inbox.pose.size(); ++i)
+        {
+            for (std::size_t n = inbox.pose[i].capacity(); n > 0 && inbox.pose[i].tryPop(pose); --n)
+            {
+                processPose(engine, i, pose_sources_[i], *pose.message, pose.receipt_ns);
+                pose.message.reset();
+            }
+        }
+
+        const uint32_t requests = fusion_requests_.exchange(0, std::memory_order_acquire);
+        if ((requests & kCheckSources) != 0)
+        {
+            engine.checkSources(this->now().nanoseconds());
+        }
+        if ((requests & kOutputDue) != 0)
+        {
+            publishOutput(engine);
+        }
+        if ((requests & kWriteState) != 0)
+        {
+            writeState(engine);
+        }
+
+        fusion_wakeup_.wait(kIdleTimeout, has_work);
+    }
+}
+
+void PoseFusionNode::stopFusionThread()
+{
+    if (!fusion_thread_.joinable())
+    {
+        return;
+    }
+    fusion_stop_.store(true, std::memory_order_release);
+    fusion_wakeup_.notify();
+    fusion_thread_.join();
+}
+
+template <typename EngineT>
+void PoseFusionNode::handlePoseUpdate(EngineT &engine, const PoseUpdate &update, const Source &trigger)
+{
+    if (update.ekf_rejected)
+    {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000, "EKF innovation covariance is singular, measurement skipped");
+    }
+    if (update.ekf_late)
+    {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                             "Pose older than the EKF state by more than sync_window, measurement dropped");
+    }
+    if (update.fallback)
+    {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                             "Pose covariance is not positive definite, falling back to weighted fusion");
+    }
+
+    // The output timer publishes the latest fused pose
+    if (!update.fused || engine.scheduledOutput())
+    {
+        return;
+    }
+    if (!update.changed)
+    {
+        trigger.unchanged->add();
+        return;
+    }
+
+    final_pose_pub_.publish([&](geometry_msgs::msg::PoseWithCovarianceStamped &fused_pose)
+    {
+        fused_pose.header.stamp = rclcpp::Time(update.stamp_ns, this->get_clock()->get_clock_type());
+        fused_pose.pose = engine.fusedPose();
+
+        // Broadcast the transform before handing the message over to the publisher
+        broadcastTransform(engine, fused_pose);
+
+        latency_monitor_->recordAge(*trigger.statistics, fused_pose.header.stamp);
+        return true;
+    });
+}
 
-        fused_twist_pub_->publish(fused_twist);
+template <typename EngineT>
+void PoseFusionNode::handleTwistUpdate(EngineT &engine, const TwistUpdate &update, const Source &trigger)
+{
+    if (update.fallback)
+    {
+        RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000,
+                             "Twist covariance is not positive definite, falling back to weighted fusion");
+    }
+    if (!update.fused)
+    {
+        return;
+    }
+    if (!update.changed)
+    {
+        trigger.unchanged->add();
+        return;
     }
 
-    void broadcastTransform(const geometry_msgs::msg::PoseWithCovarianceStamped &fused_pose)
+    fused_twist_pub_.publish([&](geometry_msgs::msg::TwistWithCovarianceStamped &fused_twist)
     {
-        geometry_msgs::msg::TransformStamped transformStamped;
+        fused_twist.header.stamp = rclcpp::Time(update.stamp_ns, this->get_clock()->get_clock_type());
+        fused_twist.twist = engine.fusedTwist();
 
-        transformStamped.header.stamp = fused_pose.header.stamp;
-        transformStamped.header.frame_id = "map";  // Adjust this to the correct reference frame as needed
-        transformStamped.child_frame_id = "base_link";
+        latency_monitor_->recordAge(*trigger.statistics, fused_twist.header.stamp);
+        return true;
+    });
+}
 
-        transformStamped.transform.translation.x = fused_pose.pose.pose.position.x;
-        transformStamped.transform.translation.y = fused_pose.pose.pose.position.y;
-        transformStamped.transform.translation.z = fused_pose.pose.pose.position.z;
+template <typename EngineT>
+void PoseFusionNode::publishOutput(EngineT &engine)
+{
+    ScopedCallbackTimer timer(*output_statistics_);
 
-        transformStamped.transform.rotation.x = fused_pose.pose.pose.orientation.x;
-        transformStamped.transform.rotation.y = fused_pose.pose.pose.orientation.y;
-        transformStamped.transform.rotation.z = fused_pose.pose.pose.orientation.z;
-        transformStamped.transform.rotation.w = fused_pose.pose.pose.orientation.w;
+    StateVector state;
+    StateMatrix covariance;
+    OutputResult output;
+    {
+        AllocationGuard no_allocation;
+        output = engine.output(this->now().nanoseconds(), state, covariance);
+    }
+    if (!output.tick.due)
+    {
+        return;
+    }
+    if (output.tick.skipped > 0)
+    {
+        output_skipped_->add(output.tick.skipped);
+    }
+    if (output.tick.late)
+    {
+        output_late_->add();
+    }
+    if (output.stale)
+    {
+        output_stale_->add();
+    }
+    if (!output.valid)
+    {
+        return;
+    }
 
-        // Broadcast the transform
-        tf_broadcaster_->sendTransform(transformStamped);
+    publishPoseState(engine, output.tick.stamp_ns, state, covariance);
+    if constexpr (!EngineT::usesEkf())
+    {
+        output_statistics_->recordAge(output.age_ns);
     }
+}
 
-    rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr lidar_pose_sub_;
-    rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr gnss_pose_sub_;
-    rclcpp::Subscription<geometry_msgs::msg::TwistWithCovarianceStamped>::SharedPtr ekf_twist_sub_;
-    rclcpp::Subscription<geometry_msgs::msg::TwistWithCovarianceStamped>::SharedPtr filter_twist_sub_;
-    rclcpp::Publisher<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr final_pose_pub_;
-    rclcpp::Publisher<geometry_msgs::msg::TwistWithCovarianceStamped>::SharedPtr fused_twist_pub_;
+template <typename EngineT>
+void PoseFusionNode::publishPoseState(EngineT &engine, int64_t stamp_ns, const StateVector &state, const StateMatrix &covariance)
+{
+    final_pose_pub_.publish([&](geometry_msgs::msg::PoseWithCovarianceStamped &fused_pose)
+    {
+        fused_pose.header.stamp = rclcpp::Time(stamp_ns, this->get_clock()->get_clock_type());
+        statePose(state, fused_pose.pose.pose);
+        covarianceMap(fused_pose.pose.covariance) = covariance;
 
-    std::shared_ptr<tf2_ros::TransformBroadcaster> tf_broadcaster_;
+        broadcastTransform(engine, fused_pose);
+        return true;
+    });
+}
 
-    geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr last_lidar_msg_;
-    geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr last_gnss_msg_;
-    geometry_msgs::msg::TwistWithCovarianceStamped::SharedPtr last_ekf_twist_msg_;
-    geometry_msgs::msg::TwistWithCovarianceStamped::SharedPtr last_filter_twist_msg_;
+template <typename EngineT>
+void PoseFusionNode::restoreState(EngineT &engine)
+{
+    PersistedState persisted;
+    if (!state_file_.load(persisted))
+    {
+        RCLCPP_INFO(this->get_logger(), "No saved state, starting cold");
+        return;
+    }
+    const int64_t wall_now_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const double age = static_cast<double>(wall_now_ns - persisted.wall_time_ns) * 1e-9;
+    if (state_max_age_ > 0.0 && age > state_max_age_)
+    {
+        RCLCPP_INFO(this->get_logger(), "Saved state is %.0f s old, starting cold", age);
+        return;
+    }
+
+    PoseSample pose;
+    pose.pose.position.x = persisted.pose[0];
+    pose.pose.position.y = persisted.pose[1];
+    pose.pose.position.z = persisted.pose[2];
+    pose.pose.orientation.x = persisted.pose[3];
+    pose.pose.orientation.y = persisted.pose[4];
+    pose.pose.orientation.z = persisted.pose[5];
+    pose.pose.orientation.w = persisted.pose[6];
+    pose.covariance = persisted.covariance;
 
-    double lidar_weight_ = 0.5; // Weight for LiDAR data
-    double gnss_weight_ = 0.5;  // Weight for GNSS data
-    double ekf_twist_weight_ = 0.5; // Weight for EKF twist data
-    double filter_twist_weight_ = 0.5; // Weight for Filter twist data
-};
+    const int64_t now_ns = this->now().nanoseconds();
+    engine.restore(pose, now_ns);
+    written_revision_ = engine.estimateRevision();
+    RCLCPP_INFO(this->get_logger(), "Restored the estimate saved %.0f s ago at (%.2f, %.2f, %.2f)", age, persisted.pose[0],
+                persisted.pose[1], persisted.pose[2]);
 
-int main(int argc, char *argv[])
+    if (!engine.scheduledOutput())
+    {
+        publishPoseState(engine, now_ns, poseState(pose.pose), covarianceMap(pose.covariance));
+    }
+}
+
+template <typename EngineT>
+void PoseFusionNode::writeState(EngineT &engine)
 {
-    rclcpp::init(argc, argv);
-    rclcpp::spin(std::make_shared<PoseFusionNode>());
-    rclcpp::shutdown();
-    return 0;
+    PoseSample pose;
+    if (engine.restored() || engine.estimateRevision() == written_revision_ || !engine.estimate(pose))
+    {
+        return;
+    }
+    written_revision_ = engine.estimateRevision();
+
+    PersistedState persisted;
+    persisted.wall_time_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    persisted.pose = {pose.pose.position.x, pose.pose.position.y, pose.pose.position.z, pose.pose.orientation.x,
+                      pose.pose.orientation.y, pose.pose.orientation.z, pose.pose.orientation.w};
+    persisted.covariance = pose.covariance;
+    state_file_.store(persisted);
 }
+
+template <typename EngineT>
+void PoseFusionNode::reportSources(const EngineT &engine, diagnostic_msgs::msg::DiagnosticStatus &status)
+{
+    const SourceWatchdog &watchdog = engine.watchdog();
+    const int64_t now_ns = this->now().nanoseconds();
+    std::string stale_names;
+    for (std::size_t i = 0; i < watchdog.size(); ++i)
+    {
+        const bool pose = i < pose_sources_.size();
+        const Source &source = pose ? pose_sources_[i] : twist_sources_[i - pose_sources_.size()];
+        const std::string key = source.name + (pose ? "_pose" : "_twist");
+        const bool stale = watchdog.stale(i);
+        if (stale != reported_stale_[i])
+        {
+            if (stale)
+            {
+                RCLCPP_WARN(this->get_logger(), "No %s on %s for %.2f s, fusing without it", key.c_str(), source.topic.c_str(),
+                            static_cast<double>(watchdog.timeout(i)) * 1e-9);
+            }
+            else
+            {
+                RCLCPP_INFO(this->get_logger(), "%s on %s is back", key.c_str(), source.topic.c_str());
+            }
+            reported_stale_[i] = stale;
+        }
+        if (stale)
+        {
+            stale_names += (stale_names.empty() ? "" : ", ") + key;
+        }
+
+        diagnostic_msgs::msg::KeyValue state;
+        state.key = key;
+        state.value = watchdog.timeout(i) <= 0 ? "no timeout" : stale ? "stale" : "ok";
+        status.values.push_back(state);
+        diagnostic_msgs::msg::KeyValue timeouts;
+        timeouts.key = key + "_timeouts_total";
+        timeouts.value = std::to_string(watchdog.timeouts(i));
+        status.values.push_back(timeouts);
+        const int64_t receipt_ns = watchdog.receipt(i);
+        if (receipt_ns != SourceWatchdog::kNever)
+        {
+            char age[32];
+            std::snprintf(age, sizeof(age), "%.1f", static_cast<double>(now_ns - receipt_ns) / 1e6);
+            diagnostic_msgs::msg::KeyValue receipt_age;
+            receipt_age.key = key + "_age_ms";
+            receipt_age.value = age;
+            status.values.push_back(receipt_age);
+        }
+    }
+
+    const SourceHealth health = engine.health();
+    if (!pose_sources_.empty() && health.stale_pose_sources == pose_sources_.size())
+    {
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::ERROR;
+        status.message = "no pose source: " + stale_names;
+    }
+    else if (health.degraded())
+    {
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+        status.message = "degraded, stale: " + stale_names;
+    }
+    else
+    {
+        status.message = "all sources ok";
+    }
+}
+
+template <typename EngineT>
+void PoseFusionNode::broadcastTransform(EngineT &engine, const geometry_msgs::msg::PoseWithCovarianceStamped &fused_pose)
+{
+    if (tf_mode_ == TfMode::kNone)
+    {
+        return;
+    }
+
+    if (tf_mode_ == TfMode::kSingle)
+    {
+        tf_pub_.publish([&fused_pose](tf2_msgs::msg::TFMessage &tf_message)
+        {
+            geometry_msgs::msg::TransformStamped &transformStamped = tf_message.transforms[0];
+
+            transformStamped.header.stamp = fused_pose.header.stamp;
+
+            transformStamped.transform.translation.x = fused_pose.pose.pose.position.x;
+            transformStamped.transform.translation.y = fused_pose.pose.pose.position.y;
+            transformStamped.transform.translation.z = fused_pose.pose.pose.position.z;
+
+            transformStamped.transform.rotation = fused_pose.pose.pose.orientation;
+            return true;
+        });
+        return;
+    }
+
+    // Batch: map -> odom = map -> base_link * (odom -> base_link)^-1, odom -> base_link
+    // dead-reckoned from the fused twist
+    const StateVector &odom_state = engine.advanceOdometry(rclcpp::Time(fused_pose.header.stamp).nanoseconds());
+
+    const Eigen::Isometry3d map_to_odom = mapToOdom(fused_pose.pose.pose, odom_state);
+    const Eigen::Quaterniond map_to_odom_rotation(map_to_odom.rotation());
+    const Eigen::Quaterniond odom_to_base_rotation = PoseTwistModel::quaternion(odom_state);
+
+    tf_pub_.publish([&](tf2_msgs::msg::TFMessage &tf_message)
+    {
+        geometry_msgs::msg::TransformStamped &map_odom = tf_message.transforms[0];
+        map_odom.header.stamp = fused_pose.header.stamp;
+        map_odom.transform.translation.x = map_to_odom.translation().x();
+        map_odom.transform.translation.y = map_to_odom.translation().y();
+        map_odom.transform.translation.z = map_to_odom.translation().z();
+        map_odom.transform.rotation.x = map_to_odom_rotation.x();
+        map_odom.transform.rotation.y = map_to_odom_rotation.y();
+        map_odom.transform.rotation.z = map_to_odom_rotation.z();
+        map_odom.transform.rotation.w = map_to_odom_rotation.w();
+
+        geometry_msgs::msg::TransformStamped &odom_base = tf_message.transforms[1];
+        odom_base.header.stamp = fused_pose.header.stamp;
+        odom_base.transform.translation.x = odom_state(0);
+        odom_base.transform.translation.y = odom_state(1);
+        odom_base.transform.translation.z = odom_state(2);
+        odom_base.transform.rotation.x = odom_to_base_rotation.x();
+        odom_base.transform.rotation.y = odom_to_base_rotation.y();
+        odom_base.transform.rotation.z = odom_to_base_rotation.z();
+        odom_base.transform.rotation.w = odom_to_base_rotation.w();
+        return true;
+    });
+}
+
+RCLCPP_COMPONENTS_REGISTER_NODE(PoseFusionNode)